@@ -0,0 +1,113 @@
+#ifndef ADJACENCYLIST_H
+#define ADJACENCYLIST_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+namespace gen {
+
+/*
+    Read-only view of a contiguous run of indices. Supports range-based for
+    loops and indexing.
+*/
+class IndexRange {
+public:
+    IndexRange() : _first(nullptr), _last(nullptr) {}
+    IndexRange(const int *first, const int *last) : _first(first), _last(last) {}
+
+    inline const int* begin() const {
+        return _first;
+    }
+
+    inline const int* end() const {
+        return _last;
+    }
+
+    inline int size() const {
+        return (int)(_last - _first);
+    }
+
+    inline bool empty() const {
+        return _first == _last;
+    }
+
+    inline int operator[](int i) const {
+        return _first[i];
+    }
+
+private:
+    const int *_first;
+    const int *_last;
+};
+
+/*
+    Compressed sparse row adjacency table. The entries of row i are stored
+    contiguously in indices[offsets[i]] to indices[offsets[i + 1] - 1], so
+    the whole table is two allocations regardless of the number of rows.
+
+    Rows are appended in order with push() followed by endRow().
+*/
+class AdjacencyList {
+public:
+    AdjacencyList() : offsets(1, 0) {}
+
+    void reserve(int numRows, int numEntries) {
+        offsets.reserve(numRows + 1);
+        indices.reserve(numEntries);
+    }
+
+    inline void push(int idx) {
+        indices.push_back(idx);
+    }
+
+    inline void endRow() {
+        offsets.push_back((int)indices.size());
+    }
+
+    void addRow(const std::vector<int> &row) {
+        indices.insert(indices.end(), row.begin(), row.end());
+        endRow();
+    }
+
+    inline int size() const {
+        return (int)offsets.size() - 1;
+    }
+
+    inline int entryCount() const {
+        return (int)indices.size();
+    }
+
+    inline int degree(int i) const {
+        _checkRow(i);
+        return offsets[i + 1] - offsets[i];
+    }
+
+    inline IndexRange operator[](int i) const {
+        _checkRow(i);
+        const int *data = indices.data();
+        return IndexRange(data + offsets[i], data + offsets[i + 1]);
+    }
+
+    size_t getMemoryUsage() const {
+        return offsets.capacity() * sizeof(int) + indices.capacity() * sizeof(int);
+    }
+
+    std::vector<int> offsets;
+    std::vector<int> indices;
+
+private:
+    inline void _checkRow(int i) const {
+#ifndef NDEBUG
+        if (i < 0 || i >= size()) {
+            throw std::range_error("Row out of range: " + std::to_string(i));
+        }
+#endif
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+import os
+import math
+import random
+import struct
+
+# Generates bluenoisetiles.bin, a set of periodically tileable Poisson disc
+# point sets on the unit square.
+#
+# File layout (little endian):
+#     char[4]   magic "BNTS"
+#     uint32    version
+#     uint32    tile count
+#     for each tile:
+#         float64   minimum toroidal distance between points
+#         uint32    point count
+#         uint16[2] point coordinates in units of 1/65536 (repeated)
+
+FILE_MAGIC = b"BNTS"
+FILE_VERSION = 1
+NUM_TILES = 8
+TILE_RADIUS = 1.0 / 64.0
+K_VALUE = 30
+RANDOM_SEED = 7919
+
+def toroidal_distance_sq(p, q):
+	dx = abs(p[0] - q[0])
+	dy = abs(p[1] - q[1])
+	dx = min(dx, 1.0 - dx)
+	dy = min(dy, 1.0 - dy)
+	return dx*dx + dy*dy
+
+def generate_tile(r, k, rng):
+	# Bridson's algorithm on the unit torus
+	dx = r / math.sqrt(2)
+	n = int(math.ceil(1.0 / dx))
+	grid = [-1] * (n*n)
+
+	def cell(p):
+		return int(p[0] * n) % n, int(p[1] * n) % n
+
+	def is_valid(p):
+		ci, cj = cell(p)
+		if grid[ci + cj*n] != -1:
+			return False
+		for j in range(cj - 2, cj + 3):
+			for i in range(ci - 2, ci + 3):
+				sid = grid[(i % n) + (j % n)*n]
+				if sid != -1 and toroidal_distance_sq(p, points[sid]) < r*r:
+					return False
+		return True
+
+	def add(p):
+		ci, cj = cell(p)
+		grid[ci + cj*n] = len(points)
+		points.append(p)
+		active.append(len(points) - 1)
+
+	points = []
+	active = []
+	add((rng.random(), rng.random()))
+	while active:
+		randidx = rng.randrange(len(active))
+		center = points[active[randidx]]
+		found = False
+		for _ in range(k):
+			angle = rng.uniform(0, 2*math.pi)
+			dist = rng.uniform(r, 2*r)
+			p = ((center[0] + math.sin(angle)*dist) % 1.0,
+			     (center[1] + math.cos(angle)*dist) % 1.0)
+			if is_valid(p):
+				add(p)
+				found = True
+				break
+		if not found:
+			active[randidx] = active[-1]
+			active.pop()
+
+	return points
+
+def quantize(points):
+	qpoints = []
+	for p in points:
+		qx = min(int(round(p[0] * 65536.0)), 65535)
+		qy = min(int(round(p[1] * 65536.0)), 65535)
+		qpoints.append((qx, qy))
+	return qpoints
+
+def min_distance(qpoints, r):
+	# Spacing after quantization, checked over a coarse toroidal grid
+	pts = [(q[0] / 65536.0, q[1] / 65536.0) for q in qpoints]
+	n = int(1.0 / (2*r))
+	cells = {}
+	for idx, p in enumerate(pts):
+		cells.setdefault((int(p[0]*n) % n, int(p[1]*n) % n), []).append(idx)
+
+	mindsq = float("inf")
+	for idx, p in enumerate(pts):
+		ci, cj = int(p[0]*n) % n, int(p[1]*n) % n
+		for j in range(cj - 1, cj + 2):
+			for i in range(ci - 1, ci + 2):
+				for o in cells.get((i % n, j % n), []):
+					if o != idx:
+						mindsq = min(mindsq, toroidal_distance_sq(p, pts[o]))
+	return math.sqrt(mindsq)
+
+def updatetiles():
+	dir_path = os.path.dirname(os.path.realpath(__file__))
+	rng = random.Random(RANDOM_SEED)
+
+	data = bytearray()
+	data += FILE_MAGIC
+	data += struct.pack("<II", FILE_VERSION, NUM_TILES)
+	for _ in range(NUM_TILES):
+		qpoints = quantize(generate_tile(TILE_RADIUS, K_VALUE, rng))
+		data += struct.pack("<dI", min_distance(qpoints, TILE_RADIUS), len(qpoints))
+		for q in qpoints:
+			data += struct.pack("<HH", q[0], q[1])
+
+	write_path = os.path.join(dir_path, "bluenoisetiles.bin")
+	with open(write_path, 'wb') as outfile:
+		outfile.write(data)
+
+if __name__ == "__main__":
+	updatetiles()
@@ -0,0 +1,120 @@
+#include "cacheutil.h"
+
+#include <errno.h>
+#include <atomic>
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__MACOSX)
+    #define CACHEUTIL_POSIX
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <sys/file.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <direct.h>
+    #include <process.h>
+    #include <windows.h>
+#endif
+
+std::string CacheUtil::getPath(std::string directory, std::string name) {
+    if (directory.empty()) {
+        return name;
+    }
+
+    char last = directory[directory.size() - 1];
+    if (last == '/' || last == '\\') {
+        return directory + name;
+    }
+    return directory + "/" + name;
+}
+
+bool CacheUtil::createDirectory(std::string directory) {
+#if defined(CACHEUTIL_POSIX)
+    struct stat st;
+    if (stat(directory.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return mkdir(directory.c_str(), 0755) == 0;
+#elif defined(_WIN32)
+    _mkdir(directory.c_str());
+    return true;
+#else
+    return true;
+#endif
+}
+
+uint64_t CacheUtil::hashBytes(const void *data, size_t size, uint64_t hash) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string CacheUtil::getTempPath(std::string path) {
+    static std::atomic<unsigned long long> counter(0);
+
+#if defined(CACHEUTIL_POSIX)
+    unsigned long long pid = (unsigned long long)getpid();
+#elif defined(_WIN32)
+    unsigned long long pid = (unsigned long long)_getpid();
+#else
+    unsigned long long pid = 0;
+#endif
+
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%llu.%llu.tmp", pid, counter++);
+    return path + suffix;
+}
+
+CacheUtil::FileLock::FileLock(std::string path) {
+#if defined(CACHEUTIL_POSIX)
+    _fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (_fd == -1) {
+        return;
+    }
+
+    int result;
+    do {
+        result = flock(_fd, LOCK_EX);
+    } while (result == -1 && errno == EINTR);
+    _isLocked = result == 0;
+#elif defined(_WIN32)
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    _handle = handle;
+
+    OVERLAPPED overlapped = {};
+    _isLocked = LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0,
+                           MAXDWORD, MAXDWORD, &overlapped) != 0;
+#else
+    _isLocked = true;
+#endif
+}
+
+CacheUtil::FileLock::~FileLock() {
+#if defined(CACHEUTIL_POSIX)
+    if (_fd != -1) {
+        if (_isLocked) {
+            flock(_fd, LOCK_UN);
+        }
+        close(_fd);
+    }
+#elif defined(_WIN32)
+    if (_handle != nullptr) {
+        if (_isLocked) {
+            OVERLAPPED overlapped = {};
+            UnlockFileEx((HANDLE)_handle, 0, MAXDWORD, MAXDWORD, &overlapped);
+        }
+        CloseHandle((HANDLE)_handle);
+    }
+#endif
+}
+
+bool CacheUtil::FileLock::isLocked() const {
+    return _isLocked;
+}
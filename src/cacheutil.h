@@ -0,0 +1,58 @@
+#ifndef CACHEUTIL_H
+#define CACHEUTIL_H
+
+#include <stdio.h>
+#include <string>
+#include <stdint.h>
+
+/*
+    File helpers shared by the on-disk caches (MeshCache and the NoiseField
+    cache)
+*/
+namespace CacheUtil {
+
+// Initial value for hashBytes
+const uint64_t hashSeed = 14695981039346656037ULL;
+
+// Path of the file name in directory
+std::string getPath(std::string directory, std::string name);
+
+// Create directory if it does not exist. Returns false if it cannot be
+// created or is not a directory.
+bool createDirectory(std::string directory);
+
+// 64-bit FNV-1a hash of size bytes, continuing from hash
+uint64_t hashBytes(const void *data, size_t size, uint64_t hash);
+
+// Temporary file name next to path that is unique to this process and
+// call, so that processes sharing a cache never write the same file
+std::string getTempPath(std::string path);
+
+/*
+    Exclusive advisory lock on the file at path (flock, or LockFileEx on
+    Windows), held until the lock is destroyed. The file is created if it
+    does not exist. The constructor blocks until the lock is acquired, and
+    isLocked() is false if the file could not be opened or locked.
+*/
+class FileLock {
+public:
+    FileLock(std::string path);
+    ~FileLock();
+
+    bool isLocked() const;
+
+private:
+    FileLock(const FileLock &);
+    FileLock& operator=(const FileLock &);
+
+    bool _isLocked = false;
+#if defined(_WIN32)
+    void *_handle = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+}
+
+#endif
@@ -5,11 +5,24 @@ namespace config {
 
 unsigned int seed = 0;
 double resolution = 0.08;
+std::string samplerType = "bridson";
+std::string triangulatorType = "sweephull";
+std::string meshLayout = "full";
+int numThreads = 0;
+std::string simdType = "auto";
+std::string meshCacheDirectory = "";
+int meshCacheSize = 1024;
+std::string noiseFieldType = "exact";
+std::string noiseCacheDirectory = "";
 std::string outfileExt = ".png";
 std::string outfile = "output" + outfileExt;
 std::string voronoiFile = "";
 std::string heightMapFile = "";
 std::string instructionFile = "";
+bool watchInstructions = false;
+int checkpointInterval = 0;
+double checkpointTime = 0.0;
+std::string checkpointFile = "";
 double erosionAmount = -1.0;
 int erosionIterations = 3;
 int numCities = -1;
@@ -47,9 +60,22 @@ bool parseOptions(int argc, char **argv) {
         opts.seed         = arg_strn("s", "seed", "<uint>", 0, 1, "set random generator seed"),
         opts.timeseed     = arg_litn(NULL, "timeseed", 0, 1, "set seed from system time"),
         opts.resolution   = arg_dbln("r", "resolution", "<float>", 0, 1, "level of map detail"),
+        opts.sampler      = arg_strn(NULL, "sampler", "<bridson|tiled|tileset>", 0, 1, "set poisson disc sampling method"),
+        opts.triangulator = arg_strn(NULL, "triangulator", "<sweephull|incremental>", 0, 1, "set delaunay triangulation method"),
+        opts.meshlayout   = arg_strn(NULL, "mesh-layout", "<full|compact>", 0, 1, "store twin and prev half-edges or derive them to use less memory (default: full)"),
+        opts.threads      = arg_intn(NULL, "threads", "<int>", 0, 1, "number of worker threads (default: all cores)"),
+        opts.simd         = arg_strn(NULL, "simd", "<auto|avx2|sse4|scalar>", 0, 1, "limit the instruction set used by the height map and noise kernels"),
+        opts.meshcache    = arg_filen(NULL, "mesh-cache", "<dir>", 0, 1, "load and store generated voronoi meshes in a cache directory"),
+        opts.meshcachesize = arg_intn(NULL, "mesh-cache-size", "<MB>", 0, 1, "maximum size of the mesh cache (default: 1024)"),
+        opts.noisefield   = arg_strn(NULL, "noise-field", "<exact|bilinear|bicubic>", 0, 1, "evaluate noise exactly or sample it from a grid baked at the map resolution (default: exact)"),
+        opts.noisecache   = arg_filen(NULL, "noise-cache", "<dir>", 0, 1, "load and store baked noise fields in a cache directory"),
         opts.outfile      = arg_filen("o", "output", "filename", 0, 1, "output file"),
         opts.output       = arg_filen(NULL, NULL, "<file>", 0, 1, "output file"),
         opts.instructionfile = arg_filen(NULL, "instruction-input", "<file>", 0, 1, "specifies a map instruction jsom file to generate map alterations"),
+        opts.watch        = arg_litn(NULL, "watch", 0, 1, "keep running and regenerate the map when the instruction input file changes"),
+        opts.checkpointinterval = arg_intn(NULL, "checkpoint-interval", "<int>", 0, 1, "save the height map every n instructions (default: 16 in watch mode)"),
+        opts.checkpointtime = arg_dbln(NULL, "checkpoint-time", "<ms>", 0, 1, "save the height map after this much instruction work (default: 250 in watch mode)"),
+        opts.checkpointfile = arg_filen(NULL, "checkpoint-file", "<file>", 0, 1, "store height map checkpoints in a file instead of in memory"),
         opts.voronoifile = arg_filen(NULL, "voronoi-input", "<file>", 0, 1, "specifies a voronoi input file to generate the map from" ),
         opts.heightmapfile = arg_filen(NULL, "heightmap-input", "<file>", 0, 1, "specifies a heightmap input to generate the map from (requires voronoi input as well)"),
         opts.voronoicreation = arg_litn(NULL, "create-voronoi", 0, 1, "enable creation of voronoi input file"),
@@ -141,6 +167,13 @@ bool _displayDrawSupportInfo(arg_lit *drawinfo) {
 bool _setOptions(OptionArgs opts) {
     if (!_setSeed(opts.timeseed, opts.seed)) { return false; }
     if (!_setResolution(opts.resolution)) { return false; }
+    if (!_setSamplerType(opts.sampler)) { return false; }
+    if (!_setTriangulatorType(opts.triangulator)) { return false; }
+    if (!_setMeshLayout(opts.meshlayout)) { return false; }
+    if (!_setNumThreads(opts.threads)) { return false; }
+    if (!_setSimdType(opts.simd)) { return false; }
+    if (!_setMeshCache(opts.meshcache, opts.meshcachesize)) { return false; }
+    if (!_setNoiseField(opts.noisefield, opts.noisecache)) { return false; }
     if (!_setOutputFile(opts.outfile, opts.output)) { return false; }
     if (!_enableVoronoiCreation(opts.voronoicreation)) { return false; }
     if (!_enableHeightmapCreation(opts.heightmapcreation)) { return false; }
@@ -148,6 +181,8 @@ bool _setOptions(OptionArgs opts) {
     if (!_setVoronoiInput(opts.voronoifile)) { return false; }
     if (!_setHeightmapInput(opts.heightmapfile)) { return false; }
     if (!_setInstructionInput(opts.instructionfile)) { return false; }
+    if (!_setWatchMode(opts.watch, opts.checkpointinterval, 
+                       opts.checkpointtime, opts.checkpointfile)) { return false; }
     if (!_setErosionAmount(opts.eroamount)) { return false; }
     if (!_setErosionIterations(opts.erosteps)) { return false; }
     if (!_setNumCities(opts.ncities)) { return false; }
@@ -198,6 +233,133 @@ bool _setResolution(arg_dbl *res) {
     return true;
 }
 
+bool _setSamplerType(arg_str *sampler) {
+    if (sampler->count == 0) {
+        return true;
+    }
+
+    std::string type(sampler->sval[0]);
+    if (type != "bridson" && type != "tiled" && type != "tileset") {
+        std::cout << "error: sampler must be one of <bridson|tiled|tileset>." << std::endl; 
+        std::cout << "sampler: " << type << std::endl;
+        return false;
+    }
+
+    gen::config::samplerType = type;
+
+    return true;
+}
+
+bool _setTriangulatorType(arg_str *triangulator) {
+    if (triangulator->count == 0) {
+        return true;
+    }
+
+    std::string type(triangulator->sval[0]);
+    if (type != "sweephull" && type != "incremental") {
+        std::cout << "error: triangulator must be one of <sweephull|incremental>." << std::endl; 
+        std::cout << "triangulator: " << type << std::endl;
+        return false;
+    }
+
+    gen::config::triangulatorType = type;
+
+    return true;
+}
+
+bool _setMeshLayout(arg_str *meshlayout) {
+    if (meshlayout->count == 0) {
+        return true;
+    }
+
+    std::string layout(meshlayout->sval[0]);
+    if (layout != "full" && layout != "compact") {
+        std::cout << "error: mesh layout must be one of <full|compact>." << std::endl; 
+        std::cout << "mesh layout: " << layout << std::endl;
+        return false;
+    }
+
+    gen::config::meshLayout = layout;
+
+    return true;
+}
+
+bool _setNumThreads(arg_int *threads) {
+    if (threads->count == 0) {
+        return true;
+    }
+
+    int n = threads->ival[0];
+    if (n <= 0) {
+        std::cout << "error: number of threads must be greater than zero." << std::endl; 
+        std::cout << "number of threads: " << n << std::endl;
+        return false;
+    }
+
+    gen::config::numThreads = n;
+
+    return true;
+}
+
+bool _setSimdType(arg_str *simd) {
+    if (simd->count == 0) {
+        return true;
+    }
+
+    std::string type(simd->sval[0]);
+    if (type != "auto" && type != "avx2" && type != "sse4" && type != "scalar") {
+        std::cout << "error: simd must be one of <auto|avx2|sse4|scalar>." << std::endl; 
+        std::cout << "simd: " << type << std::endl;
+        return false;
+    }
+
+    gen::config::simdType = type;
+
+    return true;
+}
+
+bool _setMeshCache(arg_file *meshcache, arg_int *meshcachesize) {
+    if (meshcache->count > 0) {
+        gen::config::meshCacheDirectory = meshcache->filename[0];
+    }
+
+    if (meshcachesize->count == 0) {
+        return true;
+    }
+
+    int size = meshcachesize->ival[0];
+    if (size <= 0) {
+        std::cout << "error: mesh cache size must be greater than zero." << std::endl; 
+        std::cout << "mesh cache size: " << size << std::endl;
+        return false;
+    }
+
+    gen::config::meshCacheSize = size;
+
+    return true;
+}
+
+bool _setNoiseField(arg_str *noisefield, arg_file *noisecache) {
+    if (noisecache->count > 0) {
+        gen::config::noiseCacheDirectory = noisecache->filename[0];
+    }
+
+    if (noisefield->count == 0) {
+        return true;
+    }
+
+    std::string type(noisefield->sval[0]);
+    if (type != "exact" && type != "bilinear" && type != "bicubic") {
+        std::cout << "error: noise field must be one of <exact|bilinear|bicubic>." << std::endl; 
+        std::cout << "noise field: " << type << std::endl;
+        return false;
+    }
+
+    gen::config::noiseFieldType = type;
+
+    return true;
+}
+
 bool _setOutputFile(arg_file *outfile1, arg_file *outfile2) {
     if (outfile1->count > 0) {
         gen::config::outfile = outfile1->filename[0];
@@ -234,6 +396,45 @@ bool _setInstructionInput(arg_file *instructionfile) {
     return true;
 }
 
+bool _setWatchMode(arg_lit *watch, arg_int *checkpointinterval,
+                   arg_dbl *checkpointtime, arg_file *checkpointfile) {
+    if (watch->count > 0) {
+        if (gen::config::instructionFile == "" || gen::config::voronoiFile == "") {
+            std::cout << "error: watch mode requires an instruction input and a voronoi input file." << std::endl;
+            return false;
+        }
+        gen::config::watchInstructions = true;
+        gen::config::checkpointInterval = 16;
+        gen::config::checkpointTime = 250.0;
+    }
+
+    if (checkpointinterval->count > 0) {
+        int n = checkpointinterval->ival[0];
+        if (n < 0) {
+            std::cout << "error: checkpoint interval must be greater than or equal to zero." << std::endl; 
+            std::cout << "checkpoint interval: " << n << std::endl;
+            return false;
+        }
+        gen::config::checkpointInterval = n;
+    }
+
+    if (checkpointtime->count > 0) {
+        double t = checkpointtime->dval[0];
+        if (t < 0.0) {
+            std::cout << "error: checkpoint time must be greater than or equal to zero." << std::endl; 
+            std::cout << "checkpoint time: " << t << std::endl;
+            return false;
+        }
+        gen::config::checkpointTime = t;
+    }
+
+    if (checkpointfile->count > 0) {
+        gen::config::checkpointFile = checkpointfile->filename[0];
+    }
+
+    return true;
+}
+
 bool _enableHeightmapCreation(arg_lit *enableheightmapcreation) {
     if (enableheightmapcreation->count > 0) {
         gen::config::heightmapCreation = true;
@@ -15,6 +15,15 @@ struct OptionArgs {
 	struct arg_lit *timeseed;
 	struct arg_str *seed;
 	struct arg_dbl *resolution;
+    struct arg_str *sampler;
+    struct arg_str *triangulator;
+    struct arg_str *meshlayout;
+    struct arg_int *threads;
+    struct arg_str *simd;
+    struct arg_file *meshcache;
+    struct arg_int *meshcachesize;
+    struct arg_str *noisefield;
+    struct arg_file *noisecache;
 	struct arg_file *outfile;
 	struct arg_file *output;
     struct arg_lit *voronoicreation;
@@ -23,6 +32,10 @@ struct OptionArgs {
     struct arg_file *voronoifile;
     struct arg_file *heightmapfile;
     struct arg_file *instructionfile;
+    struct arg_lit *watch;
+    struct arg_int *checkpointinterval;
+    struct arg_dbl *checkpointtime;
+    struct arg_file *checkpointfile;
     struct arg_dbl *eroamount;
     struct arg_int *erosteps;
     struct arg_dbl *mapscale;
@@ -47,6 +60,15 @@ struct OptionArgs {
 
 extern unsigned int seed;
 extern double resolution;
+extern std::string samplerType;
+extern std::string triangulatorType;
+extern std::string meshLayout;
+extern int numThreads;
+extern std::string simdType;
+extern std::string meshCacheDirectory;
+extern int meshCacheSize;
+extern std::string noiseFieldType;
+extern std::string noiseCacheDirectory;
 extern std::string outfileExt;
 extern std::string outfile;
 extern double erosionAmount;
@@ -65,6 +87,10 @@ extern bool instructionCreation;
 extern std::string voronoiFile;
 extern std::string heightMapFile;
 extern std::string instructionFile;
+extern bool watchInstructions;
+extern int checkpointInterval;
+extern double checkpointTime;
+extern std::string checkpointFile;
 extern bool randomGeneration;
 extern bool enableSlopes;
 extern bool enableRivers;
@@ -91,6 +117,13 @@ bool _displayDrawSupportInfo(arg_lit *drawinfo);
 bool _setOptions(OptionArgs opts);
 bool _setSeed(arg_lit *timeseed, arg_str *seed);
 bool _setResolution(arg_dbl *res);
+bool _setSamplerType(arg_str *sampler);
+bool _setTriangulatorType(arg_str *triangulator);
+bool _setMeshLayout(arg_str *meshlayout);
+bool _setNumThreads(arg_int *threads);
+bool _setSimdType(arg_str *simd);
+bool _setMeshCache(arg_file *meshcache, arg_int *meshcachesize);
+bool _setNoiseField(arg_str *noisefield, arg_file *noisecache);
 bool _setOutputFile(arg_file *outfile1, arg_file *outfile2);
 bool _setErosionAmount(arg_dbl *amount);
 bool _setErosionIterations(arg_int *iterations);
@@ -106,6 +139,8 @@ bool _enableInstructionCreation(arg_lit *instructioncreation);
 bool _setVoronoiInput(arg_file *voronoifile);
 bool _setHeightmapInput(arg_file *heightmapfile);
 bool _setInstructionInput(arg_file *instructionfile);
+bool _setWatchMode(arg_lit *watch, arg_int *checkpointinterval,
+                   arg_dbl *checkpointtime, arg_file *checkpointfile);
 bool _enableRandomGeneration(arg_lit *generaterandom);
 bool _disableSlopes(arg_lit *noslopes);
 bool _disableRivers(arg_lit *norivers);
@@ -6,13 +6,26 @@ dcel::DCEL Delaunay::triangulate(std::vector<dcel::Point> &points) {
     }
 
     DCEL T = _initTriangulation(points);
+    _sortInsertionOrder(points);
+
+    // Consecutive points are close together, so each walk starts from
+    // a face incident to the previously inserted vertex
+    Face start = T.faces[0];
     while (!points.empty()) {
         Point p = points.back();
         points.pop_back();
 
-        Face f = _locateTriangleAtPoint(p, T);
-        if (f.id.ref != -1) {
-            _insertPointIntoTriangulation(p, f, T);
+        Face f = _locateTriangleAtPoint(p, start, T);
+        if (f.id.ref == -1) {
+            continue;
+        }
+
+        unsigned int numVertices = T.vertices.size();
+        _insertPointIntoTriangulation(p, f, T);
+        if (T.vertices.size() > numVertices) {
+            start = T.incidentFace(T.incidentEdge(T.vertices.back()));
+        } else {
+            start = f;
         }
     }
 
@@ -123,114 +136,138 @@ dcel::DCEL Delaunay::_initTriangulation(std::vector<dcel::Point> &points) {
     return T;
 }
 
-// Choose a random triangle, walk toward p until the containing 
-// triangle is found.
-dcel::Face Delaunay::_locateTriangleAtPoint(dcel::Point &p, dcel::DCEL &T) {
-    Ref randfidx(rand() % T.faces.size());
-    Face f = T.getFace(randfidx);
+/*
+    Reorder points by biased randomized insertion order (BRIO). Each point
+    is assigned to a round where round k holds roughly half of the points
+    of round k-1, and points within a round are sorted along a Hilbert
+    curve. The smallest round is stored at the back of the vector so that
+    it is popped and inserted first.
+*/
+void Delaunay::_sortInsertionOrder(std::vector<dcel::Point> &points) {
+    if (points.size() < 2) {
+        return;
+    }
+
+    double minx = points[0].x;
+    double miny = points[0].y;
+    double maxx = minx;
+    double maxy = miny;
+    for (unsigned int i = 0; i < points.size(); i++) {
+        Point p = points[i];
+        if (p.x < minx) { minx = p.x; }
+        if (p.y < miny) { miny = p.y; }
+        if (p.x > maxx) { maxx = p.x; }
+        if (p.y > maxy) { maxy = p.y; }
+    }
+
+    double gridmax = 65535.0;
+    double size = fmax(maxx - minx, maxy - miny);
+    double scale = size > 0.0 ? gridmax / size : 0.0;
 
-    int count = 0;
-    int maxcount = (int)(2.0*sqrt(T.faces.size()));
+    // Sort key: round in the high bits, Hilbert index in the low 32 bits.
+    // Round 0 is the largest and is inserted last.
+    int maxRound = 31;
+    std::vector<std::pair<uint64_t, int> > keys;
+    keys.reserve(points.size());
+    for (unsigned int i = 0; i < points.size(); i++) {
+        int round = 0;
+        while (round < maxRound && rand() % 2 == 0) {
+            round++;
+        }
 
-    int faceHistory[3] = {-1, -1, -1};
-    HalfEdge h;
-    Point p0;
-    for (;;) {
-        if (_isPointInsideTriangle(p, f, T)) {
-            return f;
+        uint32_t hx = (uint32_t)fmin((points[i].x - minx) * scale, gridmax);
+        uint32_t hy = (uint32_t)fmin((points[i].y - miny) * scale, gridmax);
+        uint64_t key = ((uint64_t)round << 32) | _getHilbertIndex(hx, hy);
+        keys.push_back(std::pair<uint64_t, int>(key, i));
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Point> sorted;
+    sorted.reserve(points.size());
+    for (unsigned int i = 0; i < keys.size(); i++) {
+        sorted.push_back(points[keys[i].second]);
+    }
+    points.swap(sorted);
+}
+
+// Position of (x, y) along a Hilbert curve filling a 2^16 x 2^16 grid
+uint64_t Delaunay::_getHilbertIndex(uint32_t x, uint32_t y) {
+    uint32_t n = 1 << 16;
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) > 0 ? 1 : 0;
+        uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += (uint64_t)s * (uint64_t)s * ((3 * rx) ^ ry);
+
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
         }
+    }
 
-        p0 = _computeTriangleCentroid(f, T);
+    return d;
+}
+
+/*
+    Visibility walk from the start triangle toward p. Triangles are wound
+    clockwise, so p is outside of a triangle if it lies strictly to the left
+    of one of its edges, in which case the walk steps across that edge.
+    With exact orientation tests the walk cannot cycle in a Delaunay
+    triangulation.
+*/
+dcel::Face Delaunay::_locateTriangleAtPoint(dcel::Point &p, dcel::Face &start, 
+                                            dcel::DCEL &T) {
+    Face f = start;
+    HalfEdge h;
+    for (;;) {
         bool isNeighbourFound = false;
         h = T.outerComponent(f);
         for (int i = 0; i < 3; i++) {
-            if (_isSegmentIntersectingEdge(p0, p, h, T)) {
-                f = T.incidentFace(T.twin(h));
+            if (_pointToEdgeOrientation(p, h, T) > 0.0) {
                 isNeighbourFound = true;
+                break;
             }
             h = T.next(h);
         }
 
         if (!isNeighbourFound) {
-            break;
-        }
-    
-        // Due to numerical error, a point may not report to be contained
-        // in any triangle. In this case, the search will travel back and
-        // forth between two faces. Tracking the last two face id's will 
-        // allow cycles to be detected
-        faceHistory[2] = faceHistory[1];
-        faceHistory[1] = faceHistory[0];
-        faceHistory[0] = f.id.ref;
-        if (faceHistory[0] == faceHistory[2]) {
-            break;
+            return f;
         }
 
-        count++;
-        if (count > maxcount) {
+        HalfEdge twin = T.twin(h);
+        if (twin.incidentFace.ref == -1) {
+            // p lies outside of the super triangle
             break;
         }
+        f = T.incidentFace(twin);
     }
 
     return Face();
 }
 
-bool Delaunay::_isPointInsideTriangle(dcel::Point &p, dcel::Face &f, dcel::DCEL &T) {
-    HalfEdge h = T.outerComponent(f);
-    Point p0 = T.origin(h).position;
-    h = T.next(h);
-    Point p1 = T.origin(h).position;
-    Point p2 = T.origin(T.next(h)).position;
-
-    double area = 0.5*(-p1.y*p2.x + p0.y*(-p1.x + p2.x) + p0.x*(p1.y - p2.y) + p1.x*p2.y);
-    double s = 1.0/(2.0*area)*(p0.y*p2.x - p0.x*p2.y + (p2.y - p0.y)*p.x + (p0.x - p2.x)*p.y);
-    double t = 1.0/(2.0*area)*(p0.x*p1.y - p0.y*p1.x + (p0.y - p1.y)*p.x + (p1.x - p0.x)*p.y);
-
-    return s >= 0 && t >= 0 && 1 - s - t >= 0;
-}
-
-dcel::Point Delaunay::_computeTriangleCentroid(dcel::Face &f, dcel::DCEL &T) {
-    HalfEdge h = T.outerComponent(f);
-    Point p0 = T.origin(h).position;
-    Point p1 = T.origin(T.next(h)).position;
-    Point p2 = T.origin(T.prev(h)).position;
-
-    double frac = 1.0 / 3.0;
-    return Point(frac*(p0.x + p1.x + p2.x), frac*(p0.y + p1.y + p2.y));
-}
-
-bool Delaunay::_isSegmentIntersectingEdge(dcel::Point &A, dcel::Point &B, 
-                                          dcel::HalfEdge &h, dcel::DCEL &T) {
-    Point C = T.origin(h).position;
-    Point D = T.origin(T.twin(h)).position;
-    return Geometry::lineSegmentIntersection(A, B, C, D);
-}
-
-double Delaunay::_pointToEdgeDistance(dcel::Point &p0, dcel::HalfEdge &h, dcel::DCEL &T) {
+// Positive if p lies to the left of h, zero if p lies on the line through h
+double Delaunay::_pointToEdgeOrientation(dcel::Point &p, dcel::HalfEdge &h, dcel::DCEL &T) {
     Point p1 = T.origin(h).position;
     Point p2 = T.origin(T.twin(h)).position;
-
-    double vx = p2.x - p1.x;
-    double vy = p2.y - p1.y;
-    double len = sqrt(vx*vx + vy*vy);
-
-    return fabs((vx*(p1.y - p0.y) - (p1.x - p0.x)*vy) / len);
+    return Geometry::orient2d(p1, p2, p);
 }
 
 void Delaunay::_insertPointIntoTriangulation(dcel::Point p, dcel::Face f, dcel::DCEL &T) {
-    double eps = 1e-9;
     int closeEdgeCount = 0;
     HalfEdge closeEdge;
 
     HalfEdge h = T.outerComponent(f);
     for (int i = 0; i < 3; i++) {
-        double dist = _pointToEdgeDistance(p, h, T);
-        if (dist < eps) {
+        if (_pointToEdgeOrientation(p, h, T) == 0.0) {
             closeEdge = h;
             closeEdgeCount++;
 
             if (closeEdgeCount == 2) {
-                // Point is too close to an existing vertex
+                // Point coincides with an existing vertex
                 return;
             }
         }
@@ -497,29 +534,11 @@ bool Delaunay::_isEdgeLegal(dcel::Vertex v, dcel::HalfEdge e, dcel::DCEL &T) {
         Let edge pipj be incident to triangles p0pipj and pipjpk, and let
         C be the circle through p0, pi, and pj. The edge pipj is illegal if
         and only if the point pk lies in the interior of C.
-    */
-
-    Point p(0.5*(pi.x + pj.x), 0.5*(pi.y + pj.y));
-    Point r(-(pj.y - pi.y), pj.x - pi.x);
 
-    Point q(0.5*(pi.x + p0.x), 0.5*(pi.y + p0.y));
-    Point s(-(p0.y - pi.y), p0.x - pi.x);
-
-    Point center;
-    bool isIntersection = Geometry::lineIntersection(p, r, q, s, &center);
-    if (!isIntersection) {
-        return false;
-    }
-
-    double dvx = p0.x - center.x;
-    double dvy = p0.y - center.y;
-    double crsq = dvx*dvx + dvy*dvy;
-
-    double dkx = pk.x - center.x;
-    double dky = pk.y - center.y;
-    double distsq = dkx*dkx + dky*dky;
-    
-    return distsq >= crsq;
+        Triangle pipjp0 is wound clockwise, so pk is inside of C when
+        incircle is negative.
+    */
+    return Geometry::incircle(pi, pj, p0, pk) >= 0.0;
 }
 
 void Delaunay::_legalizeEdge(dcel::Vertex pr, dcel::HalfEdge eij, dcel::DCEL &T) {
@@ -6,6 +6,8 @@
 #include <math.h>
 #include <vector>
 #include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
 
 #include "dcel.h"
 #include "geometry.h"
@@ -19,11 +21,10 @@ DCEL triangulate(std::vector<Point> &points);
 void _getSuperTriangle(std::vector<Point> &points,
                        Point *p1, Point *p2, Point *p3);
 DCEL _initTriangulation(std::vector<Point> &points);
-Face _locateTriangleAtPoint(Point &p, DCEL &T);
-Point _computeTriangleCentroid(Face &f, DCEL &T);
-bool _isSegmentIntersectingEdge(Point &p0, Point &p1, HalfEdge &h, DCEL &T);
-bool _isPointInsideTriangle(Point &p, Face &f, DCEL &T);
-double _pointToEdgeDistance(Point &p, HalfEdge &h, DCEL &T);
+void _sortInsertionOrder(std::vector<Point> &points);
+uint64_t _getHilbertIndex(uint32_t x, uint32_t y);
+Face _locateTriangleAtPoint(Point &p, Face &start, DCEL &T);
+double _pointToEdgeOrientation(Point &p, HalfEdge &h, DCEL &T);
 void _insertPointIntoTriangulation(Point p, Face f, DCEL &T);
 void _insertPointIntoTriangle(Point p, Face f, DCEL &T);
 void _insertPointIntoTriangleEdge(Point p, Face f, HalfEdge h, DCEL &T);
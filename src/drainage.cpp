@@ -0,0 +1,356 @@
+#include "drainage.h"
+
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "nodemapkernels.h"
+#include "parallel.h"
+
+void Drainage::fillDepressions(const gen::LayerValue *heights, int count,
+                               const gen::AdjacencyList &neighbours,
+                               const std::vector<int> &edges, double eps,
+                               gen::LayerValue *filled) {
+    if (count == 0) {
+        return;
+    }
+
+    gen::LayerValue maxHeight = NodeMapKernels::getMax(heights, count);
+    std::fill(filled, filled + count, maxHeight);
+
+    std::vector<_FillCell> seeds;
+    seeds.reserve(edges.size());
+    for (unsigned int i = 0; i < edges.size(); i++) {
+        int idx = edges[i];
+        filled[idx] = heights[idx];
+        seeds.push_back(_FillCell{heights[idx], idx});
+    }
+
+    _floodTile(heights, neighbours, nullptr, -1, eps, seeds, filled);
+}
+
+void Drainage::fillDepressions(const gen::LayerValue *heights, int count,
+                               const gen::AdjacencyList &neighbours,
+                               const std::vector<int> &edges, double eps,
+                               const std::vector<int> &tiles, int numTiles,
+                               int numThreads, gen::LayerValue *filled) {
+    if (count == 0) {
+        return;
+    }
+
+    gen::LayerValue maxHeight = NodeMapKernels::getMax(heights, count);
+    std::fill(filled, filled + count, maxHeight);
+
+    std::vector<std::vector<int> > tileVertices(numTiles);
+    for (int i = 0; i < count; i++) {
+        tileVertices[tiles[i]].push_back(i);
+    }
+
+    std::vector<std::vector<_FillCell> > tileSeeds(numTiles);
+    std::vector<bool> isEdge(count, false);
+    for (unsigned int i = 0; i < edges.size(); i++) {
+        int idx = edges[i];
+        filled[idx] = heights[idx];
+        tileSeeds[tiles[idx]].push_back(_FillCell{heights[idx], idx});
+        isEdge[idx] = true;
+    }
+
+    // Flood each tile from its own edge vertices
+    const int *offsets = neighbours.offsets.data();
+    const int *indices = neighbours.indices.data();
+    std::vector<std::vector<_SpillEdge> > spillEdges(numTiles);
+    Parallel::forEach(0, numTiles, numThreads, [&](int t) {
+        for (int v : tileVertices[t]) {
+            for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+                if (tiles[indices[k]] != t) {
+                    spillEdges[t].push_back(_SpillEdge{v, indices[k]});
+                }
+            }
+        }
+        _floodTile(heights, neighbours, tiles.data(), t, eps, tileSeeds[t], filled);
+    });
+
+    // Relax the spill edges until the tiles agree. Heights across the spill
+    // edges are read before any tile is updated, so that tiles never read
+    // vertices that are being written.
+    std::vector<std::vector<gen::LayerValue> > spillHeights(numTiles);
+    for (;;) {
+        Parallel::forEach(0, numTiles, numThreads, [&](int t) {
+            std::vector<_SpillEdge> &spill = spillEdges[t];
+            spillHeights[t].resize(spill.size());
+            for (unsigned int k = 0; k < spill.size(); k++) {
+                spillHeights[t][k] = filled[spill[k].outside];
+            }
+        });
+
+        std::vector<char> isLowered(numTiles, 0);
+        Parallel::forEach(0, numTiles, numThreads, [&](int t) {
+            std::vector<_SpillEdge> &spill = spillEdges[t];
+            std::vector<_FillCell> &seeds = tileSeeds[t];
+            seeds.clear();
+            for (unsigned int k = 0; k < spill.size(); k++) {
+                int v = spill[k].inside;
+                gen::LayerValue value;
+                bool isRaised;
+                if (_getFillHeight(heights[v], spillHeights[t][k], eps, &value, &isRaised) &&
+                        value < filled[v]) {
+                    filled[v] = value;
+                    seeds.push_back(_FillCell{value, v});
+                }
+            }
+
+            if (!seeds.empty()) {
+                isLowered[t] = 1;
+                _floodTile(heights, neighbours, tiles.data(), t, eps, seeds, filled);
+            }
+        });
+
+        if (std::find(isLowered.begin(), isLowered.end(), 1) == isLowered.end()) {
+            break;
+        }
+    }
+
+    // The filled height of each vertex is the lowest height that its
+    // neighbours lower it to
+    std::vector<char> isValid(numTiles, 1);
+    Parallel::forEach(0, numTiles, numThreads, [&](int t) {
+        for (int v : tileVertices[t]) {
+            gen::LayerValue expected = isEdge[v] ? heights[v] : maxHeight;
+            for (int k = offsets[v]; k < offsets[v + 1] && !isEdge[v]; k++) {
+                gen::LayerValue value;
+                bool isRaised;
+                if (_getFillHeight(heights[v], filled[indices[k]], eps, &value, &isRaised) &&
+                        value < expected) {
+                    expected = value;
+                }
+            }
+
+            if (filled[v] != expected) {
+                isValid[t] = 0;
+                return;
+            }
+        }
+    });
+
+    if (std::find(isValid.begin(), isValid.end(), 0) != isValid.end()) {
+        fillDepressions(heights, count, neighbours, edges, eps, filled);
+    }
+}
+
+void Drainage::getReceivers(const gen::LayerValue *heights,
+                            const gen::AdjacencyList &neighbours,
+                            const std::vector<int> &vertices, int numThreads,
+                            int *receivers) {
+    const int *offsets = neighbours.offsets.data();
+    const int *indices = neighbours.indices.data();
+    Parallel::forEachRange(0, (int)vertices.size(), numThreads, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) {
+            int v = vertices[i];
+            int minIndex = -1;
+            gen::LayerValue minHeight = heights[v];
+            for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+                int n = indices[k];
+                if (heights[n] < minHeight) {
+                    minHeight = heights[n];
+                    minIndex = n;
+                }
+            }
+            receivers[v] = minIndex;
+        }
+    });
+}
+
+void Drainage::getFlowOrder(const int *receivers, int count, std::vector<int> &order) {
+    gen::AdjacencyList donors;
+    _getDonors(receivers, count, donors);
+
+    order.clear();
+    order.reserve(count);
+    std::vector<int> stack;
+    for (int i = 0; i < count; i++) {
+        if (receivers[i] == -1) {
+            _addDrainageTree(i, donors, stack, order);
+        }
+    }
+}
+
+void Drainage::accumulateFlux(const int *receivers, const std::vector<int> &order,
+                              gen::LayerValue *flux) {
+    // Counts are accumulated in double so that they stay exact for single
+    // precision layers
+    std::vector<double> counts(order.size(), 1.0);
+    _accumulateCounts(receivers, order.data(), (int)order.size(), counts.data());
+
+    for (unsigned int i = 0; i < counts.size(); i++) {
+        flux[i] = (gen::LayerValue)counts[i];
+    }
+}
+
+void Drainage::accumulateFlux(const int *receivers, int count, int numThreads,
+                              std::vector<int> &order, gen::LayerValue *flux) {
+    gen::AdjacencyList donors;
+    _getDonors(receivers, count, donors);
+
+    std::vector<int> outlets;
+    for (int i = 0; i < count; i++) {
+        if (receivers[i] == -1) {
+            outlets.push_back(i);
+        }
+    }
+
+    // Outlets are split into contiguous chunks, so appending the parts of
+    // the order in chunk order gives the serial order. Basin sizes vary
+    // between outlets, so there are many chunks per thread, dealt out to
+    // the threads in turn.
+    int nthreads = std::max(1, std::min(Parallel::getThreadCount(numThreads), (int)outlets.size()));
+    int numChunks = std::min(nthreads * _chunksPerThread, (int)outlets.size());
+    std::vector<std::vector<int> > orderParts(numChunks);
+    std::vector<double> counts(count, 1.0);
+    Parallel::forEach(0, nthreads, nthreads, [&](int t) {
+        std::vector<int> stack;
+        for (int c = t; c < numChunks; c += nthreads) {
+            int begin = (int)((int64_t)outlets.size() * c / numChunks);
+            int end = (int)((int64_t)outlets.size() * (c + 1) / numChunks);
+            std::vector<int> &part = orderParts[c];
+            for (int i = begin; i < end; i++) {
+                _addDrainageTree(outlets[i], donors, stack, part);
+            }
+            _accumulateCounts(receivers, part.data(), (int)part.size(), counts.data());
+        }
+    });
+
+    order.clear();
+    order.reserve(count);
+    for (int c = 0; c < numChunks; c++) {
+        order.insert(order.end(), orderParts[c].begin(), orderParts[c].end());
+    }
+
+    Parallel::forEachRange(0, count, nthreads, [&](int begin, int end, int) {
+        for (int i = begin; i < end; i++) {
+            flux[i] = (gen::LayerValue)counts[i];
+        }
+    });
+}
+
+void Drainage::_getDonors(const int *receivers, int count, gen::AdjacencyList &donors) {
+    donors.offsets.assign(count + 1, 0);
+    for (int i = 0; i < count; i++) {
+        if (receivers[i] != -1) {
+            donors.offsets[receivers[i] + 1]++;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        donors.offsets[i + 1] += donors.offsets[i];
+    }
+
+    std::vector<int> next(donors.offsets.begin(), donors.offsets.end() - 1);
+    donors.indices.resize(donors.offsets[count]);
+    for (int i = 0; i < count; i++) {
+        if (receivers[i] != -1) {
+            donors.indices[next[receivers[i]]++] = i;
+        }
+    }
+}
+
+void Drainage::_addDrainageTree(int outlet, const gen::AdjacencyList &donors,
+                                std::vector<int> &stack, std::vector<int> &order) {
+    stack.push_back(outlet);
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        order.push_back(v);
+        for (int k = donors.offsets[v + 1] - 1; k >= donors.offsets[v]; k--) {
+            stack.push_back(donors.indices[k]);
+        }
+    }
+}
+
+void Drainage::_accumulateCounts(const int *receivers, const int *order, int count,
+                                 double *counts) {
+    for (int k = count - 1; k >= 0; k--) {
+        int v = order[k];
+        if (receivers[v] != -1) {
+            counts[receivers[v]] += counts[v];
+        }
+    }
+}
+
+bool Drainage::_getFillHeight(gen::LayerValue h, double nval, double eps,
+                              gen::LayerValue *value, bool *isRaised) {
+    if (h >= nval + eps) {
+        *value = h;
+        *isRaised = false;
+        return true;
+    }
+
+    // Round the same way as the stored heights, and keep the gradient where
+    // eps is below the precision of single precision layers
+    gen::LayerValue hval = (gen::LayerValue)(nval + eps);
+    if (hval <= nval) {
+        hval = std::nextafter((gen::LayerValue)nval,
+                              std::numeric_limits<gen::LayerValue>::max());
+    }
+    if (hval > h) {
+        *value = hval;
+        *isRaised = true;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+    Vertices are processed in ascending order of filled height. Entries in
+    the heap and queue go stale when their vertex is lowered again, and are
+    skipped.
+*/
+void Drainage::_floodTile(const gen::LayerValue *heights, const gen::AdjacencyList &neighbours,
+                          const int *tiles, int tile, double eps,
+                          std::vector<_FillCell> &seeds, gen::LayerValue *filled) {
+    std::priority_queue<_FillCell, std::vector<_FillCell>, std::greater<_FillCell> >
+        open(std::greater<_FillCell>(), std::move(seeds));
+    std::queue<_FillCell> raised;
+
+    const int *offsets = neighbours.offsets.data();
+    const int *indices = neighbours.indices.data();
+    while (!open.empty() || !raised.empty()) {
+        _FillCell c;
+        if (!raised.empty() && (open.empty() || !(raised.front() > open.top()))) {
+            c = raised.front();
+            raised.pop();
+        } else {
+            c = open.top();
+            open.pop();
+        }
+
+        if (c.height != filled[c.index]) {
+            continue;
+        }
+
+        double nval = c.height;
+        for (int k = offsets[c.index]; k < offsets[c.index + 1]; k++) {
+            int n = indices[k];
+            if (tiles != nullptr && tiles[n] != tile) {
+                continue;
+            }
+
+            gen::LayerValue value;
+            bool isRaised;
+            if (!_getFillHeight(heights[n], nval, eps, &value, &isRaised) ||
+                    !(value < filled[n])) {
+                continue;
+            }
+
+            filled[n] = value;
+            if (isRaised) {
+                raised.push(_FillCell{value, n});
+            } else {
+                open.push(_FillCell{value, n});
+            }
+        }
+    }
+
+    seeds.clear();
+}
@@ -0,0 +1,140 @@
+#ifndef DRAINAGE_H
+#define DRAINAGE_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+
+#include "adjacencylist.h"
+#include "nodemap.h"
+
+/*
+    Drainage computations on the vertex map, working on raw node value
+    arrays indexed by vertex map index.
+*/
+namespace Drainage {
+
+/*
+    Raise the heights so that every vertex that is connected to an edge
+    vertex has a strictly descending path to one, with a gradient of at
+    least eps across filled regions.
+
+    The filled surface is the one reached by repeatedly sweeping the
+    vertices until no height changes (Planchon and Darboux): edge vertices
+    keep their height, every other vertex starts at the maximum height and
+    is lowered to its own height if it is at least eps above a neighbour,
+    or else to eps above its lowest such neighbour. Vertices that are not
+    connected to an edge vertex stay at the maximum height.
+
+    The surface is computed in a single priority-flood (Barnes et al.) from
+    the edge vertices instead. Vertices are finalized in ascending order of
+    filled height, taken from a binary heap of vertices at their own height
+    and a FIFO queue of raised vertices. Raised vertices are queued in
+    ascending order, so the queue needs no sorting.
+*/
+void fillDepressions(const gen::LayerValue *heights, int count,
+                     const gen::AdjacencyList &neighbours,
+                     const std::vector<int> &edges, double eps,
+                     gen::LayerValue *filled);
+
+/*
+    fillDepressions on up to numThreads threads, with the vertices split
+    into spatial tiles (tiles[i] is the tile of vertex i, in [0, numTiles)).
+
+    Each tile is first flooded independently from its own edge vertices.
+    The spill edges between tiles are then relaxed in rounds: every tile
+    lowers the vertices that drain into a neighbouring tile at that tile's
+    current heights and floods the change through the tile, until no
+    spill edge lowers a vertex. Each vertex is finally checked against its
+    neighbours; the filled surface is unique, so the result is the same
+    as the serial fill. If a check fails (only possible through rounding
+    of single precision layers) the serial fill is used instead.
+*/
+void fillDepressions(const gen::LayerValue *heights, int count,
+                     const gen::AdjacencyList &neighbours,
+                     const std::vector<int> &edges, double eps,
+                     const std::vector<int> &tiles, int numTiles,
+                     int numThreads, gen::LayerValue *filled);
+
+/*
+    Set receivers[v] for each of the listed vertices to its lowest
+    neighbour that is lower than it (the first such neighbour on ties), or
+    to -1 if it has no lower neighbour. Vertices are split across up to
+    numThreads threads.
+*/
+void getReceivers(const gen::LayerValue *heights, const gen::AdjacencyList &neighbours,
+                  const std::vector<int> &vertices, int numThreads, int *receivers);
+
+/*
+    Order the vertices so that every vertex comes after its receiver, the
+    vertex it flows to (receivers[i], or -1 if vertex i is an outlet). Each
+    drainage tree is stored contiguously, starting at its outlet (the
+    donor stack of Braun and Willett).
+*/
+void getFlowOrder(const int *receivers, int count, std::vector<int> &order);
+
+/*
+    Number of vertices that flow through each vertex, including the vertex
+    itself, in a single pass over the flow order in reverse
+*/
+void accumulateFlux(const int *receivers, const std::vector<int> &order,
+                    gen::LayerValue *flux);
+
+/*
+    getFlowOrder followed by accumulateFlux on up to numThreads threads.
+    Drainage trees are independent, so the outlets are split into chunks
+    across the threads and each thread orders and accumulates the trees of
+    its chunks. The
+    order and flux are the same as from the serial functions.
+*/
+void accumulateFlux(const int *receivers, int count, int numThreads,
+                    std::vector<int> &order, gen::LayerValue *flux);
+
+struct _FillCell {
+    gen::LayerValue height;
+    int index;
+
+    bool operator>(const _FillCell &other) const {
+        return height > other.height;
+    }
+};
+
+// Vertex inside a tile and its neighbour in another tile
+struct _SpillEdge {
+    int inside;
+    int outside;
+};
+
+// Chunks of outlets per thread in the parallel flux accumulation
+const int _chunksPerThread = 32;
+
+// Donors of each vertex, the vertices that flow to it, in index order
+void _getDonors(const int *receivers, int count, gen::AdjacencyList &donors);
+
+// Append the drainage tree of outlet to order in donor stack order
+void _addDrainageTree(int outlet, const gen::AdjacencyList &donors,
+                      std::vector<int> &stack, std::vector<int> &order);
+
+// Add the count of each vertex to its receiver, in reverse order
+void _accumulateCounts(const int *receivers, const int *order, int count,
+                       double *counts);
+
+/*
+    Height that a vertex of height h is lowered to by a neighbour filled to
+    nval. Returns false if the neighbour does not lower the vertex, and
+    sets isRaised if the height is above h.
+*/
+bool _getFillHeight(gen::LayerValue h, double nval, double eps,
+                    gen::LayerValue *value, bool *isRaised);
+
+/*
+    Flood the lowered vertices in seeds through the vertices of tile,
+    lowering filled heights only. A tile of -1 floods all vertices.
+*/
+void _floodTile(const gen::LayerValue *heights, const gen::AdjacencyList &neighbours,
+                const int *tiles, int tile, double eps,
+                std::vector<_FillCell> &seeds, gen::LayerValue *filled);
+
+}
+
+#endif
@@ -28,6 +28,8 @@
 
 #include "fastnoise.h"
 
+#include "noisekernels.h"
+
 #include <math.h>
 #include <assert.h>
 
@@ -2094,6 +2096,181 @@ FN_DECIMAL FastNoise::SingleCellular2Edge(FN_DECIMAL x, FN_DECIMAL y) const
 	}
 }
 
+// Batched Noise
+// Points are scaled by the frequency one block at a time and each octave of a block is evaluated by the
+// vector kernels, accumulating the octaves in the same order as the Single...Fractal functions
+static const int FILL_BLOCK_SIZE = 256;
+
+void FastNoise::FillNoise(const FN_DECIMAL* xs, const FN_DECIMAL* ys, FN_DECIMAL* out, int n) const
+{
+#ifdef FN_USE_DOUBLES
+	if (IsFillNoiseVectorized())
+	{
+		NoiseKernels::NoiseTables tables;
+		FillNoiseTables(tables);
+
+		FN_DECIMAL x[FILL_BLOCK_SIZE];
+		FN_DECIMAL y[FILL_BLOCK_SIZE];
+		for (int start = 0; start < n; start += FILL_BLOCK_SIZE)
+		{
+			int count = std::min(FILL_BLOCK_SIZE, n - start);
+			for (int i = 0; i < count; i++)
+			{
+				x[i] = xs[start + i] * m_frequency;
+				y[i] = ys[start + i] * m_frequency;
+			}
+			FillNoiseBlock(tables, x, y, out + start, count);
+		}
+		return;
+	}
+#endif
+
+	for (int i = 0; i < n; i++)
+		out[i] = GetNoise(xs[i], ys[i]);
+}
+
+#ifdef FN_USE_DOUBLES
+bool FastNoise::IsFillNoiseVectorized() const
+{
+	if (!NoiseKernels::isVectorized())
+		return false;
+
+	switch (m_noiseType)
+	{
+	case Value:
+	case ValueFractal:
+	case Perlin:
+	case PerlinFractal:
+	case Simplex:
+	case SimplexFractal:
+		return true;
+	case Cellular:
+		return m_cellularReturnType != NoiseLookup;
+	default:
+		return false;
+	}
+}
+
+void FastNoise::FillNoiseTables(NoiseKernels::NoiseTables& tables) const
+{
+	for (int i = 0; i < 512; i++)
+	{
+		tables.perm[i] = m_perm[i];
+		tables.perm12[i] = m_perm12[i];
+	}
+	tables.valueLUT = VAL_LUT;
+	tables.cellX = CELL_2D_X;
+	tables.cellY = CELL_2D_Y;
+}
+
+void FastNoise::FillNoiseBlock(const NoiseKernels::NoiseTables& tables, FN_DECIMAL* x, FN_DECIMAL* y, FN_DECIMAL* out, int n) const
+{
+	NoiseKernels::CellularParams cellular;
+	switch (m_noiseType)
+	{
+	case Value:
+	case Perlin:
+	case Simplex:
+		FillSingle(tables, 0, x, y, out, n);
+		break;
+	case ValueFractal:
+	case PerlinFractal:
+	case SimplexFractal:
+		FillFractal(tables, x, y, out, n);
+		break;
+	case Cellular:
+		cellular.seed = m_seed;
+		cellular.jitter = m_cellularJitter;
+		cellular.distanceFunction = m_cellularDistanceFunction;
+		cellular.returnType = m_cellularReturnType;
+		cellular.distanceIndex0 = m_cellularDistanceIndex0;
+		cellular.distanceIndex1 = m_cellularDistanceIndex1;
+		NoiseKernels::cellular(tables, cellular, x, y, out, n);
+		break;
+	default:
+		break;
+	}
+}
+
+void FastNoise::FillSingle(const NoiseKernels::NoiseTables& tables, unsigned char offset, const FN_DECIMAL* x, const FN_DECIMAL* y, FN_DECIMAL* out, int n) const
+{
+	switch (m_noiseType)
+	{
+	case Value:
+	case ValueFractal:
+		NoiseKernels::value(tables, m_interp, offset, x, y, out, n);
+		break;
+	case Perlin:
+	case PerlinFractal:
+		NoiseKernels::perlin(tables, m_interp, offset, x, y, out, n);
+		break;
+	case Simplex:
+	case SimplexFractal:
+		NoiseKernels::simplex(tables, offset, x, y, out, n);
+		break;
+	default:
+		break;
+	}
+}
+
+void FastNoise::FillFractal(const NoiseKernels::NoiseTables& tables, FN_DECIMAL* x, FN_DECIMAL* y, FN_DECIMAL* out, int n) const
+{
+	FN_DECIMAL noise[FILL_BLOCK_SIZE];
+	FillSingle(tables, m_perm[0], x, y, noise, n);
+	for (int k = 0; k < n; k++)
+	{
+		switch (m_fractalType)
+		{
+		case FBM:
+			out[k] = noise[k];
+			break;
+		case Billow:
+			out[k] = FastAbs(noise[k]) * 2 - 1;
+			break;
+		case RigidMulti:
+			out[k] = 1 - FastAbs(noise[k]);
+			break;
+		}
+	}
+
+	FN_DECIMAL amp = 1;
+	int i = 0;
+
+	while (++i < m_octaves)
+	{
+		for (int k = 0; k < n; k++)
+		{
+			x[k] *= m_lacunarity;
+			y[k] *= m_lacunarity;
+		}
+
+		amp *= m_gain;
+		FillSingle(tables, m_perm[i], x, y, noise, n);
+		for (int k = 0; k < n; k++)
+		{
+			switch (m_fractalType)
+			{
+			case FBM:
+				out[k] += noise[k] * amp;
+				break;
+			case Billow:
+				out[k] += (FastAbs(noise[k]) * 2 - 1) * amp;
+				break;
+			case RigidMulti:
+				out[k] -= (1 - FastAbs(noise[k])) * amp;
+				break;
+			}
+		}
+	}
+
+	if (m_fractalType != RigidMulti)
+	{
+		for (int k = 0; k < n; k++)
+			out[k] *= m_fractalBounding;
+	}
+}
+#endif
+
 void FastNoise::GradientPerturb(FN_DECIMAL& x, FN_DECIMAL& y, FN_DECIMAL& z) const
 {
 	SingleGradientPerturb(0, m_gradientPerturbAmp, m_frequency, x, y, z);
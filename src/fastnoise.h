@@ -41,6 +41,11 @@ typedef double FN_DECIMAL;
 #else
 typedef float FN_DECIMAL;
 #endif
+
+namespace NoiseKernels {
+struct NoiseTables;
+}
+
 namespace gen {
 class FastNoise
 {
@@ -181,6 +186,11 @@ public:
 
 	FN_DECIMAL GetNoise(FN_DECIMAL x, FN_DECIMAL y) const;
 
+	// Fills out[i] with GetNoise(xs[i], ys[i]) for n points
+	// Value, Perlin, Simplex and Cellular noise and their fractals are evaluated with vector instructions
+	// when available and are identical to GetNoise, other noise types are evaluated one point at a time
+	void FillNoise(const FN_DECIMAL* xs, const FN_DECIMAL* ys, FN_DECIMAL* out, int n) const;
+
 	void GradientPerturb(FN_DECIMAL& x, FN_DECIMAL& y) const;
 	void GradientPerturbFractal(FN_DECIMAL& x, FN_DECIMAL& y) const;
 
@@ -266,6 +276,12 @@ private:
 
 	void SingleGradientPerturb(unsigned char offset, FN_DECIMAL warpAmp, FN_DECIMAL frequency, FN_DECIMAL& x, FN_DECIMAL& y) const;
 
+	bool IsFillNoiseVectorized() const;
+	void FillNoiseTables(NoiseKernels::NoiseTables& tables) const;
+	void FillNoiseBlock(const NoiseKernels::NoiseTables& tables, FN_DECIMAL* x, FN_DECIMAL* y, FN_DECIMAL* out, int n) const;
+	void FillSingle(const NoiseKernels::NoiseTables& tables, unsigned char offset, const FN_DECIMAL* x, const FN_DECIMAL* y, FN_DECIMAL* out, int n) const;
+	void FillFractal(const NoiseKernels::NoiseTables& tables, FN_DECIMAL* x, FN_DECIMAL* y, FN_DECIMAL* out, int n) const;
+
 	//3D
 	FN_DECIMAL SingleValueFractalFBM(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
 	FN_DECIMAL SingleValueFractalBillow(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z) const;
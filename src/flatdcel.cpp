@@ -0,0 +1,249 @@
+#include "flatdcel.h"
+
+#include <stdint.h>
+#include <limits>
+#include <algorithm>
+
+dcel::FlatDCEL::FlatDCEL(DCEL &D) : FlatDCEL(D, MeshLayout::full) {
+}
+
+dcel::FlatDCEL::FlatDCEL(DCEL &D, MeshLayout layout) {
+    std::shared_ptr<_Arrays> arrays = std::make_shared<_Arrays>();
+    _isCompact = layout == MeshLayout::compact;
+
+    // DCEL half-edge -> mesh half-edge, empty if they are the same
+    std::vector<int> edgeMap;
+    int ne = D.edges.size();
+    if (_isCompact) {
+        ne = _getCompactEdgeMap(D, edgeMap);
+    }
+
+    int nv = D.vertices.size();
+    arrays->vertexX.resize(nv);
+    arrays->vertexY.resize(nv);
+    arrays->vertexEdge.resize(nv);
+    for (int i = 0; i < nv; i++) {
+        Vertex &v = D.vertices[i];
+        int h = v.incidentEdge.ref;
+        arrays->vertexX[i] = v.position.x;
+        arrays->vertexY[i] = v.position.y;
+        arrays->vertexEdge[i] = h == -1 || edgeMap.empty() ? h : edgeMap[h];
+    }
+
+    arrays->edgeOrigin.resize(ne);
+    arrays->edgeNext.resize(ne);
+    arrays->edgeFace.resize(ne);
+    if (_isCompact) {
+        std::fill(arrays->edgeOrigin.begin(), arrays->edgeOrigin.end(), -1);
+        std::fill(arrays->edgeNext.begin(), arrays->edgeNext.end(), -1);
+        std::fill(arrays->edgeFace.begin(), arrays->edgeFace.end(), -1);
+        for (unsigned int i = 0; i < D.edges.size(); i++) {
+            HalfEdge &h = D.edges[i];
+            int eidx = edgeMap[i];
+            arrays->edgeOrigin[eidx] = h.origin.ref;
+            arrays->edgeFace[eidx] = h.incidentFace.ref;
+            if (h.next.ref != -1) {
+                arrays->edgeNext[eidx] = edgeMap[h.next.ref];
+            }
+
+            if (h.twin.ref == -1 && h.next.ref != -1) {
+                arrays->edgeOrigin[eidx ^ 1] = D.edges[h.next.ref].origin.ref;
+            }
+        }
+    } else {
+        arrays->edgeTwin.resize(ne);
+        arrays->edgePrev.resize(ne);
+        for (int i = 0; i < ne; i++) {
+            HalfEdge &h = D.edges[i];
+            arrays->edgeOrigin[i] = h.origin.ref;
+            arrays->edgeTwin[i] = h.twin.ref;
+            arrays->edgeNext[i] = h.next.ref;
+            arrays->edgePrev[i] = h.prev.ref;
+            arrays->edgeFace[i] = h.incidentFace.ref;
+        }
+    }
+
+    int nf = D.faces.size();
+    arrays->faceEdge.resize(nf);
+    for (int i = 0; i < nf; i++) {
+        int h = D.faces[i].outerComponent.ref;
+        arrays->faceEdge[i] = h == -1 || edgeMap.empty() ? h : edgeMap[h];
+    }
+
+    vertexX = arrays->vertexX.data();
+    vertexY = arrays->vertexY.data();
+    vertexEdge = arrays->vertexEdge.data();
+    edgeOrigin = arrays->edgeOrigin.data();
+    edgeTwin = _isCompact ? nullptr : arrays->edgeTwin.data();
+    edgeNext = arrays->edgeNext.data();
+    edgePrev = _isCompact ? nullptr : arrays->edgePrev.data();
+    edgeFace = arrays->edgeFace.data();
+    faceEdge = arrays->faceEdge.data();
+
+    _vertexCount = nv;
+    _edgeCount = ne;
+    _faceCount = nf;
+    _storage = arrays;
+}
+
+dcel::FlatDCEL::FlatDCEL(std::shared_ptr<const void> storage, int nv, int ne, int nf) :
+                         _vertexCount(nv), _edgeCount(ne), _faceCount(nf),
+                         _isView(true), _storage(storage) {
+}
+
+size_t dcel::FlatDCEL::getMemoryUsage() const {
+    return getMemoryUsage(getLayout());
+}
+
+/*
+    Size of the arrays of this mesh in the given layout. In the compact
+    layout of a full mesh, a half-edge without a twin adds a placeholder.
+*/
+size_t dcel::FlatDCEL::getMemoryUsage(MeshLayout layout) const {
+    size_t numEdges = edgeCount();
+    size_t edgeArrays = 5;
+    if (layout == MeshLayout::compact) {
+        edgeArrays = 3;
+        if (!_isCompact) {
+            numEdges = 0;
+            for (int i = 0; i < edgeCount(); i++) {
+                int t = edgeTwin[i];
+                if (t == -1 || t > i) {
+                    numEdges += 2;
+                }
+            }
+        }
+    }
+
+    return (size_t)vertexCount() * (2 * sizeof(double) + sizeof(int)) +
+           numEdges * edgeArrays * sizeof(int) +
+           (size_t)faceCount() * sizeof(int);
+}
+
+dcel::MeshLayout dcel::FlatDCEL::getLayout() const {
+    return _isCompact ? MeshLayout::compact : MeshLayout::full;
+}
+
+/*
+    Copy of a compact mesh with the twin and prev arrays filled in and the
+    same half-edge indices. A full mesh is returned as is.
+*/
+dcel::FlatDCEL dcel::FlatDCEL::toFullLayout() const {
+    if (!_isCompact) {
+        return *this;
+    }
+
+    std::shared_ptr<_Arrays> arrays = std::make_shared<_Arrays>();
+    arrays->vertexX.assign(vertexX, vertexX + vertexCount());
+    arrays->vertexY.assign(vertexY, vertexY + vertexCount());
+    arrays->vertexEdge.assign(vertexEdge, vertexEdge + vertexCount());
+    arrays->edgeOrigin.assign(edgeOrigin, edgeOrigin + edgeCount());
+    arrays->edgeNext.assign(edgeNext, edgeNext + edgeCount());
+    arrays->edgeFace.assign(edgeFace, edgeFace + edgeCount());
+    arrays->faceEdge.assign(faceEdge, faceEdge + faceCount());
+
+    arrays->edgeTwin.resize(edgeCount());
+    arrays->edgePrev = std::vector<int>(edgeCount(), -1);
+    for (int i = 0; i < edgeCount(); i++) {
+        arrays->edgeTwin[i] = i ^ 1;
+        if (edgeNext[i] != -1) {
+            arrays->edgePrev[edgeNext[i]] = i;
+        }
+    }
+
+    FlatDCEL mesh;
+    mesh.vertexX = arrays->vertexX.data();
+    mesh.vertexY = arrays->vertexY.data();
+    mesh.vertexEdge = arrays->vertexEdge.data();
+    mesh.edgeOrigin = arrays->edgeOrigin.data();
+    mesh.edgeTwin = arrays->edgeTwin.data();
+    mesh.edgeNext = arrays->edgeNext.data();
+    mesh.edgePrev = arrays->edgePrev.data();
+    mesh.edgeFace = arrays->edgeFace.data();
+    mesh.faceEdge = arrays->faceEdge.data();
+    mesh._vertexCount = vertexCount();
+    mesh._edgeCount = edgeCount();
+    mesh._faceCount = faceCount();
+    mesh._storage = arrays;
+
+    return mesh;
+}
+
+bool dcel::FlatDCEL::isView() const {
+    return _isView;
+}
+
+void dcel::FlatDCEL::getOuterComponents(int f, std::vector<int> &edges) const {
+    int h = outerComponent(f);
+    int start = h;
+
+    do {
+        edges.push_back(h);
+        h = next(h);
+    } while (h != start);
+}
+
+void dcel::FlatDCEL::getIncidentEdges(int v, std::vector<int> &edges) const {
+    int h = incidentEdge(v);
+    int start = h;
+
+    do {
+        edges.push_back(h);
+        h = next(twin(h));
+    } while (h != start);
+}
+
+void dcel::FlatDCEL::getIncidentFaces(int v, std::vector<int> &faces) const {
+    int h = incidentEdge(v);
+    int start = h;
+
+    do {
+        if (!isBoundary(h)) {
+            faces.push_back(incidentFace(h));
+        }
+        h = next(twin(h));
+    } while (h != start);
+}
+
+/*
+    Assigns twin pairs of DCEL half-edges to mesh half-edges 2k and 2k+1
+    and returns the number of mesh half-edges. Half-edge indices are int,
+    so meshes with more than 2^31 - 1 half-edges are not supported.
+*/
+int dcel::FlatDCEL::_getCompactEdgeMap(DCEL &D, std::vector<int> &edgeMap) {
+    edgeMap = std::vector<int>(D.edges.size(), -1);
+    uint64_t numEdges = 0;
+    for (unsigned int i = 0; i < D.edges.size(); i++) {
+        if (edgeMap[i] != -1) {
+            continue;
+        }
+
+        if (numEdges + 2 > (uint64_t)std::numeric_limits<int>::max()) {
+            throw std::range_error("Edge count exceeds mesh index range: " +
+                                   std::to_string(numEdges + 2));
+        }
+
+        edgeMap[i] = (int)numEdges;
+        int t = D.edges[i].twin.ref;
+        if (t != -1 && edgeMap[t] == -1) {
+            edgeMap[t] = (int)numEdges + 1;
+        }
+        numEdges += 2;
+    }
+
+    return (int)numEdges;
+}
+
+int dcel::FlatDCEL::_findPrev(int h) const {
+    int e = h;
+    for (;;) {
+        int n = edgeNext[e];
+        if (n == -1) {
+            return -1;
+        }
+        if (n == h) {
+            return e;
+        }
+        e = n;
+    }
+}
@@ -0,0 +1,185 @@
+#ifndef FLATDCEL_H
+#define FLATDCEL_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <memory>
+
+#include "dcel.h"
+
+namespace dcel {
+
+enum class MeshLayout : char {
+    full = 0x00,
+    compact = 0x01
+};
+
+/*
+    Structure-of-arrays doubly connected edge list. Components are plain
+    int indices with -1 as the null reference, so traversals do not copy
+    Vertex/HalfEdge/Face objects. Accessors are only bounds checked in
+    builds without NDEBUG.
+
+    A FlatDCEL can be built from a DCEL with the same vertex, edge and face
+    indices, so code can switch between the two representations one loop
+    at a time.
+
+    The arrays are read only once the mesh is built. They are either owned
+    by the mesh or are a view of arrays held by another object, such as a
+    memory mapped mesh file, that the mesh keeps alive. Copies share the
+    same arrays.
+
+    In the compact layout, half-edges are renumbered into twin pairs so
+    that the twin of edge h is h ^ 1, and prev is found by walking next
+    around the face. edgeTwin and edgePrev are null, and each half-edge
+    stores only its origin, next and incident face. Pairs are numbered in
+    order of their first half-edge in the DCEL, with that half-edge first,
+    so loops over the edges that skip twins visit the same edges in the
+    same order in both layouts. A half-edge without a twin is paired with
+    a placeholder that has no incident face or next edge and keeps the
+    origin of the next edge, if there is one. Vertex and face indices are
+    the same in both layouts.
+*/
+class FlatDCEL {
+public:
+    FlatDCEL() {}
+    FlatDCEL(DCEL &D);
+    FlatDCEL(DCEL &D, MeshLayout layout);
+
+    // View of arrays held by storage. The array pointers are set by the
+    // caller.
+    FlatDCEL(std::shared_ptr<const void> storage, int nv, int ne, int nf);
+
+    inline int vertexCount() const {
+        return _vertexCount;
+    }
+
+    inline int edgeCount() const {
+        return _edgeCount;
+    }
+
+    inline int faceCount() const {
+        return _faceCount;
+    }
+
+    inline int origin(int h) const {
+        _checkHalfEdge(h);
+        return edgeOrigin[h];
+    }
+
+    inline int twin(int h) const {
+        _checkHalfEdge(h);
+        return _isCompact ? h ^ 1 : edgeTwin[h];
+    }
+
+    inline int next(int h) const {
+        _checkHalfEdge(h);
+        return edgeNext[h];
+    }
+
+    inline int prev(int h) const {
+        _checkHalfEdge(h);
+        return _isCompact ? _findPrev(h) : edgePrev[h];
+    }
+
+    inline int incidentFace(int h) const {
+        _checkHalfEdge(h);
+        return edgeFace[h];
+    }
+
+    inline int incidentEdge(int v) const {
+        _checkVertex(v);
+        return vertexEdge[v];
+    }
+
+    inline int outerComponent(int f) const {
+        _checkFace(f);
+        return faceEdge[f];
+    }
+
+    inline Point position(int v) const {
+        _checkVertex(v);
+        return Point(vertexX[v], vertexY[v]);
+    }
+
+    inline bool isBoundary(int h) const {
+        return incidentFace(h) == -1;
+    }
+
+    void getOuterComponents(int f, std::vector<int> &edges) const;
+    void getIncidentEdges(int v, std::vector<int> &edges) const;
+    void getIncidentFaces(int v, std::vector<int> &faces) const;
+    size_t getMemoryUsage() const;
+    size_t getMemoryUsage(MeshLayout layout) const;
+    MeshLayout getLayout() const;
+    FlatDCEL toFullLayout() const;
+    bool isView() const;
+
+    const double *vertexX = nullptr;
+    const double *vertexY = nullptr;
+    const int *vertexEdge = nullptr;
+
+    const int *edgeOrigin = nullptr;
+    const int *edgeTwin = nullptr;
+    const int *edgeNext = nullptr;
+    const int *edgePrev = nullptr;
+    const int *edgeFace = nullptr;
+
+    const int *faceEdge = nullptr;
+
+private:
+    struct _Arrays {
+        std::vector<double> vertexX;
+        std::vector<double> vertexY;
+        std::vector<int> vertexEdge;
+
+        std::vector<int> edgeOrigin;
+        std::vector<int> edgeTwin;
+        std::vector<int> edgeNext;
+        std::vector<int> edgePrev;
+        std::vector<int> edgeFace;
+
+        std::vector<int> faceEdge;
+    };
+
+    static int _getCompactEdgeMap(DCEL &D, std::vector<int> &edgeMap);
+    int _findPrev(int h) const;
+
+    inline void _checkVertex(int v) const {
+#ifndef NDEBUG
+        if (v < 0 || v >= vertexCount()) {
+            throw std::range_error("Vertex out of range: " + std::to_string(v));
+        }
+#endif
+    }
+
+    inline void _checkHalfEdge(int h) const {
+#ifndef NDEBUG
+        if (h < 0 || h >= edgeCount()) {
+            throw std::range_error("HalfEdge out of range: " + std::to_string(h));
+        }
+#endif
+    }
+
+    inline void _checkFace(int f) const {
+#ifndef NDEBUG
+        if (f < 0 || f >= faceCount()) {
+            throw std::range_error("Face out of range: " + std::to_string(f));
+        }
+#endif
+    }
+
+    int _vertexCount = 0;
+    int _edgeCount = 0;
+    int _faceCount = 0;
+    bool _isView = false;
+    bool _isCompact = false;
+    std::shared_ptr<const void> _storage;
+};
+
+}
+
+#endif
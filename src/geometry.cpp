@@ -0,0 +1,194 @@
+#include "geometry.h"
+
+namespace Geometry {
+    PredicateStats _predicateStats;
+}
+
+Geometry::PredicateStats Geometry::getPredicateStats() {
+    return _predicateStats;
+}
+
+void Geometry::resetPredicateStats() {
+    _predicateStats = PredicateStats();
+}
+
+double Geometry::_orient2dExact(dcel::Point &a, dcel::Point &b, dcel::Point &c) {
+    _Expansion acx = _differenceExpansion(a.x, c.x);
+    _Expansion acy = _differenceExpansion(a.y, c.y);
+    _Expansion bcx = _differenceExpansion(b.x, c.x);
+    _Expansion bcy = _differenceExpansion(b.y, c.y);
+
+    _Expansion left = _multiplyExpansions(acx, bcy);
+    _Expansion right = _multiplyExpansions(acy, bcx);
+    right = _negateExpansion(right);
+    _Expansion det = _sumExpansions(left, right);
+
+    return _estimateExpansion(det);
+}
+
+double Geometry::_incircleExact(dcel::Point &a, dcel::Point &b, 
+                                dcel::Point &c, dcel::Point &d) {
+    _Expansion adx = _differenceExpansion(a.x, d.x);
+    _Expansion bdx = _differenceExpansion(b.x, d.x);
+    _Expansion cdx = _differenceExpansion(c.x, d.x);
+    _Expansion ady = _differenceExpansion(a.y, d.y);
+    _Expansion bdy = _differenceExpansion(b.y, d.y);
+    _Expansion cdy = _differenceExpansion(c.y, d.y);
+
+    _Expansion *dx[3] = {&adx, &bdx, &cdx};
+    _Expansion *dy[3] = {&ady, &bdy, &cdy};
+
+    // det = sum over i of lift_i * (dx_j * dy_k - dx_k * dy_j)
+    _Expansion det;
+    for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+
+        _Expansion xx = _multiplyExpansions(*dx[i], *dx[i]);
+        _Expansion yy = _multiplyExpansions(*dy[i], *dy[i]);
+        _Expansion lift = _sumExpansions(xx, yy);
+
+        _Expansion jk = _multiplyExpansions(*dx[j], *dy[k]);
+        _Expansion kj = _multiplyExpansions(*dx[k], *dy[j]);
+        kj = _negateExpansion(kj);
+        _Expansion minor = _sumExpansions(jk, kj);
+
+        _Expansion term = _multiplyExpansions(lift, minor);
+        det = _sumExpansions(det, term);
+    }
+
+    return _estimateExpansion(det);
+}
+
+void Geometry::_twoSum(double a, double b, double *x, double *y) {
+    *x = a + b;
+    double bvirt = *x - a;
+    double avirt = *x - bvirt;
+    double bround = b - bvirt;
+    double around = a - avirt;
+    *y = around + bround;
+}
+
+// Requires |a| >= |b|
+void Geometry::_fastTwoSum(double a, double b, double *x, double *y) {
+    *x = a + b;
+    double bvirt = *x - a;
+    *y = b - bvirt;
+}
+
+void Geometry::_split(double a, double *hi, double *lo) {
+    double c = _splitter * a;
+    double abig = c - a;
+    *hi = c - abig;
+    *lo = a - *hi;
+}
+
+void Geometry::_twoProduct(double a, double b, double *x, double *y) {
+    *x = a * b;
+    double ahi, alo, bhi, blo;
+    _split(a, &ahi, &alo);
+    _split(b, &bhi, &blo);
+    double err1 = *x - (ahi * bhi);
+    double err2 = err1 - (alo * bhi);
+    double err3 = err2 - (ahi * blo);
+    *y = (alo * blo) - err3;
+}
+
+Geometry::_Expansion Geometry::_differenceExpansion(double a, double b) {
+    double x, y;
+    _twoSum(a, -b, &x, &y);
+
+    _Expansion e;
+    if (y != 0.0) {
+        e.push_back(y);
+    }
+    if (x != 0.0) {
+        e.push_back(x);
+    }
+
+    return e;
+}
+
+// Expansions are stored as nonoverlapping components in increasing order
+// of magnitude with zero components removed.
+Geometry::_Expansion Geometry::_sumExpansions(_Expansion &e, _Expansion &f) {
+    _Expansion h = e;
+    _Expansion g;
+    for (unsigned int i = 0; i < f.size(); i++) {
+        g.clear();
+        double q = f[i];
+        double hh;
+        for (unsigned int j = 0; j < h.size(); j++) {
+            _twoSum(q, h[j], &q, &hh);
+            if (hh != 0.0) {
+                g.push_back(hh);
+            }
+        }
+        if (q != 0.0) {
+            g.push_back(q);
+        }
+        h.swap(g);
+    }
+
+    return h;
+}
+
+Geometry::_Expansion Geometry::_negateExpansion(_Expansion &e) {
+    _Expansion h = e;
+    for (unsigned int i = 0; i < h.size(); i++) {
+        h[i] = -h[i];
+    }
+
+    return h;
+}
+
+Geometry::_Expansion Geometry::_scaleExpansion(_Expansion &e, double b) {
+    _Expansion h;
+    if (e.empty() || b == 0.0) {
+        return h;
+    }
+
+    double q, hh;
+    _twoProduct(e[0], b, &q, &hh);
+    if (hh != 0.0) {
+        h.push_back(hh);
+    }
+
+    for (unsigned int i = 1; i < e.size(); i++) {
+        double product1, product0, sum;
+        _twoProduct(e[i], b, &product1, &product0);
+        _twoSum(q, product0, &sum, &hh);
+        if (hh != 0.0) {
+            h.push_back(hh);
+        }
+        _fastTwoSum(product1, sum, &q, &hh);
+        if (hh != 0.0) {
+            h.push_back(hh);
+        }
+    }
+
+    if (q != 0.0) {
+        h.push_back(q);
+    }
+
+    return h;
+}
+
+Geometry::_Expansion Geometry::_multiplyExpansions(_Expansion &e, _Expansion &f) {
+    _Expansion h;
+    for (unsigned int i = 0; i < f.size(); i++) {
+        _Expansion term = _scaleExpansion(e, f[i]);
+        h = _sumExpansions(h, term);
+    }
+
+    return h;
+}
+
+// The largest component has the sign of the expansion
+double Geometry::_estimateExpansion(_Expansion &e) {
+    if (e.empty()) {
+        return 0.0;
+    }
+
+    return e.back();
+}
@@ -2,40 +2,132 @@
 #define GEOMETRY_H
 
 #include <math.h>
+#include <stdint.h>
+#include <vector>
 
 #include "dcel.h"
 
 namespace Geometry {
 
-inline bool lineIntersection(dcel::Point &p, dcel::Point &r, 
-                              dcel::Point &q, dcel::Point &s, 
-                              dcel::Point *intersect) {
-    double cross = r.x*s.y - r.y*s.x;
+/*
+    Robust geometric predicates after Shewchuk, "Adaptive Precision
+    Floating-Point Arithmetic and Fast Robust Geometric Predicates".
 
-    double eps = 1e-9;
-    if (fabs(cross) < eps) {
-        // parallel case
-        return false;
-    }
+    Each predicate is first evaluated in double precision. If the result
+    is smaller than a forward error bound, it is recomputed exactly with
+    floating point expansions, so the sign of the result is always
+    correct.
+
+    orient2d(a, b, c)       > 0 if a, b, c are in counterclockwise order,
+                            < 0 if clockwise, 0 if collinear.
+    incircle(a, b, c, d)    > 0 if d lies inside the circle through a, b, c
+                            when a, b, c are counterclockwise (the sign is
+                            reversed for clockwise), 0 if cocircular.
+*/
+
+// Predicate call counts and the number of calls that needed the exact
+// fallback. Counters are not synchronized between threads.
+struct PredicateStats {
+    uint64_t orient2dCount = 0;
+    uint64_t orient2dExactCount = 0;
+    uint64_t incircleCount = 0;
+    uint64_t incircleExactCount = 0;
+};
+
+PredicateStats getPredicateStats();
+void resetPredicateStats();
+
+// Unit roundoff and error bound coefficients from Shewchuk
+const double _epsilon = 1.1102230246251565e-16;     // 2^-53
+const double _splitter = 134217729.0;               // 2^27 + 1
+const double _ccwErrorBoundA = (3.0 + 16.0 * _epsilon) * _epsilon;
+const double _iccErrorBoundA = (10.0 + 96.0 * _epsilon) * _epsilon;
+
+extern PredicateStats _predicateStats;
+
+typedef std::vector<double> _Expansion;
+
+double _orient2dExact(dcel::Point &a, dcel::Point &b, dcel::Point &c);
+double _incircleExact(dcel::Point &a, dcel::Point &b, dcel::Point &c, dcel::Point &d);
+
+_Expansion _differenceExpansion(double a, double b);
+_Expansion _sumExpansions(_Expansion &e, _Expansion &f);
+_Expansion _negateExpansion(_Expansion &e);
+_Expansion _scaleExpansion(_Expansion &e, double b);
+_Expansion _multiplyExpansions(_Expansion &e, _Expansion &f);
+double _estimateExpansion(_Expansion &e);
+void _twoSum(double a, double b, double *x, double *y);
+void _fastTwoSum(double a, double b, double *x, double *y);
+void _split(double a, double *hi, double *lo);
+void _twoProduct(double a, double b, double *x, double *y);
+
+inline double orient2d(dcel::Point &a, dcel::Point &b, dcel::Point &c) {
+    _predicateStats.orient2dCount++;
 
-    double vx = q.x - p.x;
-    double vy = q.y - p.y;
-    double t = (vx*s.y - vy*s.x) / cross;
+    double detleft = (a.x - c.x) * (b.y - c.y);
+    double detright = (a.y - c.y) * (b.x - c.x);
+    double det = detleft - detright;
 
-    intersect->x = p.x + t*r.x;
-    intersect->y = p.y + t*r.y;
+    double detsum;
+    if (detleft > 0.0) {
+        if (detright <= 0.0) {
+            return det;
+        }
+        detsum = detleft + detright;
+    } else if (detleft < 0.0) {
+        if (detright >= 0.0) {
+            return det;
+        }
+        detsum = -detleft - detright;
+    } else {
+        return det;
+    }
+
+    double errbound = _ccwErrorBoundA * detsum;
+    if (det >= errbound || -det >= errbound) {
+        return det;
+    }
 
-    return true;
+    _predicateStats.orient2dExactCount++;
+    return _orient2dExact(a, b, c);
 }
 
-inline bool lineSegmentIntersection(dcel::Point &A, dcel::Point &B, 
-                                    dcel::Point &C, dcel::Point &D) {
-    bool c1 = (D.y-A.y)*(C.x-A.x) > (C.y-A.y)*(D.x-A.x);
-    bool c2 = (D.y-B.y)*(C.x-B.x) > (C.y-B.y)*(D.x-B.x);
-    bool c3 = (C.y-A.y)*(B.x-A.x) > (B.y-A.y)*(C.x-A.x);
-    bool c4 = (D.y-A.y)*(B.x-A.x) > (B.y-A.y)*(D.x-A.x);
+inline double incircle(dcel::Point &a, dcel::Point &b, dcel::Point &c, dcel::Point &d) {
+    _predicateStats.incircleCount++;
+
+    double adx = a.x - d.x;
+    double bdx = b.x - d.x;
+    double cdx = c.x - d.x;
+    double ady = a.y - d.y;
+    double bdy = b.y - d.y;
+    double cdy = c.y - d.y;
+
+    double bdxcdy = bdx * cdy;
+    double cdxbdy = cdx * bdy;
+    double alift = adx * adx + ady * ady;
+
+    double cdxady = cdx * ady;
+    double adxcdy = adx * cdy;
+    double blift = bdx * bdx + bdy * bdy;
+
+    double adxbdy = adx * bdy;
+    double bdxady = bdx * ady;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double det = alift * (bdxcdy - cdxbdy)
+               + blift * (cdxady - adxcdy)
+               + clift * (adxbdy - bdxady);
+
+    double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift
+                     + (fabs(cdxady) + fabs(adxcdy)) * blift
+                     + (fabs(adxbdy) + fabs(bdxady)) * clift;
+    double errbound = _iccErrorBoundA * permanent;
+    if (det > errbound || -det > errbound) {
+        return det;
+    }
 
-    return (c1 != c2) && (c3 != c4);
+    _predicateStats.incircleExactCount++;
+    return _incircleExact(a, b, c, d);
 }
 
 }
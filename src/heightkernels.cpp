@@ -0,0 +1,488 @@
+#include "heightkernels.h"
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define HEIGHTKERNELS_X86
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(HEIGHTKERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define HEIGHTKERNELS_TARGET_SSE4 __attribute__((target("sse4.1")))
+    #define HEIGHTKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define HEIGHTKERNELS_TARGET_SSE4
+    #define HEIGHTKERNELS_TARGET_AVX2
+#endif
+
+namespace HeightKernels {
+
+namespace {
+
+struct RadialParams {
+    double px;
+    double py;
+    double rsq;
+    double coef1;
+    double coef2;
+    double coef3;
+    double invradius;
+    double height;
+};
+
+struct SlopeParams {
+    double px;
+    double py;
+    double dirx;
+    double diry;
+    double radius;
+    double height;
+};
+
+enum class RadialKernel : char {
+    wyvill = 0x00,
+    linear = 0x01
+};
+
+InstructionSet detectInstructionSet() {
+#if defined(HEIGHTKERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return InstructionSet::avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return InstructionSet::sse4;
+    }
+    return InstructionSet::scalar;
+#elif defined(HEIGHTKERNELS_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    if (maxLeaf < 1) {
+        return InstructionSet::scalar;
+    }
+
+    __cpuid(info, 1);
+    bool hasSse4 = (info[2] & (1 << 19)) != 0;
+    bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+    bool hasAvx = (info[2] & (1 << 28)) != 0;
+    bool hasAvx2 = false;
+    if (maxLeaf >= 7 && hasOsxsave && hasAvx) {
+        // the OS must save the ymm registers on context switch
+        bool osSavesYmm = (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        hasAvx2 = osSavesYmm && (info[1] & (1 << 5)) != 0;
+    }
+
+    if (hasAvx2) {
+        return InstructionSet::avx2;
+    }
+    if (hasSse4) {
+        return InstructionSet::sse4;
+    }
+    return InstructionSet::scalar;
+#else
+    return InstructionSet::scalar;
+#endif
+}
+
+InstructionSet supportedInstructionSet = detectInstructionSet();
+InstructionSet currentInstructionSet = supportedInstructionSet;
+
+/*
+    Scalar reference implementations. The vector implementations below
+    evaluate exactly these expressions lane by lane.
+*/
+template<RadialKernel K, bool isRaise, bool multiply>
+inline double radialScalar(const RadialParams &p, double x, double y, double hval) {
+    double dx = x - p.px;
+    double dy = y - p.py;
+    double dsq = dx*dx + dy*dy;
+    if (dsq < p.rsq) {
+        double kernel;
+        if (K == RadialKernel::wyvill) {
+            kernel = 1.0 - p.coef1*dsq*dsq*dsq + p.coef2*dsq*dsq - p.coef3*dsq;
+        } else {
+            kernel = 1.0 - sqrt(dsq) * p.invradius;
+        }
+
+        if (multiply) {
+            return hval * p.height*kernel;
+        }
+        return isRaise ? hval + p.height*kernel : hval - p.height*kernel;
+    }
+
+    if (isRaise) {
+        return multiply ? hval * 0 : hval + 0;
+    }
+    return hval;
+}
+
+template<bool multiply>
+inline double slopeScalar(const SlopeParams &p, double x, double y, double hval) {
+    double dx = p.px - x;
+    double dy = p.py - y;
+    double dot = dx*p.dirx + dy*p.diry;
+    double distx = dx - dot*p.dirx;
+    double disty = dy - dot*p.diry;
+    double dist = sqrt(distx*distx + disty*disty);
+    dist = fmin(dist, p.radius);
+
+    double cross = dx*p.diry - dy*p.dirx;
+    double min = 0.5*p.height;
+    double max = cross < 0 ? 0 : p.height;
+    double fieldval = min + (dist / p.radius)*(max - min);
+    return multiply ? hval * fieldval : hval + fieldval;
+}
+
+template<RadialKernel K, bool isRaise, bool multiply>
+void radialScalarLoop(const RadialParams &p, const double *x, const double *y,
+                      double *h, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        h[i] = radialScalar<K, isRaise, multiply>(p, x[i], y[i], h[i]);
+    }
+}
+
+template<bool multiply>
+void slopeScalarLoop(const SlopeParams &p, const double *x, const double *y,
+                     double *h, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        h[i] = slopeScalar<multiply>(p, x[i], y[i], h[i]);
+    }
+}
+
+#ifdef HEIGHTKERNELS_X86
+
+template<RadialKernel K, bool isRaise, bool multiply>
+HEIGHTKERNELS_TARGET_SSE4
+void radialSse4(const RadialParams &p, const double *x, const double *y,
+                double *h, int n) {
+    const __m128d px = _mm_set1_pd(p.px);
+    const __m128d py = _mm_set1_pd(p.py);
+    const __m128d rsq = _mm_set1_pd(p.rsq);
+    const __m128d coef1 = _mm_set1_pd(p.coef1);
+    const __m128d coef2 = _mm_set1_pd(p.coef2);
+    const __m128d coef3 = _mm_set1_pd(p.coef3);
+    const __m128d invradius = _mm_set1_pd(p.invradius);
+    const __m128d height = _mm_set1_pd(p.height);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d zero = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), px);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i), py);
+        __m128d dsq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+        __m128d inside = _mm_cmplt_pd(dsq, rsq);
+        __m128d hval = _mm_loadu_pd(h + i);
+
+        __m128d kernel;
+        if (K == RadialKernel::wyvill) {
+            __m128d t1 = _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(coef1, dsq), dsq), dsq);
+            __m128d t2 = _mm_mul_pd(_mm_mul_pd(coef2, dsq), dsq);
+            __m128d t3 = _mm_mul_pd(coef3, dsq);
+            kernel = _mm_sub_pd(_mm_add_pd(_mm_sub_pd(one, t1), t2), t3);
+        } else {
+            kernel = _mm_sub_pd(one, _mm_mul_pd(_mm_sqrt_pd(dsq), invradius));
+        }
+
+        __m128d inval;
+        if (multiply) {
+            inval = _mm_mul_pd(_mm_mul_pd(hval, height), kernel);
+        } else if (isRaise) {
+            inval = _mm_add_pd(hval, _mm_mul_pd(height, kernel));
+        } else {
+            inval = _mm_sub_pd(hval, _mm_mul_pd(height, kernel));
+        }
+
+        __m128d outval = hval;
+        if (isRaise) {
+            outval = multiply ? _mm_mul_pd(hval, zero) : _mm_add_pd(hval, zero);
+        }
+        _mm_storeu_pd(h + i, _mm_blendv_pd(outval, inval, inside));
+    }
+    radialScalarLoop<K, isRaise, multiply>(p, x, y, h, i, n);
+}
+
+template<bool multiply>
+HEIGHTKERNELS_TARGET_SSE4
+void slopeSse4(const SlopeParams &p, const double *x, const double *y,
+               double *h, int n) {
+    const __m128d px = _mm_set1_pd(p.px);
+    const __m128d py = _mm_set1_pd(p.py);
+    const __m128d dirx = _mm_set1_pd(p.dirx);
+    const __m128d diry = _mm_set1_pd(p.diry);
+    const __m128d radius = _mm_set1_pd(p.radius);
+    const __m128d height = _mm_set1_pd(p.height);
+    const __m128d minval = _mm_set1_pd(0.5*p.height);
+    const __m128d zero = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d dx = _mm_sub_pd(px, _mm_loadu_pd(x + i));
+        __m128d dy = _mm_sub_pd(py, _mm_loadu_pd(y + i));
+        __m128d dot = _mm_add_pd(_mm_mul_pd(dx, dirx), _mm_mul_pd(dy, diry));
+        __m128d distx = _mm_sub_pd(dx, _mm_mul_pd(dot, dirx));
+        __m128d disty = _mm_sub_pd(dy, _mm_mul_pd(dot, diry));
+        __m128d dist = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(distx, distx),
+                                              _mm_mul_pd(disty, disty)));
+        dist = _mm_min_pd(dist, radius);
+
+        __m128d cross = _mm_sub_pd(_mm_mul_pd(dx, diry), _mm_mul_pd(dy, dirx));
+        __m128d maxval = _mm_blendv_pd(height, zero, _mm_cmplt_pd(cross, zero));
+        __m128d fieldval = _mm_add_pd(minval, _mm_mul_pd(_mm_div_pd(dist, radius),
+                                                         _mm_sub_pd(maxval, minval)));
+        __m128d hval = _mm_loadu_pd(h + i);
+        hval = multiply ? _mm_mul_pd(hval, fieldval) : _mm_add_pd(hval, fieldval);
+        _mm_storeu_pd(h + i, hval);
+    }
+    slopeScalarLoop<multiply>(p, x, y, h, i, n);
+}
+
+template<RadialKernel K, bool isRaise, bool multiply>
+HEIGHTKERNELS_TARGET_AVX2
+void radialAvx2(const RadialParams &p, const double *x, const double *y,
+                double *h, int n) {
+    const __m256d px = _mm256_set1_pd(p.px);
+    const __m256d py = _mm256_set1_pd(p.py);
+    const __m256d rsq = _mm256_set1_pd(p.rsq);
+    const __m256d coef1 = _mm256_set1_pd(p.coef1);
+    const __m256d coef2 = _mm256_set1_pd(p.coef2);
+    const __m256d coef3 = _mm256_set1_pd(p.coef3);
+    const __m256d invradius = _mm256_set1_pd(p.invradius);
+    const __m256d height = _mm256_set1_pd(p.height);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d zero = _mm256_setzero_pd();
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), py);
+        __m256d dsq = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        __m256d inside = _mm256_cmp_pd(dsq, rsq, _CMP_LT_OQ);
+        __m256d hval = _mm256_loadu_pd(h + i);
+
+        __m256d kernel;
+        if (K == RadialKernel::wyvill) {
+            __m256d t1 = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(coef1, dsq), dsq), dsq);
+            __m256d t2 = _mm256_mul_pd(_mm256_mul_pd(coef2, dsq), dsq);
+            __m256d t3 = _mm256_mul_pd(coef3, dsq);
+            kernel = _mm256_sub_pd(_mm256_add_pd(_mm256_sub_pd(one, t1), t2), t3);
+        } else {
+            kernel = _mm256_sub_pd(one, _mm256_mul_pd(_mm256_sqrt_pd(dsq), invradius));
+        }
+
+        __m256d inval;
+        if (multiply) {
+            inval = _mm256_mul_pd(_mm256_mul_pd(hval, height), kernel);
+        } else if (isRaise) {
+            inval = _mm256_add_pd(hval, _mm256_mul_pd(height, kernel));
+        } else {
+            inval = _mm256_sub_pd(hval, _mm256_mul_pd(height, kernel));
+        }
+
+        __m256d outval = hval;
+        if (isRaise) {
+            outval = multiply ? _mm256_mul_pd(hval, zero) : _mm256_add_pd(hval, zero);
+        }
+        _mm256_storeu_pd(h + i, _mm256_blendv_pd(outval, inval, inside));
+    }
+    radialScalarLoop<K, isRaise, multiply>(p, x, y, h, i, n);
+}
+
+template<bool multiply>
+HEIGHTKERNELS_TARGET_AVX2
+void slopeAvx2(const SlopeParams &p, const double *x, const double *y,
+               double *h, int n) {
+    const __m256d px = _mm256_set1_pd(p.px);
+    const __m256d py = _mm256_set1_pd(p.py);
+    const __m256d dirx = _mm256_set1_pd(p.dirx);
+    const __m256d diry = _mm256_set1_pd(p.diry);
+    const __m256d radius = _mm256_set1_pd(p.radius);
+    const __m256d height = _mm256_set1_pd(p.height);
+    const __m256d minval = _mm256_set1_pd(0.5*p.height);
+    const __m256d zero = _mm256_setzero_pd();
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(px, _mm256_loadu_pd(x + i));
+        __m256d dy = _mm256_sub_pd(py, _mm256_loadu_pd(y + i));
+        __m256d dot = _mm256_add_pd(_mm256_mul_pd(dx, dirx), _mm256_mul_pd(dy, diry));
+        __m256d distx = _mm256_sub_pd(dx, _mm256_mul_pd(dot, dirx));
+        __m256d disty = _mm256_sub_pd(dy, _mm256_mul_pd(dot, diry));
+        __m256d dist = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(distx, distx),
+                                                    _mm256_mul_pd(disty, disty)));
+        dist = _mm256_min_pd(dist, radius);
+
+        __m256d cross = _mm256_sub_pd(_mm256_mul_pd(dx, diry), _mm256_mul_pd(dy, dirx));
+        __m256d maxval = _mm256_blendv_pd(height, zero,
+                                          _mm256_cmp_pd(cross, zero, _CMP_LT_OQ));
+        __m256d fieldval = _mm256_add_pd(minval,
+                                         _mm256_mul_pd(_mm256_div_pd(dist, radius),
+                                                       _mm256_sub_pd(maxval, minval)));
+        __m256d hval = _mm256_loadu_pd(h + i);
+        hval = multiply ? _mm256_mul_pd(hval, fieldval) : _mm256_add_pd(hval, fieldval);
+        _mm256_storeu_pd(h + i, hval);
+    }
+    slopeScalarLoop<multiply>(p, x, y, h, i, n);
+}
+
+#endif
+
+template<RadialKernel K, bool isRaise, bool multiply>
+void radialDispatch(const RadialParams &p, const double *x, const double *y,
+                    double *h, int n) {
+#ifdef HEIGHTKERNELS_X86
+    switch (currentInstructionSet) {
+        case InstructionSet::avx2:
+            radialAvx2<K, isRaise, multiply>(p, x, y, h, n);
+            return;
+        case InstructionSet::sse4:
+            radialSse4<K, isRaise, multiply>(p, x, y, h, n);
+            return;
+        case InstructionSet::scalar:
+            break;
+    }
+#endif
+    radialScalarLoop<K, isRaise, multiply>(p, x, y, h, 0, n);
+}
+
+template<RadialKernel K, bool isRaise>
+void radial(const RadialParams &p, const double *x, const double *y,
+            double *h, int n, bool multiply) {
+    if (multiply) {
+        radialDispatch<K, isRaise, true>(p, x, y, h, n);
+    } else {
+        radialDispatch<K, isRaise, false>(p, x, y, h, n);
+    }
+}
+
+template<bool multiply>
+void slopeDispatch(const SlopeParams &p, const double *x, const double *y,
+                   double *h, int n) {
+#ifdef HEIGHTKERNELS_X86
+    switch (currentInstructionSet) {
+        case InstructionSet::avx2:
+            slopeAvx2<multiply>(p, x, y, h, n);
+            return;
+        case InstructionSet::sse4:
+            slopeSse4<multiply>(p, x, y, h, n);
+            return;
+        case InstructionSet::scalar:
+            break;
+    }
+#endif
+    slopeScalarLoop<multiply>(p, x, y, h, 0, n);
+}
+
+RadialParams wyvillParams(double px, double py, double rsq,
+                          double coef1, double coef2, double coef3,
+                          double height) {
+    RadialParams p;
+    p.px = px;
+    p.py = py;
+    p.rsq = rsq;
+    p.coef1 = coef1;
+    p.coef2 = coef2;
+    p.coef3 = coef3;
+    p.invradius = 0.0;
+    p.height = height;
+    return p;
+}
+
+RadialParams linearParams(double px, double py, double rsq, double invradius,
+                          double height) {
+    RadialParams p;
+    p.px = px;
+    p.py = py;
+    p.rsq = rsq;
+    p.coef1 = 0.0;
+    p.coef2 = 0.0;
+    p.coef3 = 0.0;
+    p.invradius = invradius;
+    p.height = height;
+    return p;
+}
+
+}
+
+InstructionSet getSupportedInstructionSet() {
+    return supportedInstructionSet;
+}
+
+InstructionSet getInstructionSet() {
+    return currentInstructionSet;
+}
+
+void setInstructionSet(InstructionSet iset) {
+    if ((char)iset > (char)supportedInstructionSet) {
+        iset = supportedInstructionSet;
+    }
+    currentInstructionSet = iset;
+}
+
+std::string getInstructionSetName(InstructionSet iset) {
+    switch (iset) {
+        case InstructionSet::scalar:
+            return "scalar";
+        case InstructionSet::sse4:
+            return "sse4";
+        case InstructionSet::avx2:
+            return "avx2";
+    }
+    return "scalar";
+}
+
+void hill(const double *x, const double *y, double *h, int n,
+          double px, double py, double rsq,
+          double coef1, double coef2, double coef3,
+          double height, bool multiply) {
+    RadialParams p = wyvillParams(px, py, rsq, coef1, coef2, coef3, height);
+    radial<RadialKernel::wyvill, true>(p, x, y, h, n, multiply);
+}
+
+void depression(const double *x, const double *y, double *h, int n,
+                double px, double py, double rsq,
+                double coef1, double coef2, double coef3,
+                double height, bool multiply) {
+    RadialParams p = wyvillParams(px, py, rsq, coef1, coef2, coef3, height);
+    radial<RadialKernel::wyvill, false>(p, x, y, h, n, multiply);
+}
+
+void cone(const double *x, const double *y, double *h, int n,
+          double px, double py, double rsq, double invradius,
+          double height, bool multiply) {
+    RadialParams p = linearParams(px, py, rsq, invradius, height);
+    radial<RadialKernel::linear, true>(p, x, y, h, n, multiply);
+}
+
+void pit(const double *x, const double *y, double *h, int n,
+         double px, double py, double rsq, double invradius,
+         double height, bool multiply) {
+    // a multiplied pit scales by -height, and negation is exact
+    double scale = multiply ? -height : height;
+    RadialParams p = linearParams(px, py, rsq, invradius, scale);
+    radial<RadialKernel::linear, false>(p, x, y, h, n, multiply);
+}
+
+void slope(const double *x, const double *y, double *h, int n,
+           double px, double py, double dirx, double diry,
+           double radius, double height, bool multiply) {
+    SlopeParams p;
+    p.px = px;
+    p.py = py;
+    p.dirx = dirx;
+    p.diry = diry;
+    p.radius = radius;
+    p.height = height;
+    if (multiply) {
+        slopeDispatch<true>(p, x, y, h, n);
+    } else {
+        slopeDispatch<false>(p, x, y, h, n);
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef HEIGHTKERNELS_H
+#define HEIGHTKERNELS_H
+
+#include <stdio.h>
+#include <string>
+
+/*
+    Vectorized height map primitives over contiguous x, y and height arrays.
+
+    Each kernel has scalar, SSE4.1 and AVX2 implementations, and the widest
+    one supported by the processor is selected at runtime. The vector
+    implementations evaluate the same expressions in the same order as the
+    scalar ones using only correctly rounded operations (add, subtract,
+    multiply, divide, sqrt, compare, min), and no fused multiply-add, so
+    all implementations produce bit-identical results: the tolerance
+    between them is zero ulp.
+*/
+namespace HeightKernels {
+
+enum class InstructionSet : char {
+    scalar = 0x00,
+    sse4 = 0x01,
+    avx2 = 0x02
+};
+
+// Widest instruction set supported by the processor and operating system
+InstructionSet getSupportedInstructionSet();
+
+// Instruction set used by the kernels. Defaults to the supported set.
+InstructionSet getInstructionSet();
+
+// Limit the kernels to iset. Sets wider than the supported set are
+// clamped to the supported set.
+void setInstructionSet(InstructionSet iset);
+
+std::string getInstructionSetName(InstructionSet iset);
+
+/*
+    Rounded hill (raise) or depression (lower) using the Wyvill kernel
+        k = 1 - coef1*d^6 + coef2*d^4 - coef3*d^2
+    for points with squared distance d^2 < rsq from (px, py).
+
+    hill:       h + height*k, or h*height*k when multiplying. Points
+                outside the radius become h + 0, or h*0 when multiplying.
+    depression: h - height*k, or h*height*k when multiplying. Points
+                outside the radius are unchanged.
+*/
+void hill(const double *x, const double *y, double *h, int n,
+          double px, double py, double rsq,
+          double coef1, double coef2, double coef3,
+          double height, bool multiply);
+void depression(const double *x, const double *y, double *h, int n,
+                double px, double py, double rsq,
+                double coef1, double coef2, double coef3,
+                double height, bool multiply);
+
+/*
+    Cone (raise) or pit (lower) using the linear kernel
+        k = 1 - d*invradius
+
+    cone: h + height*k, or h*height*k when multiplying. Points outside
+          the radius become h + 0, or h*0 when multiplying.
+    pit:  h - height*k, or h*(-height)*k when multiplying. Points outside
+          the radius are unchanged.
+*/
+void cone(const double *x, const double *y, double *h, int n,
+          double px, double py, double rsq, double invradius,
+          double height, bool multiply);
+void pit(const double *x, const double *y, double *h, int n,
+         double px, double py, double rsq, double invradius,
+         double height, bool multiply);
+
+/*
+    Slope parallel to the line through (px, py) with unit direction
+    (dirx, diry). The field value varies linearly with the distance to
+    the line up to radius, from 0.5*height to 0 on the left of the line
+    and to height on the right.
+*/
+void slope(const double *x, const double *y, double *h, int n,
+           double px, double py, double dirx, double diry,
+           double radius, double height, bool multiply);
+
+}
+
+#endif
@@ -0,0 +1,343 @@
+#include "heightprogram.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "heightkernels.h"
+#include "parallel.h"
+
+void gen::HeightProgram::addHill(double px, double py, double r,
+                                 double height, bool multiply) {
+    // coefficients for the Wyvill kernel function
+    HeightOperation op;
+    op.type = HeightOperationType::hill;
+    op.multiply = multiply;
+    op.px = px;
+    op.py = py;
+    op.height = height;
+    op.coef1 = (4.0 / 9.0)*(1.0 / (r*r*r*r*r*r));
+    op.coef2 = (17.0 / 9.0)*(1.0 / (r*r*r*r));
+    op.coef3 = (22.0 / 9.0)*(1.0 / (r*r));
+    op.rsq = r*r;
+    op.isLocal = !multiply;
+    _operations.push_back(op);
+}
+
+void gen::HeightProgram::addCone(double px, double py, double radius,
+                                 double height, bool multiply) {
+    HeightOperation op;
+    op.type = HeightOperationType::cone;
+    op.multiply = multiply;
+    op.px = px;
+    op.py = py;
+    op.height = height;
+    op.invradius = 1.0 / radius;
+    op.rsq = radius * radius;
+    op.isLocal = !multiply;
+    _operations.push_back(op);
+}
+
+void gen::HeightProgram::addDepression(double px, double py, double r,
+                                       double height, bool multiply) {
+    addHill(px, py, r, height, multiply);
+    _operations.back().type = HeightOperationType::depression;
+    _operations.back().isLocal = true;
+}
+
+void gen::HeightProgram::addPit(double px, double py, double radius,
+                                double height, bool multiply) {
+    addCone(px, py, radius, height, multiply);
+    _operations.back().type = HeightOperationType::pit;
+    _operations.back().isLocal = true;
+}
+
+void gen::HeightProgram::addSlope(double px, double py, double dirx, double diry,
+                                  double radius, double height, bool multiply) {
+    HeightOperation op;
+    op.type = HeightOperationType::slope;
+    op.multiply = multiply;
+    op.px = px;
+    op.py = py;
+    op.dirx = dirx;
+    op.diry = diry;
+    op.radius = radius;
+    op.height = height;
+    _operations.push_back(op);
+}
+
+void gen::HeightProgram::addNoise(NoiseField &noise, double strength, bool multiply) {
+    HeightOperation op;
+    op.type = HeightOperationType::noise;
+    op.multiply = multiply;
+    op.height = strength;
+    op.noiseIndex = (int)_noises.size();
+    _noises.push_back(noise);
+    _operations.push_back(op);
+}
+
+void gen::HeightProgram::addContinent(NoiseField &noise, Extents2d extents,
+                                      double minDist, double scalar) {
+    HeightOperation op;
+    op.type = HeightOperationType::continent;
+    op.extents = extents;
+    op.minDist = minDist;
+    op.scalar = scalar;
+    op.noiseIndex = (int)_noises.size();
+    _noises.push_back(noise);
+    _operations.push_back(op);
+}
+
+int gen::HeightProgram::size() {
+    return (int)_operations.size();
+}
+
+bool gen::HeightProgram::empty() {
+    return _operations.empty();
+}
+
+void gen::HeightProgram::clear() {
+    _operations.clear();
+    _noises.clear();
+}
+
+gen::HeightProgram gen::HeightProgram::slice(int begin, int end) {
+    HeightProgram program;
+    for (int i = begin; i < end; i++) {
+        HeightOperation op = _operations[i];
+        if (op.noiseIndex != -1) {
+            program._noises.push_back(_noises[op.noiseIndex]);
+            op.noiseIndex = (int)program._noises.size() - 1;
+        }
+        program._operations.push_back(op);
+    }
+    return program;
+}
+
+void gen::HeightProgram::append(HeightProgram &other) {
+    int noiseOffset = (int)_noises.size();
+    _noises.insert(_noises.end(), other._noises.begin(), other._noises.end());
+    for (unsigned int i = 0; i < other._operations.size(); i++) {
+        HeightOperation op = other._operations[i];
+        if (op.noiseIndex != -1) {
+            op.noiseIndex += noiseOffset;
+        }
+        _operations.push_back(op);
+    }
+}
+
+bool gen::HeightProgram::isLocal() {
+    for (unsigned int i = 0; i < _operations.size(); i++) {
+        if (!_operations[i].isLocal) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+    The extents are padded slightly so that a vertex strictly inside a
+    disc is strictly inside its extents despite rounding in sqrt(rsq).
+*/
+bool gen::HeightProgram::getExtents(Extents2d &extents) {
+    if (_operations.empty()) {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < _operations.size(); i++) {
+        HeightOperation &op = _operations[i];
+        double r = sqrt(op.rsq) * (1.0 + 1e-9) + 1e-12;
+        Extents2d e(op.px - r, op.py - r, op.px + r, op.py + r);
+        if (i == 0) {
+            extents = e;
+            continue;
+        }
+        extents.minx = fmin(extents.minx, e.minx);
+        extents.miny = fmin(extents.miny, e.miny);
+        extents.maxx = fmax(extents.maxx, e.maxx);
+        extents.maxy = fmax(extents.maxy, e.maxy);
+    }
+    return true;
+}
+
+/*
+    The program is applied one grid cell at a time. The heights of a cell
+    are gathered into a contiguous buffer alongside the cell positions so
+    that the kernels run over x, y and height arrays, and are written back
+    once all operations have been applied. Operations that only change
+    vertices inside their radius skip the cells that do not reach the
+    radius.
+
+    Cells are independent, so large grids are split into contiguous runs of
+    cells across up to numThreads threads.
+*/
+void gen::HeightProgram::execute(VertexGrid &grid, LayerValue *heights, int numThreads) {
+    if (_operations.empty()) {
+        return;
+    }
+
+    if (grid.getVertexCount() < _minParallelVertexCount) {
+        numThreads = 1;
+    }
+
+    Parallel::forEachRange(0, grid.getCellCount(), numThreads,
+        [this, &grid, heights](int begin, int end, int) {
+            _executeCells(grid, begin, end, heights);
+        }
+    );
+}
+
+void gen::HeightProgram::_executeCells(VertexGrid &grid, int begin, int end,
+                                       LayerValue *heights) {
+    const double *xs = grid.getX();
+    const double *ys = grid.getY();
+    std::vector<double> buffer;
+    for (int c = begin; c < end; c++) {
+        IndexRange cell = grid.getCell(c);
+        if (cell.empty()) {
+            continue;
+        }
+
+        int count = cell.size();
+        int offset = grid.getCellOffset(c);
+        buffer.resize(count);
+        for (int k = 0; k < count; k++) {
+            buffer[k] = heights[cell[k]];
+        }
+
+        for (unsigned int i = 0; i < _operations.size(); i++) {
+            HeightOperation &op = _operations[i];
+            if (op.isLocal && !grid.isCellInDisc(c, op.px, op.py, op.rsq)) {
+                continue;
+            }
+            _executeOperation(op, xs + offset, ys + offset, buffer.data(), count);
+            _roundToStorage(buffer.data(), count);
+        }
+
+        for (int k = 0; k < count; k++) {
+            heights[cell[k]] = (LayerValue)buffer[k];
+        }
+    }
+}
+
+void gen::HeightProgram::execute(const int *indices, const double *xs, const double *ys,
+                                 int count, LayerValue *heights) {
+    std::vector<double> buffer(count);
+    for (int k = 0; k < count; k++) {
+        buffer[k] = heights[indices[k]];
+    }
+
+    for (unsigned int i = 0; i < _operations.size(); i++) {
+        _executeOperation(_operations[i], xs, ys, buffer.data(), count);
+        _roundToStorage(buffer.data(), count);
+    }
+
+    for (int k = 0; k < count; k++) {
+        heights[indices[k]] = (LayerValue)buffer[k];
+    }
+}
+
+/*
+    Round to storage precision between operations so that the result
+    matches storing the height map after each primitive
+*/
+void gen::HeightProgram::_roundToStorage(double *h, int count) {
+    if (sizeof(LayerValue) == sizeof(double)) {
+        return;
+    }
+    for (int k = 0; k < count; k++) {
+        h[k] = (LayerValue)h[k];
+    }
+}
+
+void gen::HeightProgram::_executeOperation(HeightOperation &op,
+                                           const double *xs, const double *ys,
+                                           double *h, int count) {
+    switch (op.type) {
+        case HeightOperationType::hill:
+            HeightKernels::hill(xs, ys, h, count, op.px, op.py, op.rsq,
+                                op.coef1, op.coef2, op.coef3, op.height, op.multiply);
+            break;
+        case HeightOperationType::cone:
+            HeightKernels::cone(xs, ys, h, count, op.px, op.py, op.rsq,
+                                op.invradius, op.height, op.multiply);
+            break;
+        case HeightOperationType::depression:
+            HeightKernels::depression(xs, ys, h, count, op.px, op.py, op.rsq,
+                                      op.coef1, op.coef2, op.coef3, op.height, op.multiply);
+            break;
+        case HeightOperationType::pit:
+            HeightKernels::pit(xs, ys, h, count, op.px, op.py, op.rsq,
+                               op.invradius, op.height, op.multiply);
+            break;
+        case HeightOperationType::slope:
+            HeightKernels::slope(xs, ys, h, count, op.px, op.py, op.dirx, op.diry,
+                                 op.radius, op.height, op.multiply);
+            break;
+        case HeightOperationType::noise:
+            _applyNoise(op, xs, ys, h, count);
+            break;
+        case HeightOperationType::continent:
+            _applyContinent(op, xs, ys, h, count);
+            break;
+    }
+}
+
+void gen::HeightProgram::_applyNoise(HeightOperation &op,
+                                     const double *xs, const double *ys,
+                                     double *heights, int count) {
+    NoiseField &noise = _noises[op.noiseIndex];
+    double values[_noiseBlockSize];
+    for (int start = 0; start < count; start += _noiseBlockSize) {
+        int blockCount = std::min(count - start, (int)_noiseBlockSize);
+        noise.fillNoise(xs + start, ys + start, values, blockCount);
+        for (int k = 0; k < blockCount; k++) {
+            int i = start + k;
+            double h = heights[i];
+            double n = values[k];
+            if (!op.multiply) {
+                heights[i] = h + op.height*n;
+            } else {
+                heights[i] = h * op.height*n;
+            }
+        }
+    }
+}
+
+/*
+    Lower the height towards the map edges, where the distance at which
+    the falloff starts is perturbed by noise
+*/
+void gen::HeightProgram::_applyContinent(HeightOperation &op,
+                                         const double *xs, const double *ys,
+                                         double *heights, int count) {
+    NoiseField &noiseGen = _noises[op.noiseIndex];
+    Extents2d &e = op.extents;
+    double values[_noiseBlockSize];
+    for (int start = 0; start < count; start += _noiseBlockSize) {
+        int blockCount = std::min(count - start, (int)_noiseBlockSize);
+        noiseGen.fillNoise(xs + start, ys + start, values, blockCount);
+        for (int k = 0; k < blockCount; k++) {
+            int i = start + k;
+            double h = heights[i];
+            dcel::Point p(xs[i], ys[i]);
+
+            double dist = fabs(e.minx - p.x);
+            if (fabs(e.maxx - p.x) < dist) {
+                dist = fabs(e.maxx - p.x);
+            }
+            if (fabs(e.maxy - p.y) < dist) {
+                dist = fabs(e.maxy - p.y);
+            }
+            if (fabs(e.miny - p.y) < dist) {
+                dist = fabs(e.miny - p.y);
+            }
+            double noise = op.scalar * values[k];
+            if (dist <= op.minDist + noise) {
+                heights[i] = h - (1/pow(op.minDist + noise, 2));
+            } else {
+                heights[i] = h - (1/pow(dist, 2));
+            }
+        }
+    }
+}
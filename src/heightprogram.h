@@ -0,0 +1,128 @@
+#ifndef HEIGHTPROGRAM_H
+#define HEIGHTPROGRAM_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+
+#include "dcel.h"
+#include "extents2d.h"
+#include "fastnoise.h"
+#include "nodemap.h"
+#include "noisefield.h"
+#include "vertexgrid.h"
+
+namespace gen {
+
+enum class HeightOperationType : char {
+    hill = 0x00,
+    cone = 0x01,
+    depression = 0x02,
+    pit = 0x03,
+    slope = 0x04,
+    noise = 0x05,
+    continent = 0x06
+};
+
+/*
+    A height map primitive with its per-call setup already done. Fields
+    that an operation does not use are left at zero.
+*/
+struct HeightOperation {
+    HeightOperationType type = HeightOperationType::hill;
+    bool multiply = false;
+    bool isLocal = false;     // only changes vertices closer than sqrt(rsq)
+    double px = 0.0;
+    double py = 0.0;
+    double dirx = 0.0;
+    double diry = 0.0;
+    double radius = 0.0;
+    double height = 0.0;
+    double rsq = 0.0;
+    double invradius = 0.0;
+    double coef1 = 0.0;
+    double coef2 = 0.0;
+    double coef3 = 0.0;
+    double minDist = 0.0;
+    double scalar = 0.0;
+    Extents2d extents;
+    int noiseIndex = -1;
+};
+
+/*
+    Sequence of pointwise height map primitives. Each primitive sets the
+    height of a vertex from its position and its current height only, so
+    the whole sequence can be applied to one cell of a VertexGrid while it
+    stays in cache before moving on to the next cell, instead of sweeping
+    the full height map once per primitive. Radial primitives that leave
+    vertices outside their radius unchanged skip the cells they cannot
+    reach.
+
+    Operations are applied to each vertex in the order they were added and
+    evaluate the same expressions as the individual MapGenerator primitives,
+    so the result is bit-identical to applying them one after another. The
+    radial and slope primitives run on the vectorized HeightKernels.
+*/
+class HeightProgram {
+
+public:
+    HeightProgram() {}
+
+    void addHill(double px, double py, double r, double height, bool multiply);
+    void addCone(double px, double py, double radius, double height, bool multiply);
+    void addDepression(double px, double py, double r, double height, bool multiply);
+    void addPit(double px, double py, double radius, double height, bool multiply);
+    void addSlope(double px, double py, double dirx, double diry,
+                  double radius, double height, bool multiply);
+    void addNoise(NoiseField &noise, double strength, bool multiply);
+    void addContinent(NoiseField &noise, Extents2d extents,
+                      double minDist, double scalar);
+
+    int size();
+    bool empty();
+    void clear();
+
+    // Operations [begin, end) as a new program
+    HeightProgram slice(int begin, int end);
+    void append(HeightProgram &other);
+
+    // true if every operation only changes vertices inside its radius
+    bool isLocal();
+
+    // Bounds of the discs of the operations. Only meaningful when the
+    // program is local. Returns false if the program is empty.
+    bool getExtents(Extents2d &extents);
+
+    void execute(VertexGrid &grid, LayerValue *heights, int numThreads = 1);
+
+    // Apply the program to the listed vertices only, with positions
+    // (xs[k], ys[k]) for vertex indices[k]
+    void execute(const int *indices, const double *xs, const double *ys,
+                 int count, LayerValue *heights);
+
+private:
+    void _executeCells(VertexGrid &grid, int begin, int end, LayerValue *heights);
+    void _roundToStorage(double *h, int count);
+    void _executeOperation(HeightOperation &op,
+                           const double *xs, const double *ys,
+                           double *h, int count);
+    void _applyNoise(HeightOperation &op,
+                     const double *xs, const double *ys,
+                     double *heights, int count);
+    void _applyContinent(HeightOperation &op,
+                         const double *xs, const double *ys,
+                         double *heights, int count);
+
+    // grids with fewer vertices are executed on the calling thread
+    int _minParallelVertexCount = 65536;
+
+    // noise operations evaluate their noise in batches of this many points
+    static const int _noiseBlockSize = 256;
+
+    std::vector<HeightOperation> _operations;
+    std::vector<NoiseField> _noises;
+};
+
+}
+
+#endif
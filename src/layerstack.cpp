@@ -0,0 +1,161 @@
+#include "layerstack.h"
+
+gen::LayerStack::LayerStack(std::shared_ptr<VertexMap> vertexMap,
+                            LayerLayout layout, int blockSize) :
+                            _vertexMap(vertexMap), _layout(layout) {
+    _size = (int)_vertexMap->size();
+    if (_layout == LayerLayout::aosoa) {
+        if (blockSize <= 0 || (blockSize & (blockSize - 1)) != 0) {
+            throw std::runtime_error("LayerStack block size must be a power of two: " +
+                                     std::to_string(blockSize));
+        }
+
+        _blockShift = 0;
+        while ((1 << _blockShift) < blockSize) {
+            _blockShift++;
+        }
+    }
+}
+
+int gen::LayerStack::size() const {
+    return _size;
+}
+
+gen::LayerLayout gen::LayerStack::layout() const {
+    return _layout;
+}
+
+bool gen::LayerStack::hasChannel(std::string name) const {
+    return _findChannel(name) != nullptr;
+}
+
+std::vector<std::string> gen::LayerStack::getChannelNames() const {
+    std::vector<std::string> names;
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        names.push_back(_channels[i].name);
+    }
+    return names;
+}
+
+size_t gen::LayerStack::getMemoryUsage() const {
+    return _arena.capacity() * sizeof(uint64_t) +
+           _channels.capacity() * sizeof(_Channel);
+}
+
+gen::LayerStack gen::LayerStack::snapshot(std::vector<std::string> names) const {
+    LayerStack s;
+    s._vertexMap = _vertexMap;
+    s._layout = _layout;
+    s._size = _size;
+    s._blockShift = _blockShift;
+    for (unsigned int i = 0; i < names.size(); i++) {
+        const _Channel *c = _findChannel(names[i]);
+        if (c == nullptr) {
+            throw std::runtime_error("LayerStack channel does not exist: " + names[i]);
+        }
+        if (s.hasChannel(names[i])) {
+            continue;
+        }
+        s._channels.push_back(*c);
+    }
+
+    s._allocate();
+    for (unsigned int i = 0; i < s._channels.size(); i++) {
+        const _Channel *c = _findChannel(s._channels[i].name);
+        s._copyChannel((const char*)_arena.data(), _blockStride, *c, s._channels[i]);
+    }
+
+    return s;
+}
+
+void gen::LayerStack::restore(const LayerStack &snapshot) {
+    if (snapshot._size != _size || snapshot._layout != _layout ||
+            snapshot._blockShift != _blockShift) {
+        throw std::runtime_error("LayerStack snapshot does not match the stack layout.");
+    }
+
+    for (unsigned int i = 0; i < snapshot._channels.size(); i++) {
+        const _Channel &src = snapshot._channels[i];
+        _Channel &dst = _getChannel(src.name);
+        if (*dst.type != *src.type) {
+            throw std::runtime_error("LayerStack channel type does not match: " + src.name);
+        }
+        _copyChannel((const char*)snapshot._arena.data(), snapshot._blockStride, src, dst);
+    }
+}
+
+/*
+    Adding a channel lays out the arena again. Existing channel data is
+    moved to the new arena, so views taken before the call are invalidated.
+*/
+void gen::LayerStack::_addChannel(_Channel channel) {
+    std::vector<uint64_t> oldArena;
+    oldArena.swap(_arena);
+    size_t oldStride = _blockStride;
+    std::vector<_Channel> oldChannels = _channels;
+
+    _channels.push_back(channel);
+    _allocate();
+    for (unsigned int i = 0; i < oldChannels.size(); i++) {
+        _copyChannel((const char*)oldArena.data(), oldStride, oldChannels[i], _channels[i]);
+    }
+}
+
+void gen::LayerStack::_allocate() {
+    size_t offset = 0;
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        _channels[i].offset = offset;
+        offset += _getChannelBlockSize(_channels[i]);
+    }
+    _blockStride = offset;
+
+    size_t bytes = (size_t)_getBlockCount() * _blockStride;
+    _arena.assign((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+}
+
+gen::LayerStack::_Channel& gen::LayerStack::_getChannel(std::string name) {
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        if (_channels[i].name == name) {
+            return _channels[i];
+        }
+    }
+    throw std::runtime_error("LayerStack channel does not exist: " + name);
+}
+
+const gen::LayerStack::_Channel* gen::LayerStack::_findChannel(std::string name) const {
+    for (unsigned int i = 0; i < _channels.size(); i++) {
+        if (_channels[i].name == name) {
+            return &_channels[i];
+        }
+    }
+    return nullptr;
+}
+
+int gen::LayerStack::_getBlockCount() const {
+    if (_layout == LayerLayout::soa) {
+        return _size > 0 ? 1 : 0;
+    }
+    int blockSize = 1 << _blockShift;
+    return (_size + blockSize - 1) / blockSize;
+}
+
+int gen::LayerStack::_getBlockElementCount() const {
+    return _layout == LayerLayout::soa ? _size : 1 << _blockShift;
+}
+
+size_t gen::LayerStack::_getChannelBlockSize(const _Channel &c) const {
+    size_t bytes = (size_t)_getBlockElementCount() * c.elementSize;
+    return (bytes + _alignment - 1) / _alignment * _alignment;
+}
+
+void gen::LayerStack::_copyChannel(const char *src, size_t srcStride,
+                                   const _Channel &srcChannel,
+                                   const _Channel &dstChannel) {
+    char *dst = (char*)_arena.data();
+    size_t bytes = (size_t)_getBlockElementCount() * dstChannel.elementSize;
+    int nblocks = _getBlockCount();
+    for (int b = 0; b < nblocks; b++) {
+        memcpy(dst + b * _blockStride + dstChannel.offset,
+               src + b * srcStride + srcChannel.offset, bytes);
+    }
+}
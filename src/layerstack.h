@@ -0,0 +1,152 @@
+#ifndef LAYERSTACK_H
+#define LAYERSTACK_H
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <typeinfo>
+#include <stdexcept>
+
+#include "vertexmap.h"
+
+namespace gen {
+
+/*
+    soa:   each channel is one contiguous array of node values
+    aosoa: nodes are grouped into blocks, and a block stores blockSize
+           values of each channel one after the other, so all channels of
+           a node are within a few cache lines of each other
+*/
+enum class LayerLayout : char {
+    soa = 0x00,
+    aosoa = 0x01
+};
+
+/*
+    Unchecked handle to one channel of a LayerStack, indexed by vertex map
+    index like a NodeMap. Views are cheap to copy and remain valid until a
+    channel is added to the stack or the stack is destroyed.
+*/
+template <class T>
+class LayerView {
+public:
+    LayerView() {}
+    LayerView(char *base, int size, int blockShift, size_t blockStride) :
+            _base(base), _size(size),
+            _blockShift(blockShift),
+            _blockMask((1 << blockShift) - 1),
+            _blockStride(blockStride) {}
+
+    inline int size() const {
+        return _size;
+    }
+
+    inline T& operator[](int i) const {
+        size_t offset = (size_t)(i >> _blockShift) * _blockStride +
+                        (size_t)(i & _blockMask) * sizeof(T);
+        return *(T*)(_base + offset);
+    }
+
+    void fill(T value) const {
+        for (int i = 0; i < _size; i++) {
+            (*this)[i] = value;
+        }
+    }
+
+private:
+    char *_base = nullptr;
+    int _size = 0;
+    int _blockShift = 0;
+    int _blockMask = 0;
+    size_t _blockStride = 0;
+};
+
+/*
+    Named per-vertex channels allocated in a single arena over the shared
+    vertex map topology. Channels may have different element types.
+
+    Passes that read and write several channels of the same node touch one
+    block per node group in the aosoa layout instead of one array per
+    channel. New channels are zero filled.
+*/
+class LayerStack {
+
+public:
+    LayerStack() {}
+    LayerStack(std::shared_ptr<VertexMap> vertexMap,
+               LayerLayout layout = LayerLayout::soa,
+               int blockSize = _defaultBlockSize);
+
+    template <class T>
+    void addChannel(std::string name) {
+        if (hasChannel(name)) {
+            throw std::runtime_error("LayerStack channel already exists: " + name);
+        }
+
+        _Channel c;
+        c.name = name;
+        c.elementSize = sizeof(T);
+        c.type = &typeid(T);
+        _addChannel(c);
+    }
+
+    template <class T>
+    LayerView<T> getChannel(std::string name) {
+        _Channel &c = _getChannel(name);
+        if (*c.type != typeid(T)) {
+            throw std::runtime_error("LayerStack channel type does not match: " + name);
+        }
+        char *base = (char*)_arena.data() + c.offset;
+        return LayerView<T>(base, _size, _blockShift, _blockStride);
+    }
+
+    int size() const;
+    LayerLayout layout() const;
+    bool hasChannel(std::string name) const;
+    std::vector<std::string> getChannelNames() const;
+    size_t getMemoryUsage() const;
+
+    // Copy of the selected channels in a new stack with the same layout
+    LayerStack snapshot(std::vector<std::string> names) const;
+
+    // Overwrite channels with the values of the same channels in snapshot
+    void restore(const LayerStack &snapshot);
+
+private:
+    struct _Channel {
+        std::string name;
+        size_t elementSize = 0;
+        size_t offset = 0;        // byte offset of the channel within a block
+        const std::type_info *type = nullptr;
+    };
+
+    void _addChannel(_Channel channel);
+    void _allocate();
+    _Channel& _getChannel(std::string name);
+    const _Channel* _findChannel(std::string name) const;
+    int _getBlockCount() const;
+    int _getBlockElementCount() const;
+    size_t _getChannelBlockSize(const _Channel &c) const;
+    void _copyChannel(const char *src, size_t srcStride,
+                      const _Channel &srcChannel, const _Channel &dstChannel);
+
+    static const int _defaultBlockSize = 64;
+    static const int _soaBlockShift = 30;
+    static const size_t _alignment = 64;
+
+    std::shared_ptr<VertexMap> _vertexMap;
+    LayerLayout _layout = LayerLayout::soa;
+    int _size = 0;
+    int _blockShift = _soaBlockShift;
+    size_t _blockStride = 0;
+    std::vector<_Channel> _channels;
+    std::vector<uint64_t> _arena;
+};
+
+}
+
+#endif
@@ -4,11 +4,14 @@
 #include <iostream>
 #include <sstream>
 #include <random>
+#include <thread>
+#include <chrono>
 
 #include "render.h"
 #include "config.h"
 #include "stopwatch.h"
 #include "mapgenerator.h"
+#include "heightkernels.h"
 
 double randomDouble(double min, double max) {
     return min + (double)rand() / ((double)RAND_MAX / (max - min));
@@ -121,6 +124,7 @@ void initializeHeightmap(gen::MapGenerator &map) {
     Extents2d expandedExtents(extents.minx - pad, extents.miny - pad/ratio,
                               extents.maxx + pad, extents.maxy + pad/ratio);
     
+    map.beginHeightProgram();
     int n = (int)randomDouble(100, 250);
     double minr = 1.0;
     double maxr = 4.0;
@@ -191,6 +195,7 @@ void initializeHeightmap(gen::MapGenerator &map) {
     std::vector<double> params = {frequency, noise,  0.};
     gen::MapInstruction instruction("addNoise", params);
     map.addInstruction(instruction);
+    map.endHeightProgram();
     
     if (randomDouble(0, 1) > 0.5) {
         map.normalize();
@@ -279,6 +284,94 @@ void addTowns(gen::MapGenerator &map, int numTowns,
     }
 }
 
+void addSettlements(gen::MapGenerator &map) {
+    int numCities = (int)randomDouble(3, 7);
+    int numTowns = (int)randomDouble(8, 25);
+    if (gen::config::numCities >= 0) { numCities = gen::config::numCities; }
+    if (gen::config::numTowns >= 0) { numTowns = gen::config::numTowns; }
+    if (!gen::config::enableCities) { numCities = 0; }
+    if (!gen::config::enableTowns) { numTowns = 0; }
+
+    int numLabels = 2*numCities + numTowns;
+    std::vector<std::string> labelNames = getLabelNames(numLabels);
+
+    gen::config::print("Generating " + gen::config::toString(numCities) +
+                       " cities...");
+    StopWatch timer;
+    timer.start();
+    addCities(map, numCities, labelNames);
+    timer.stop();
+    gen::config::print("Finished generating cities in " +
+                       gen::config::toString(timer.getTime()) + " seconds.\n");
+
+    gen::config::print("Generating " + gen::config::toString(numTowns) +
+                       " towns...");
+    timer.reset();
+    timer.start();
+    addTowns(map, numTowns, labelNames);
+    timer.stop();
+    gen::config::print("Finished generating towns in " +
+                       gen::config::toString(timer.getTime()) + " seconds.\n");
+
+}
+
+std::string readFileContents(std::string filename) {
+    std::ifstream file(filename);
+    return std::string((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+}
+
+/*
+    Regenerate the map each time the instruction input file changes,
+    resuming the instructions from the last height map checkpoint before
+    the first changed instruction. Cities and towns are placed from the
+    same random state after each change so that they only move where the
+    terrain changes.
+*/
+void watchInstructions(gen::MapGenerator &map) {
+    std::string filename = gen::config::instructionFile;
+    std::string contents = readFileContents(filename);
+    std::cout << "Watching instruction file for changes: " << filename << std::endl;
+
+    StopWatch timer;
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        std::string newContents = readFileContents(filename);
+        if (newContents == contents) {
+            continue;
+        }
+        contents = newContents;
+
+        try {
+            map.readInstructionFile(filename);
+        } catch (std::exception &e) {
+            std::cout << "error: unable to read instruction file: " << e.what() << std::endl;
+            continue;
+        }
+
+        timer.reset();
+        timer.start();
+        int startIndex = map.resumeInstructions();
+
+        if (gen::config::heightmapCreation) {
+            std::string outfile = gen::config::outfile;
+            std::string heightmapfile = "heightmap." + outfile + ".bin";
+            map.outputHeightMap(heightmapfile);
+        }
+
+        map.updateBiomes();
+        srand(gen::config::seed);
+        map.clearCities();
+        map.clearTowns();
+        addSettlements(map);
+        outputMap(map);
+        timer.stop();
+
+        std::cout << "Regenerated map from instruction " << startIndex << " in " << 
+                     timer.getTime() << " seconds." << std::endl;
+    }
+}
+
 int main(int argc, char **argv) {
 
     if (!gen::config::parseOptions(argc, argv)) {
@@ -301,6 +394,38 @@ int main(int argc, char **argv) {
     Extents2d extents(0, 0, extentsWidth, extentsHeight);
     gen::MapGenerator map(extents, gen::config::resolution, imgWidth, imgHeight);
     map.setDrawScale(gen::config::drawScale);
+    map.setThreadCount(gen::config::numThreads);
+    map.setCheckpointInterval(gen::config::checkpointInterval, gen::config::checkpointTime);
+    map.setCheckpointFile(gen::config::checkpointFile);
+    if (gen::config::simdType == "avx2") {
+        HeightKernels::setInstructionSet(HeightKernels::InstructionSet::avx2);
+    } else if (gen::config::simdType == "sse4") {
+        HeightKernels::setInstructionSet(HeightKernels::InstructionSet::sse4);
+    } else if (gen::config::simdType == "scalar") {
+        HeightKernels::setInstructionSet(HeightKernels::InstructionSet::scalar);
+    }
+    gen::config::print("Using " + HeightKernels::getInstructionSetName(
+                       HeightKernels::getInstructionSet()) + " height map kernels.");
+    if (gen::config::meshCacheDirectory != "") {
+        uint64_t cacheBytes = (uint64_t)gen::config::meshCacheSize * 1024 * 1024;
+        map.setMeshCache(gen::config::meshCacheDirectory, cacheBytes);
+    }
+    if (gen::config::noiseFieldType == "bilinear") {
+        map.setNoiseField(gen::NoiseFieldSampling::bilinear, gen::config::noiseCacheDirectory);
+    } else if (gen::config::noiseFieldType == "bicubic") {
+        map.setNoiseField(gen::NoiseFieldSampling::bicubic, gen::config::noiseCacheDirectory);
+    }
+    if (gen::config::samplerType == "tiled") {
+        map.setSamplerType(gen::SamplerType::tiled);
+    } else if (gen::config::samplerType == "tileset") {
+        map.setSamplerType(gen::SamplerType::tileset);
+    }
+    if (gen::config::triangulatorType == "incremental") {
+        map.setTriangulatorType(gen::TriangulatorType::incremental);
+    }
+    if (gen::config::meshLayout == "compact") {
+        map.setMeshLayout(dcel::MeshLayout::compact);
+    }
 
     if (!gen::config::enableSlopes) { map.disableSlopes(); }
     if (!gen::config::enableRivers) { map.disableRivers(); }
@@ -349,7 +474,12 @@ int main(int argc, char **argv) {
 
     if (gen::config::instructionFile != "" && gen::config::voronoiFile != "") {
         map.readInstructionFile(gen::config::instructionFile);
+        timer.reset();
+        timer.start();
         map.performInstructions();
+        timer.stop();
+        gen::config::print("Finished performing instructions in " +
+                           gen::config::toString(timer.getTime()) + " seconds.\n");
     } 
 
     if (gen::config::randomGeneration && gen::config::instructionFile == "") {
@@ -390,39 +520,20 @@ int main(int argc, char **argv) {
 
     createBiomes(map);
 
-    int numCities = (int)randomDouble(3, 7);
-    int numTowns = (int)randomDouble(8, 25);
-    if (gen::config::numCities >= 0) { numCities = gen::config::numCities; }
-    if (gen::config::numTowns >= 0) { numTowns = gen::config::numTowns; }
-    if (!gen::config::enableCities) { numCities = 0; }
-    if (!gen::config::enableTowns) { numTowns = 0; }
-
-    int numLabels = 2*numCities + numTowns;
-    std::vector<std::string> labelNames = getLabelNames(numLabels);
-
-    gen::config::print("Generating " + gen::config::toString(numCities) +
-                       " cities...");
-    timer.reset();
-    timer.start();
-    addCities(map, numCities, labelNames);
-    timer.stop();
-    gen::config::print("Finished generating cities in " +
-                       gen::config::toString(timer.getTime()) + " seconds.\n");
-
-    gen::config::print("Generating " + gen::config::toString(numTowns) +
-                       " towns...");
-    timer.reset();
-    timer.start();
-    addTowns(map, numTowns, labelNames);
-    timer.stop();
-    gen::config::print("Finished generating towns in " +
-                       gen::config::toString(timer.getTime()) + " seconds.\n");
+    if (gen::config::watchInstructions) {
+        srand(gen::config::seed);
+    }
+    addSettlements(map);
 
     outputMap(map);
 
     totalTimer.stop();
     gen::config::print("\nFinished generating map in " + 
                        gen::config::toString(totalTimer.getTime()) + " seconds.");
+
+    if (gen::config::watchInstructions) {
+        watchInstructions(map);
+    }
     
     return 0;
 }
@@ -46,17 +46,52 @@ gen::MapGenerator::MapGenerator(Extents2d extents, double resolution) :
 }
 
 void gen::MapGenerator::initialize() {
-    if (_voronoi.vertices.size() == 0) {
-        _initializeVoronoiData();
+    if (_mesh.vertexCount() == 0) {
+        if (_meshCacheDirectory.empty()) {
+            _initializeVoronoiData();
+        } else {
+            _initializeCachedVoronoiData();
+        }
     }
     _initializeMapData();
     _isInitialized = true;
 }
 
+void gen::MapGenerator::setSamplerType(SamplerType type) {
+    _samplerType = type;
+}
+
+void gen::MapGenerator::setTriangulatorType(TriangulatorType type) {
+    _triangulatorType = type;
+}
+
+/*
+    Layout of meshes generated or read from a cereal voronoi file. Mapped
+    mesh files and cache entries are read in place in the full layout.
+*/
+void gen::MapGenerator::setMeshLayout(dcel::MeshLayout layout) {
+    _meshLayout = layout;
+}
+
+void gen::MapGenerator::setThreadCount(int numThreads) {
+    _numThreads = numThreads;
+}
+
+void gen::MapGenerator::setMeshCache(std::string directory, uint64_t maxBytes) {
+    _meshCacheDirectory = directory;
+    _meshCacheSize = maxBytes;
+}
+
+void gen::MapGenerator::setNoiseField(NoiseFieldSampling sampling, std::string cacheDirectory) {
+    _noiseFieldSampling = sampling;
+    _noiseCacheDirectory = cacheDirectory;
+}
+
 void gen::MapGenerator::normalize() {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
+    _executeHeightProgram();
     _heightMap.normalize();
 }
 
@@ -64,6 +99,7 @@ void gen::MapGenerator::round() {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
+    _executeHeightProgram();
     _heightMap.round();
 }
 
@@ -71,13 +107,15 @@ void gen::MapGenerator::relax() {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    _heightMap.relax();
+    _executeHeightProgram();
+    _heightMap.relax(_neighbourMap);
 }
 
 void gen::MapGenerator::setSeaLevel(double level) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
+    _executeHeightProgram();
     _heightMap.setLevel(level);
 }
 
@@ -85,6 +123,7 @@ void gen::MapGenerator::setSeaLevelToMedian() {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
+    _executeHeightProgram();
     _heightMap.setLevelToMedian();
 }
 
@@ -92,75 +131,16 @@ void gen::MapGenerator::addHill(double px, double py, double r, double height, b
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    /*
-        Create a rounded hill where height falls off smoothly
-    */
-
-    // coefficients for the Wyvill kernel function
-    double coef1 = (4.0 / 9.0)*(1.0 / (r*r*r*r*r*r));
-    double coef2 = (17.0 / 9.0)*(1.0 / (r*r*r*r));
-    double coef3 = (22.0 / 9.0)*(1.0 / (r*r));
-    double rsq = r*r;
-
-    dcel::Point v;
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        v = _vertexMap.vertices[i].position;
-        double dx = v.x - px;
-        double dy = v.y - py;
-        double dsq = dx*dx + dy*dy;
-        if (dsq < rsq) {
-            double kernel = 1.0 - coef1*dsq*dsq*dsq + coef2*dsq*dsq - coef3*dsq;
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval + height*kernel);
-            } else {
-                _heightMap.set(i, hval * height*kernel);
-            }
-        } else {
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval + 0);
-            } else {
-                _heightMap.set(i, hval * 0);
-            }
-        }
-    }
+    _heightProgram.addHill(px, py, r, height, multiply);
+    _updateHeightProgram();
 }
 
 void gen::MapGenerator::addCone(double px, double py, double radius, double height, bool multiply = false) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    /*
-        Create a cone where height falls off linearly
-    */
-
-    double invradius = 1.0 / radius;
-    double rsq = radius * radius;
-    dcel::Point v;
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        v = _vertexMap.vertices[i].position;
-        double dx = v.x - px;
-        double dy = v.y - py;
-        double dsq = dx*dx + dy*dy;
-        if (dsq < rsq) {
-            double dist = sqrt(dsq);
-            double kernel = 1.0 - dist * invradius;
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval + height*kernel);
-            } else {
-                _heightMap.set(i, hval * height*kernel);
-            }
-        } else {
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval + 0);
-            } else {
-                _heightMap.set(i, hval * 0);
-            }
-        }
-    }
+    _heightProgram.addCone(px, py, radius, height, multiply);
+    _updateHeightProgram();
 }
 
 void gen::MapGenerator::addSlope(double px, double py, double dirx, double diry, 
@@ -170,42 +150,10 @@ void gen::MapGenerator::addSlope(double px, double py, double dirx, double diry,
     }
 
     /*
-        Add a slope that runs parallel to the line with direction (dirx, diry)
-        and position (px, py). (dirx, diry) must be a unit vector. The slope
-        varies in height linearly from 0 to height from the left side of the 
-        direction vector to the right side of the direction vector.
+        (dirx, diry) must be a unit vector
     */
-
-    dcel::Point v;
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        v = _vertexMap.vertices[i].position;
-        
-        double dx = px - v.x;
-        double dy = py - v.y;
-        double dot = dx*dirx + dy*diry;
-        double distx = dx - dot*dirx;
-        double disty = dy - dot*diry;
-        double dist = sqrt(distx*distx + disty*disty);
-        dist = fmin(dist, radius);
-
-        double cross = dx*diry - dy*dirx;
-        double min, max;
-        if (cross < 0) {
-            min = 0.5*height;
-            max = 0;
-        } else {
-            min = 0.5*height;
-            max = height;
-        }
-
-        double fieldval = min + (dist / radius)*(max - min);
-        double hval = _heightMap(i);
-        if (!multiply) {
-                _heightMap.set(i, hval + fieldval);
-            } else {
-                _heightMap.set(i, hval * fieldval);
-            }
-    }
+    _heightProgram.addSlope(px, py, dirx, diry, radius, height, multiply);
+    _updateHeightProgram();
 }
 
 
@@ -213,71 +161,28 @@ void gen::MapGenerator::addPit(double px, double py, double radius, double heigh
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    /*
-        Create a conal pit where height rises off linearly
-    */
-
-    double invradius = 1.0 / radius;
-    double rsq = radius * radius;
-    dcel::Point v;
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        v = _vertexMap.vertices[i].position;
-        double dx = v.x - px;
-        double dy = v.y - py;
-        double dsq = dx*dx + dy*dy;
-        if (dsq < rsq) {
-            double dist = sqrt(dsq);
-            double kernel = 1.0 - dist * invradius;
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval - height*kernel);
-            } else {
-                _heightMap.set(i, hval * -height*kernel);
-            }
-        }
-    }
+    _heightProgram.addPit(px, py, radius, height, multiply);
+    _updateHeightProgram();
 }
 
 void gen::MapGenerator::addDepression(double px, double py, double r, double height, bool multiply = false) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    /*
-        Create a rounded depression where height falls off smoothly
-    */
-
-    // coefficients for the Wyvill kernel function
-    double coef1 = (4.0 / 9.0)*(1.0 / (r*r*r*r*r*r));
-    double coef2 = (17.0 / 9.0)*(1.0 / (r*r*r*r));
-    double coef3 = (22.0 / 9.0)*(1.0 / (r*r));
-    double rsq = r*r;
-
-    dcel::Point v;
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        v = _vertexMap.vertices[i].position;
-        double dx = v.x - px;
-        double dy = v.y - py;
-        double dsq = dx*dx + dy*dy;
-        if (dsq < rsq) {
-            double kernel = 1.0 - coef1*dsq*dsq*dsq + coef2*dsq*dsq - coef3*dsq;
-            double hval = _heightMap(i);
-            if (!multiply) {
-                _heightMap.set(i, hval - height*kernel);
-            } else {
-                _heightMap.set(i, hval *    height*kernel);
-            }
-        }
-    }
+    _heightProgram.addDepression(px, py, r, height, multiply);
+    _updateHeightProgram();
 }
 
 void gen::MapGenerator::multiply(double min, double max, double amount) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    for (unsigned int i =0; i <_heightMap.size(); i++) {
-        double h = _heightMap(i);
+    _executeHeightProgram();
+    LayerValue *heights = _heightMap.data();
+    for (unsigned int i = 0; i < _heightMap.size(); i++) {
+        double h = heights[i];
         if (h > min && h < max) {
-            _heightMap.set(i, h * amount);
+            heights[i] = h * amount;
         }
     }
 }
@@ -289,18 +194,11 @@ void gen::MapGenerator::addNoise(double freq, double strength, bool multiply) {
 
     FastNoise noise;
     noise.SetNoiseType(FastNoise::Simplex);
-    noise.SetSeed(rand()%10000);
+    noise.SetSeed(_instructionRand()%10000);
     noise.SetFrequency(freq);
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        dcel::Point p = _vertexMap.vertices[i].position;
-        double h = _heightMap(i);
-        double n = noise.GetNoise(p.x, p.y);
-        if (!multiply) {
-            _heightMap.set(i, h + strength*n);
-        } else {
-            _heightMap.set(i, h * strength*n);
-        }
-    }
+    NoiseField field = _createNoiseField(noise);
+    _heightProgram.addNoise(field, strength, multiply);
+    _updateHeightProgram();
 }
 
 double gen::MapGenerator::randomDouble(double min, double max) {
@@ -314,34 +212,14 @@ void gen::MapGenerator::makeContinent() {
 
     FastNoise noiseGen;
     noiseGen.SetNoiseType(FastNoise::Simplex);
-    noiseGen.SetSeed(rand() % 1000000);
-    noiseGen.SetFrequency(randomDouble(.1, 1));
+    noiseGen.SetSeed(_instructionRand() % 1000000);
+    noiseGen.SetFrequency(_instructionRandomDouble(.1, 1));
 
-    double minDist = randomDouble(1., 2.);
-    double scalar = randomDouble(1., 4.);
-
-    for (unsigned int i = 0; i <_heightMap.size(); i++) {
-        double h = _heightMap(i);
-        dcel::Point p = _vertexMap.vertices[i].position;
-
-        double dist = abs(_extents.minx - p.x);
-
-        if (abs(_extents.maxx - p.x) < dist) {
-            dist = abs(_extents.maxx - p.x);
-        }
-        if (abs(_extents.maxy - p.y) < dist) {
-            dist =abs(_extents.maxy - p.y);
-        }
-        if (abs(_extents.miny - p.y) < dist) {
-            dist = abs(_extents.miny - p.y);
-        }
-        double noise = scalar * noiseGen.GetNoise(p.x, p.y);
-        if (dist <= minDist + noise) {
-            _heightMap.set(i, h - (1/pow(minDist + noise, 2)));
-        } else {
-            _heightMap.set(i, h - (1/pow(dist,2)));
-        }
-    }
+    double minDist = _instructionRandomDouble(1., 2.);
+    double scalar = _instructionRandomDouble(1., 4.);
+    NoiseField field = _createNoiseField(noiseGen);
+    _heightProgram.addContinent(field, _extents, minDist, scalar);
+    _updateHeightProgram();
 }
 
 
@@ -353,16 +231,12 @@ void gen::MapGenerator::erode(double amount) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
+    _executeHeightProgram();
 
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<double> erosionMap(vmp, 0.0);
+    NodeMap<LayerValue> erosionMap(_vertexMap, 0.0);
     _calculateErosionMap(erosionMap);
     gen::config::print("Erosion Map Created...");
-    for (unsigned int i = 0; i < _heightMap.size(); i++) {
-        double currlevel = _heightMap(i);
-        double newlevel = currlevel - amount * erosionMap(i);
-        _heightMap.set(i, newlevel);
-    }
+    _heightMap.subtractScaled(erosionMap, amount);
 
     _isHeightMapEroded = true;
 }
@@ -371,21 +245,76 @@ void gen::MapGenerator::generateBiomes() {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<double> precipitationMap(vmp, 0.0);
+    _climateLayers = LayerStack(_vertexMap, LayerLayout::aosoa);
+    _climateLayers.addChannel<LayerValue>("precipitation");
+    _climateLayers.addChannel<LayerValue>("temperature");
+    _climateLayers.addChannel<BiomeType>("biome");
+    LayerView<LayerValue> precipitationMap = _climateLayers.getChannel<LayerValue>("precipitation");
+    LayerView<LayerValue> temperatureMap = _climateLayers.getChannel<LayerValue>("temperature");
+    LayerView<BiomeType> biomeMap = _climateLayers.getChannel<BiomeType>("biome");
+
     _calculatePrecipitationMap(precipitationMap);
-     _precipitationMap = precipitationMap;
-     _isPrecipitationCalculated = true;
+    _isPrecipitationCalculated = true;
 
-    NodeMap<double> temperatureMap(vmp, 0.0);
     _calculateTemperatureMap(temperatureMap);
-    _temperatureMap = temperatureMap;
     _isTemperatureCalculated = true;
 
-    NodeMap<double> biomeMap(vmp);
-    _calculateBiomeMap(biomeMap);
-    _biomeMap = biomeMap;
+    _calculateBiomeMap(temperatureMap, precipitationMap, biomeMap);
+
+    if (!_isLandFaceTableInitialized) {
+        _initializeLandFaceTable();
+    }
+    _climateLandFaceTable = _isLandFaceTable;
+    _staleClimateVertices.clear();
+    _isClimateVertexStale.clear();
+}
+
+/*
+    Recompute the climate layers where they depend on vertices changed by
+    updateInstruction() since the layers were calculated, keeping the
+    noise of the previous calculation. The temperature of a face also
+    depends on whether it is land, which can change away from the edited
+    vertices when a coastline moves.
+*/
+void gen::MapGenerator::updateBiomes() {
+    if (!_isInitialized) {
+        throw std::runtime_error("MapGenerator must be initialized.");
+    }
 
+    if (!_isTemperatureCalculated || !_isPrecipitationCalculated) {
+        generateBiomes();
+        return;
+    }
+
+    if (!_isLandFaceTableInitialized) {
+        _initializeLandFaceTable();
+    }
+    std::vector<int> changedFaces;
+    for (unsigned int i = 0; i < _isLandFaceTable.size() && i < _climateLandFaceTable.size(); i++) {
+        if (_isLandFaceTable[i] != _climateLandFaceTable[i]) {
+            changedFaces.push_back(i);
+        }
+    }
+    _markClimateStale(changedFaces);
+    _climateLandFaceTable = _isLandFaceTable;
+
+    LayerView<LayerValue> precipitationMap = _climateLayers.getChannel<LayerValue>("precipitation");
+    LayerView<LayerValue> temperatureMap = _climateLayers.getChannel<LayerValue>("temperature");
+    LayerView<BiomeType> biomeMap = _climateLayers.getChannel<BiomeType>("biome");
+    for (unsigned int k = 0; k < _staleClimateVertices.size(); k++) {
+        int i = _staleClimateVertices[k];
+        precipitationMap[i] = _calculateVertexPrecipitation(i);
+        if (i < _mesh.faceCount()) {
+            double temperature = 0.0;
+            _calculateFaceTemperature(i, &temperature);
+            temperatureMap[i] = temperature;
+        }
+        biomeMap[i] = _getLifeZone(temperatureMap[i], precipitationMap[i]);
+        _isClimateVertexStale[i] = false;
+    }
+    gen::config::print("Updated climate at " + 
+                       gen::config::toString(_staleClimateVertices.size()) + " vertices.");
+    _staleClimateVertices.clear();
 }
 
 void gen::MapGenerator::addCity(std::string cityName, std::string territoryName) {
@@ -427,18 +356,20 @@ void gen::MapGenerator::addTown(std::string townName) {
     _towns.push_back(town);
 }
 
+void gen::MapGenerator::clearCities() {
+    _cities.clear();
+}
+
+void gen::MapGenerator::clearTowns() {
+    _towns.clear();
+}
+
 void gen::MapGenerator::outputVoronoiDiagram(std::string filename) {
     if (!_isInitialized) {
         throw std::runtime_error("MapGenerator must be initialized.");
     }
 
-    // cereal version
-    std::ofstream file(filename, std::ios::binary);
-    {
-        cereal::BinaryOutputArchive oarchive(file);
-        dcel::DCEL voronoi = _voronoi;
-        oarchive(voronoi);
-    }
+    MeshFile::write(filename, _mesh, _extents, _resolution);
 }
 
 void gen::MapGenerator::outputHeightMap(std::string filename) {
@@ -449,7 +380,7 @@ void gen::MapGenerator::outputHeightMap(std::string filename) {
     std::ofstream file(filename, std::ios::binary);
     {   
         cereal::BinaryOutputArchive oarchive(file);
-        NodeMap<double> heightMap = _heightMap;
+        NodeMap<LayerValue> heightMap = _heightMap;
         oarchive(_heightMap);
     } // to ensure contents are flushed
 }
@@ -556,15 +487,46 @@ void gen::MapGenerator::readHeightMapFile(std::string filename) {
         std::ifstream is(filename, std::ios::binary);
         gen::config::print("\tReading heightmap file...");
         cereal::BinaryInputArchive iarchive(is);
-        gen::NodeMap<double> heightMap;
+        gen::NodeMap<LayerValue> heightMap;
         iarchive(heightMap);
         _heightMap = heightMap;
     }
+
+    // Use the generator's topology instead of the copy stored in the file
+    if (_isInitialized && _heightMap.size() == _vertexMap->size()) {
+        NodeMap<LayerValue> heightMap(_vertexMap);
+        for (unsigned int i = 0; i < heightMap.size(); i++) {
+            heightMap.set(i, _heightMap(i));
+        }
+        _heightMap = heightMap;
+    }
     gen::config::print("\tHeightMap with " + gen::config::toString(_heightMap.size())+ " nodes loaded...");
 }
 
 
 void gen::MapGenerator::readVoronoiFile(std::string filename) {
+    if (MeshFile::isMeshFile(filename)) {
+        gen::config::print("\tReading voronoi mesh file...");
+        std::shared_ptr<MeshFile::MappedMesh> mesh =
+            std::make_shared<MeshFile::MappedMesh>(filename);
+        if (!mesh->isChecksumValid()) {
+            throw std::runtime_error("Mesh file checksum does not match: " + filename);
+        }
+
+        Extents2d e = mesh->extents();
+        if (e.minx != _extents.minx || e.miny != _extents.miny || 
+                e.maxx != _extents.maxx || e.maxy != _extents.maxy ||
+                mesh->resolution() != _resolution) {
+            gen::config::print("\tWarning: voronoi mesh file was generated with "
+                               "different extents or resolution.");
+        }
+
+        _mesh = MeshFile::getFlatDCEL(mesh);
+        gen::config::print("\tVoronoi mesh with " + 
+                           gen::config::toString(mesh->faceCount()) + " faces loaded...");
+        return;
+    }
+
     // Cereal version
     {
         std::ifstream is(filename, std::ios::binary);
@@ -573,7 +535,7 @@ void gen::MapGenerator::readVoronoiFile(std::string filename) {
         dcel::DCEL voronoi;
         iarchive(voronoi);
 
-        _voronoi = voronoi;
+        _mesh = dcel::FlatDCEL(voronoi, _meshLayout);
     }
 }
 
@@ -697,9 +659,25 @@ void gen::MapGenerator::_initializeVoronoiData() {
     StopWatch timer;
     timer.start();
     std::vector<dcel::Point> samples;
-    samples = PoissonDiscSampler::generateSamples(sampleExtents, 
-                                                  _resolution, 
-                                                  _poissonSamplerKValue);
+    if (_samplerType == SamplerType::tiled) {
+        unsigned int seed = (unsigned int)rand();
+        samples = PoissonDiscSampler::generateTiledSamples(sampleExtents, 
+                                                           _resolution, 
+                                                           _poissonSamplerKValue,
+                                                           seed, _numThreads);
+    } else if (_samplerType == SamplerType::tileset) {
+        unsigned int seed = (unsigned int)rand();
+        std::string tilefile = gen::resources::getBlueNoiseDataResource();
+        std::vector<PoissonDiscSampler::BlueNoiseTile> tiles;
+        tiles = PoissonDiscSampler::readBlueNoiseTiles(tilefile);
+        samples = PoissonDiscSampler::generateTileSetSamples(sampleExtents, 
+                                                             _resolution,
+                                                             tiles, seed);
+    } else {
+        samples = PoissonDiscSampler::generateSamples(sampleExtents, 
+                                                      _resolution, 
+                                                      _poissonSamplerKValue);
+    }
     timer.stop();
     //gen::config::print("\tFinished generating " + 
                        //gen::config::toString(samples.size()) + " poisson disc "
@@ -710,106 +688,185 @@ void gen::MapGenerator::_initializeVoronoiData() {
                        //gen::config::toString(samples.size()) + " points...");
     timer.reset();
     timer.start();
-    dcel::DCEL triangulation = Delaunay::triangulate(samples);
+    Geometry::resetPredicateStats();
+    dcel::DCEL triangulation;
+    if (_triangulatorType == TriangulatorType::incremental) {
+        triangulation = Delaunay::triangulate(samples);
+    } else {
+        triangulation = SweepHull::triangulate(samples);
+    }
     timer.stop();
+    _printPredicateStats();
     //gen::config::print("\tFinished computing triangulation in " + 
                        //gen::config::toString(timer.getTime()) + " seconds.\n");
 
     //gen::config::print("\tComputing Voronoi diagram from delaunay triangulation...");
     timer.reset();
     timer.start();
-    _voronoi = Voronoi::delaunayToVoronoi(triangulation);
+    dcel::DCEL voronoi = Voronoi::delaunayToVoronoi(triangulation);
+    _mesh = dcel::FlatDCEL(voronoi, _meshLayout);
     timer.stop();
     //gen::config::print("\tFinished computing Voronoi diagram in " + 
                        //gen::config::toString(timer.getTime()) + " seconds.\n");
 }
 
+/*
+    The mesh is generated from its own seed so that the random sequence
+    after initialization is the same whether or not the mesh was found in
+    the cache.
+*/
+void gen::MapGenerator::_initializeCachedVoronoiData() {
+    unsigned int meshSeed = (unsigned int)rand();
+    unsigned int nextSeed = (unsigned int)rand();
+    MeshCache::Key key = _getMeshCacheKey(meshSeed);
+    std::string keyName = MeshCache::getKeyName(key);
+
+    StopWatch timer;
+    timer.start();
+    if (MeshCache::load(_meshCacheDirectory, key, _mesh)) {
+        timer.stop();
+        gen::config::print("\tLoaded Voronoi mesh " + keyName + " from cache in " +
+                           gen::config::toString(timer.getTime()) + " seconds.");
+    } else {
+        srand(meshSeed);
+        _initializeVoronoiData();
+        if (MeshCache::store(_meshCacheDirectory, key, _mesh, _meshCacheSize)) {
+            gen::config::print("\tStored Voronoi mesh " + keyName + " in cache.");
+        } else {
+            gen::config::print("\tWarning: unable to store Voronoi mesh in cache "
+                               "directory: " + _meshCacheDirectory);
+        }
+    }
+
+    srand(nextSeed);
+}
+
+MeshCache::Key gen::MapGenerator::_getMeshCacheKey(unsigned int seed) {
+    MeshCache::Key key;
+    key.extents = _extents;
+    key.resolution = _resolution;
+    key.padFactor = _samplePadFactor;
+    key.kValue = _poissonSamplerKValue;
+    key.seed = seed;
+    key.samplerType = (int)_samplerType;
+    key.triangulatorType = (int)_triangulatorType;
+
+    return key;
+}
+
+void gen::MapGenerator::_printPredicateStats() {
+    Geometry::PredicateStats stats = Geometry::getPredicateStats();
+    double orientRate = 100.0;
+    if (stats.orient2dCount > 0) {
+        orientRate *= 1.0 - (double)stats.orient2dExactCount / (double)stats.orient2dCount;
+    }
+    double incircleRate = 100.0;
+    if (stats.incircleCount > 0) {
+        incircleRate *= 1.0 - (double)stats.incircleExactCount / (double)stats.incircleCount;
+    }
+
+    gen::config::print("\tTriangulation predicates: " +
+                       gen::config::toString(stats.orient2dCount) + " orient2d (" +
+                       gen::config::toString(orientRate) + "% fast path), " +
+                       gen::config::toString(stats.incircleCount) + " incircle (" +
+                       gen::config::toString(incircleRate) + "% fast path)");
+}
+
+void gen::MapGenerator::_printMeshMemoryReport() {
+    if (!gen::config::verbose) {
+        return;
+    }
+
+    double mb = 1.0 / (1024.0 * 1024.0);
+    double fullSize = mb * _mesh.getMemoryUsage(dcel::MeshLayout::full);
+    double compactSize = mb * _mesh.getMemoryUsage(dcel::MeshLayout::compact);
+    bool isCompact = _mesh.getLayout() == dcel::MeshLayout::compact;
+    std::string layout = isCompact ? "compact" : "full";
+    if (_mesh.isView()) {
+        layout += ", mapped";
+    }
+
+    gen::config::print("\tMesh memory (" + 
+                       gen::config::toString(_mesh.faceCount()) + " faces): " +
+                       "full layout " + gen::config::toString(fullSize) + " MB, " +
+                       "compact layout " + gen::config::toString(compactSize) + " MB " +
+                       "(using " + layout + ")");
+}
+
 void gen::MapGenerator::_initializeMapData() {
     //gen::config::print("\tInitializing map data...");
     StopWatch timer;
     timer.start();
-    _vertexMap = VertexMap(&_voronoi, _extents);
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    _heightMap = NodeMap<double>(vmp, 0);
+    _printMeshMemoryReport();
+    _vertexMap = std::make_shared<VertexMap>(&_mesh, _extents);
+    _heightMap = NodeMap<LayerValue>(_vertexMap, 0);
     _initializeNeighbourMap();
     _initializeFaceNeighbours();
     _initializeFaceVertices();
     _initializeFaceEdges();
+    _vertexGrid = VertexGrid(_vertexMap->vertices, _verticesPerGridCell);
     timer.stop();
     //gen::config::print("\tFinished initializing map data in " + 
                        //gen::config::toString(timer.getTime()) + " seconds.");
 }
 
 void gen::MapGenerator::_initializeNeighbourMap() {
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    _neighbourMap = NodeMap<std::vector<int> >(vmp);
+    _neighbourMap = AdjacencyList();
+    _neighbourMap.reserve(_vertexMap->size(), 3 * _vertexMap->size());
     std::vector<int> indices;
     indices.reserve(3);
-    for (unsigned int i = 0; i < _neighbourMap.size(); i++) {
+    for (unsigned int i = 0; i < _vertexMap->size(); i++) {
         indices.clear();
-        _vertexMap.getNeighbourIndices(_vertexMap.vertices[i], indices);
-        _neighbourMap.set(i, indices);
+        _vertexMap->getNeighbourIndices(_vertexMap->vertices[i], indices);
+        _neighbourMap.addRow(indices);
     }
 }
 
 void gen::MapGenerator::_initializeFaceNeighbours() {
-    _faceNeighbours.reserve(_voronoi.faces.size());
-    dcel::Face f;
-    dcel::HalfEdge h;
-    std::vector<dcel::HalfEdge> outerComponents;
-    std::vector<int> faceindices;
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
-        f = _voronoi.faces[i];
-
-        outerComponents.clear();
-        _voronoi.getOuterComponents(f, outerComponents);
-        faceindices.clear();
-        for (unsigned int nidx = 0; nidx < outerComponents.size(); nidx++) {
-            h = _voronoi.twin(outerComponents[nidx]);
-            int nfidx = h.incidentFace.ref;
+    _faceNeighbours = AdjacencyList();
+    _faceNeighbours.reserve(_mesh.faceCount(), _mesh.edgeCount());
+    for (int i = 0; i < _mesh.faceCount(); i++) {
+        int h = _mesh.outerComponent(i);
+        int start = h;
+        do {
+            int nfidx = _mesh.incidentFace(_mesh.twin(h));
             if (nfidx != -1) {
-                faceindices.push_back(nfidx);
+                _faceNeighbours.push(nfidx);
             }
-        }
+            h = _mesh.next(h);
+        } while (h != start);
 
-        _faceNeighbours.push_back(std::vector<int>(faceindices.size(), -1));
-        for (unsigned int idx = 0; idx < faceindices.size(); idx++) {
-            _faceNeighbours[i][idx] = faceindices[idx];
-        }
+        _faceNeighbours.endRow();
     }
 }
 
 void gen::MapGenerator::_initializeFaceVertices() {
-    _faceVertices.reserve(_voronoi.faces.size());
-    dcel::Face f;
-    dcel::Vertex v;
-    std::vector<dcel::HalfEdge> edges;
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
-        f = _voronoi.faces[i];
+    _faceVertices = AdjacencyList();
+    _faceVertices.reserve(_mesh.faceCount(), _mesh.edgeCount());
+    for (int i = 0; i < _mesh.faceCount(); i++) {
+        int h = _mesh.outerComponent(i);
+        int start = h;
+        do {
+            _faceVertices.push(_mesh.origin(h));
+            h = _mesh.next(h);
+        } while (h != start);
 
-        edges.clear();
-        _voronoi.getOuterComponents(f, edges);
-        _faceVertices.push_back(std::vector<int>(edges.size(), -1));
-        for (unsigned int eidx = 0; eidx < edges.size(); eidx++) {
-            v = _voronoi.origin(edges[eidx]);
-            _faceVertices[i][eidx] = v.id.ref;
-        }
+        _faceVertices.endRow();
     }
 }
 
 void gen::MapGenerator::_initializeFaceEdges() {
-    _faceEdges.reserve(_voronoi.faces.size());
-    dcel::Face f;
-    std::vector<dcel::HalfEdge> edges;
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
-        f = _voronoi.faces[i];
+    _faceEdges = AdjacencyList();
+    _faceEdges.reserve(_mesh.faceCount(), _mesh.edgeCount());
+    for (int i = 0; i < _mesh.faceCount(); i++) {
+        int h = _mesh.outerComponent(i);
+        int start = h;
+        do {
+            _faceEdges.push(h);
+            h = _mesh.next(h);
+        } while (h != start);
 
-        edges.clear();
-        _voronoi.getOuterComponents(f, edges);
-        _faceEdges.push_back(std::vector<int>(edges.size(), -1));
-        for (unsigned int eidx = 0; eidx < edges.size(); eidx++) {
-            _faceEdges[i][eidx] = edges[eidx].id.ref;
-        }
+        _faceEdges.endRow();
     }
 }
 
@@ -826,7 +883,7 @@ jsoncons::json gen::MapGenerator::_getExtentsJSON() {
 void gen::MapGenerator::_outputVertices(VertexList &verts, 
                                         std::string filename) {
     std::vector<double> coordinates;
-    coordinates.reserve(2*_vertexMap.edge.size());
+    coordinates.reserve(2*_vertexMap->edge.size());
     for (unsigned int i = 0; i < verts.size(); i++) {
         coordinates.push_back(verts[i].position.x);
         coordinates.push_back(verts[i].position.y);
@@ -841,21 +898,20 @@ void gen::MapGenerator::_outputVertices(VertexList &verts,
     file.close();
 }
 
-std::vector<double> gen::MapGenerator::_computeFaceValues(NodeMap<double> &heightMap) {
+std::vector<double> gen::MapGenerator::_computeFaceValues(NodeMap<LayerValue> &heightMap) {
     std::vector<double> faceheights;
-    faceheights.reserve(_voronoi.faces.size());
-
-    dcel::Vertex v;
-    for (unsigned int j = 0; j < _voronoi.faces.size(); j++) {
+    faceheights.reserve(_mesh.faceCount());
 
+    for (int j = 0; j < _mesh.faceCount(); j++) {
+        IndexRange verts = _faceVertices[j];
         double sum = 0.0;
-        for (unsigned int i = 0; i < _faceVertices[j].size(); i++) {
-            v = _voronoi.getVertex(_faceVertices[j][i]);
-            if (heightMap.isNode(v)) {
-                sum += heightMap(v);
+        for (int vid : verts) {
+            int vidx = _vertexMap->getVertexIndex(vid);
+            if (vidx != -1) {
+                sum += heightMap(vidx);
             }
         }
-        double avg = sum / _faceVertices[j].size();
+        double avg = sum / verts.size();
         faceheights.push_back(avg);
     }
 
@@ -864,101 +920,108 @@ std::vector<double> gen::MapGenerator::_computeFaceValues(NodeMap<double> &heigh
 
 std::vector<dcel::Point> gen::MapGenerator::_computeFacePositions() {
     std::vector<dcel::Point> positions;
-    positions.reserve(_voronoi.faces.size());
+    positions.reserve(_mesh.faceCount());
 
-    dcel::Point p;
-    for (unsigned int j = 0; j < _voronoi.faces.size(); j++) {
-        double sumx = 0.0;
-        double sumy = 0.0;
-        for (unsigned int i = 0; i < _faceVertices[j].size(); i++) {
-            p = _voronoi.getVertex(_faceVertices[j][i]).position;
-            sumx += p.x;
-            sumy += p.y;
-        }
-        positions.push_back(dcel::Point(sumx / _faceVertices[j].size(), 
-                                        sumy / _faceVertices[j].size()));
+    for (int j = 0; j < _mesh.faceCount(); j++) {
+        positions.push_back(_computeFacePosition(j));
     }
 
     return positions;
 }
 
 dcel::Point gen::MapGenerator::_computeFacePosition(int fidx) {
+    IndexRange verts = _faceVertices[fidx];
     double sumx = 0.0;
     double sumy = 0.0;
-    dcel::Point p;
-    for (unsigned int i = 0; i < _faceVertices[fidx].size(); i++) {
-        p = _voronoi.getVertex(_faceVertices[fidx][i]).position;
-        sumx += p.x;
-        sumy += p.y;
+    for (int vid : verts) {
+        sumx += _mesh.vertexX[vid];
+        sumy += _mesh.vertexY[vid];
     }
 
-    return dcel::Point(sumx / _faceVertices[fidx].size(), 
-                       sumy / _faceVertices[fidx].size());
+    return dcel::Point(sumx / verts.size(), sumy / verts.size());
 }
 
-bool gen::MapGenerator::_isEdgeInMap(dcel::HalfEdge &h) {
-    dcel::Vertex v1 = _voronoi.origin(h);
-    dcel::Vertex v2 = _voronoi.origin(_voronoi.twin(h));
+bool gen::MapGenerator::_isEdgeInMap(int eidx) {
+    int v1 = _mesh.origin(eidx);
+    int v2 = _mesh.origin(_mesh.twin(eidx));
 
-    return _vertexMap.isVertex(v1) && _vertexMap.isVertex(v2);
+    return _vertexMap->isVertex(v1) && _vertexMap->isVertex(v2);
 }
 
-bool gen::MapGenerator::_isContourEdge(dcel::HalfEdge &h, 
+bool gen::MapGenerator::_isContourEdge(int eidx, 
                                        std::vector<double> &faceheights, 
                                        double isolevel) {
-    dcel::Face f1 = _voronoi.incidentFace(h);
-    dcel::Face f2 = _voronoi.incidentFace(_voronoi.twin(h));
-    double iso1 = faceheights[f1.id.ref];
-    double iso2 = faceheights[f2.id.ref];
+    int f1 = _mesh.incidentFace(eidx);
+    int f2 = _mesh.incidentFace(_mesh.twin(eidx));
+    double iso1 = faceheights[f1];
+    double iso2 = faceheights[f2];
     bool hasInside = iso1 < isolevel || iso2 < isolevel;
     bool hasOutside = iso1 >= isolevel || iso2 >= isolevel;
 
     return hasInside && hasOutside;
 }
 
-void gen::MapGenerator::_calculateErosionMap(NodeMap<double> &erosionMap) {
+void gen::MapGenerator::_calculateErosionMap(NodeMap<LayerValue> &erosionMap) {
     _fillDepressions();
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<double> fluxMap(vmp, 0.0);
+    NodeMap<LayerValue> fluxMap(_vertexMap, 0.0);
     _calculateFluxMap(fluxMap);
 
-    NodeMap<double> slopeMap(vmp, 0.0);
+    NodeMap<LayerValue> slopeMap(_vertexMap, 0.0);
     _calculateSlopeMap(slopeMap);
+    const LayerValue *flux = fluxMap.data();
+    const LayerValue *slope = slopeMap.data();
+    LayerValue *erosion = erosionMap.data();
     for (unsigned int i = 0; i < erosionMap.size(); i++) {
-        double flux = fluxMap(i);
-        double slope = slopeMap(i);
-        double river = _erosionRiverFactor * sqrt(flux) * slope;
-        double creep = _erosionCreepFactor * slope * slope;
-        double erosion = fmin(river + creep, _maxErosionRate);
-        erosionMap.set(i, erosion);
+        double river = _erosionRiverFactor * sqrt((double)flux[i]) * slope[i];
+        double creep = _erosionCreepFactor * slope[i] * slope[i];
+        erosion[i] = fmin(river + creep, _maxErosionRate);
     }
 
     erosionMap.normalize();
 }
 
-void gen::MapGenerator::_calculatePrecipitationMap(NodeMap<double> &precipitationMap) {
-    _precipitationNoiseMap.SetNoiseType(FastNoise::Simplex);
-    _precipitationNoiseMap.SetSeed(rand()%1000);
-    _precipitationNoiseMap.SetFrequency(0.01);
+void gen::MapGenerator::_calculatePrecipitationMap(LayerView<LayerValue> precipitationMap) {
+    FastNoise noiseMap;
+    noiseMap.SetNoiseType(FastNoise::Simplex);
+    noiseMap.SetSeed(rand()%1000);
+    noiseMap.SetFrequency(0.01);
+    _precipitationNoiseMap = _createNoiseField(noiseMap);
+
+    std::vector<int> vertices(precipitationMap.size());
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        vertices[i] = i;
+    }
+    std::vector<double> noise;
+    _fillVertexNoise(_precipitationNoiseMap, vertices, noise);
 
-    for (unsigned int i = 0; i < precipitationMap.size(); i++) {
-        dcel::Point point = _vertexMap.vertices[i].position;
-        double precip = _precipitationNoiseMap.GetNoise(point.x, point.y) ;
-        precipitationMap.set(i, .33 * _calculateHeightPrecipitation(i) + .66 * precip);
+    for (int i = 0; i < precipitationMap.size(); i++) {
+        precipitationMap[i] = _calculateVertexPrecipitation(i, noise[i]);
     }
     
 }
 
+double gen::MapGenerator::_calculateVertexPrecipitation(int i) {
+    dcel::Point point = _vertexMap->vertices[i].position;
+    double precip = _precipitationNoiseMap.getNoise(point.x, point.y) ;
+    return _calculateVertexPrecipitation(i, precip);
+}
+
+double gen::MapGenerator::_calculateVertexPrecipitation(int i, double noise) {
+    return .33 * _calculateHeightPrecipitation(i) + .66 * noise;
+}
+
 double gen::MapGenerator::_calculateHeightPrecipitation(int i) {
     double height = _heightMap(i);
 
     return 1.0-height*height;
 }
 
-void gen::MapGenerator::_calculateTemperatureMap(NodeMap<double> &temperatureMap) {  
-    _temperatureNoiseMap.SetNoiseType(FastNoise::Simplex);
-    _temperatureNoiseMap.SetSeed(rand() % 1000);
-    _temperatureNoiseMap.SetFrequency(.001 * floor((1. - _mapScale) * 10));
+void gen::MapGenerator::_calculateTemperatureMap(LayerView<LayerValue> temperatureMap) {  
+    FastNoise noiseMap;
+    noiseMap.SetNoiseType(FastNoise::Simplex);
+    noiseMap.SetSeed(rand() % 1000);
+    noiseMap.SetFrequency(.001 * floor((1. - _mapScale) * 10));
+    _temperatureNoiseMap = _createNoiseField(noiseMap);
 
     double max = _heightMap.getMax() * (rand() % 3 + 7) / 10.;
     _calculateLatitudeTemperatures(temperatureMap);
@@ -972,7 +1035,7 @@ double gen::MapGenerator::_calculateHeightTemperature(int i, double max) {
 }
 
 double gen::MapGenerator::_calculateLatitudeTemperature(int i) {
-    dcel::Point point = _vertexMap.vertices[i].position;
+    dcel::Point point = _vertexMap->vertices[i].position;
 
     double invheight = 1.0 / (_extents.maxy - _extents.miny); 
 
@@ -984,100 +1047,176 @@ double gen::MapGenerator::_calculateLatitudeTemperature(int i) {
     return 1.0 - (abs(.5 - yLoc) / .5);
 }
 
-void gen::MapGenerator::_calculateLatitudeTemperatures(NodeMap<double> &temperatureMap) {
-    double invheight = 1.0 / (_extents.maxy - _extents.miny);
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
-        dcel::Face f = _voronoi.faces[i];
-
-        if (f.outerComponent.ref == -1) {
-            continue;
+/*
+    The temperature noise is only needed at land faces, so it is evaluated
+    in one batch over the land faces before the face temperatures
+*/
+void gen::MapGenerator::_calculateLatitudeTemperatures(LayerView<LayerValue> temperatureMap) {
+    std::vector<int> landFaces;
+    for (int i = 0; i < _mesh.faceCount(); i++) {
+        if (_mesh.outerComponent(i) != -1 && _isLandFace(i)) {
+            landFaces.push_back(i);
         }
+    }
+    std::vector<double> noise;
+    _fillVertexNoise(_temperatureNoiseMap, landFaces, noise);
 
-        if (!_isLandFace(i)) {
-            continue;
+    for (unsigned int k = 0; k < landFaces.size(); k++) {
+        int i = landFaces[k];
+        double temperature;
+        if (_calculateFaceTemperature(i, _normalizeNoise(noise[k]), &temperature)) {
+            temperatureMap[i] = temperature;
         }
-        
-        dcel::HalfEdge h = _voronoi.outerComponent(f);
-        dcel::Ref startRef = h.id;
+    }
+}
+
+bool gen::MapGenerator::_calculateFaceTemperature(int i, double *value) {
+    return _calculateFaceTemperature(i, _calculateVertexNoise(i, _temperatureNoiseMap), value);
+}
+
+/*
+    Returns false for faces that are not land or that cross the map edge,
+    which are left at zero temperature. The noise is the normalized
+    temperature noise at vertex i.
+*/
+bool gen::MapGenerator::_calculateFaceTemperature(int i, double noise, double *value) {
+    double invheight = 1.0 / (_extents.maxy - _extents.miny);
+    if (_mesh.outerComponent(i) == -1) {
+        return false;
+    }
+
+    if (!_isLandFace(i)) {
+        return false;
+    }
+    
+    int h = _mesh.outerComponent(i);
+    int startRef = h;
+
+    double p = 0.;
+    bool outOfBoundsEdge = false;
+    double count = 0.;
+    do {
+        dcel::Point pos = _mesh.position(_mesh.origin(h));
+        outOfBoundsEdge = !_isEdgeInMap(h);
+        p += ((pos.y - _extents.miny) * invheight);
+        h = _mesh.next(h);
+        count++;
+    } while (h != startRef && !outOfBoundsEdge);
+    if (outOfBoundsEdge) {
+        return false;
+    }
+    p /= count;
+
+    // Adjust the point to fit the scale and offset
+    p =(_mapScale * p)  + _mapOffset; // World Scale Point
+
+    double dist = abs(.5 - p);
+    double temperature = (1.0 - (dist/ .5));
+    temperature *= .5 * noise + .5;
+    temperature -= _calculateHeightTemperature(i, 1.0);
+    *value = std::max(0., temperature);
+
+    return true;
+}
 
-        double p = 0.;
-        dcel::Vertex v;
-        bool outOfBoundsEdge = false;
-        double count = 0.;
-        do {
-            v = _voronoi.origin(h);
-            outOfBoundsEdge = !_isEdgeInMap(h);
-            p += ((v.position.y - _extents.miny) * invheight);
-            h = _voronoi.next(h);
-            count++;
-        } while (h.id != startRef && !outOfBoundsEdge);
-        if (outOfBoundsEdge) {
-            continue;
-        }
-        p /= count;
 
-        // Adjust the point to fit the scale and offset
-        p =(_mapScale * p)  + _mapOffset; // World Scale Point
+/*
+    Noise for height primitives and climate maps. Unless exact noise is
+    selected, the noise is baked onto a grid with the spacing of the mesh
+    resolution, or loaded from the noise cache when it has been baked
+    before.
+*/
+gen::NoiseField gen::MapGenerator::_createNoiseField(FastNoise &noise) {
+    if (_noiseFieldSampling == NoiseFieldSampling::exact) {
+        return NoiseField(noise);
+    }
 
-        double dist = abs(.5 - p);
-        double temperature = (1.0 - (dist/ .5));
-        temperature *= .5 * _calculateVertexNoise(i, _temperatureNoiseMap) + .5;
-        temperature -= _calculateHeightTemperature(i, 1.0);
-        temperatureMap.set(i, std::max(0., temperature));
+    NoiseField field(noise, _extents, _resolution, _noiseFieldSampling);
+    if (!_noiseCacheDirectory.empty() && field.loadCache(_noiseCacheDirectory)) {
+        return field;
     }
+
+    field.bake(_numThreads);
+    if (!_noiseCacheDirectory.empty() && !field.storeCache(_noiseCacheDirectory)) {
+        config::print("Unable to store noise field in cache directory: " +
+                      _noiseCacheDirectory);
+    }
+    return field;
 }
 
+double gen::MapGenerator::_calculateVertexNoise(int i, NoiseField &noiseMap) {
+    dcel::Vertex ver = _vertexMap->vertices[i];
+    return _normalizeNoise(noiseMap.getNoise(ver.position.x, ver.position.y));
+}
 
-double gen::MapGenerator::_calculateVertexNoise(int i, FastNoise &noiseMap) {
-    dcel::Vertex ver = _vertexMap.vertices[i];
-    return (noiseMap.GetNoise(ver.position.x, ver.position.y) + 1.0) / 2.0; // normalize
+double gen::MapGenerator::_normalizeNoise(double noise) {
+    return (noise + 1.0) / 2.0;
 }
 
-void gen::MapGenerator::_calculateBiomeMap(NodeMap<double> &biomeMap) {
+/*
+    Noise at the listed vertices, evaluated in blocks of gathered positions
+    so that the noise is batched with NoiseField::fillNoise
+*/
+void gen::MapGenerator::_fillVertexNoise(NoiseField &noiseMap, std::vector<int> &vertices,
+                                         std::vector<double> &noise) {
+    const int blockSize = 256;
+    double xs[blockSize];
+    double ys[blockSize];
+    noise.resize(vertices.size());
+    for (unsigned int start = 0; start < vertices.size(); start += blockSize) {
+        int count = std::min(blockSize, (int)(vertices.size() - start));
+        for (int k = 0; k < count; k++) {
+            dcel::Point p = _vertexMap->vertices[vertices[start + k]].position;
+            xs[k] = p.x;
+            ys[k] = p.y;
+        }
+        noiseMap.fillNoise(xs, ys, noise.data() + start, count);
+    }
+}
+
+void gen::MapGenerator::_calculateBiomeMap(LayerView<LayerValue> temperatureMap,
+                                           LayerView<LayerValue> precipitationMap,
+                                           LayerView<BiomeType> biomeMap) {
     if (!_isTemperatureCalculated || !_isPrecipitationCalculated) {
         config::print("Temperature and Precipitation must be calculated");
     } else { 
-        for (unsigned int i = 0; i < biomeMap.size(); i++) {
-            double temp = _temperatureMap(i);
-            double precip = _precipitationMap(i);
-            double b = 0.0;
-            b = _getLifeZone(temp, precip);
-
-            biomeMap.set(i, b);
+        for (int i = 0; i < biomeMap.size(); i++) {
+            double temp = temperatureMap[i];
+            double precip = precipitationMap[i];
+            biomeMap[i] = _getLifeZone(temp, precip);
         }
     }
 }
 
-double gen::MapGenerator::_getLifeZone(double temp, double precip) {
+gen::BiomeType gen::MapGenerator::_getLifeZone(double temp, double precip) {
     int i = int(floor(temp * 8.0));
     int j = int(floor(precip * 8.0));
     if (i < 2) { // Tundra
-        return 1.0;
+        return BiomeType::tundra;
     } else if (i >=2 && i < 6 && j < 1) { // Grassland-Steppe
-        return 2.0;
+        return BiomeType::grassland;
     } else if ((i >= 6 && j < 1) || (i >= 7 && j < 4)) { // Desert
-        return 3.0;
+        return BiomeType::desert;
     } else if ((i >= 2 && i < 7 && j >= 1 && j < 2) || (i == 7 && j >=1 && j <3 )) { // Woodland
-        return 4.0;
+        return BiomeType::woodland;
     }  else if (i >= 2 && i < 4 && j >= 2) { // Boreal Forest
-        return 5.0;
+        return BiomeType::borealForest;
     } else if (i >= 4 && i < 6 && j >=2 && j <7) { // Seasonal Forest
-        return 6.0;
+        return BiomeType::seasonalForest;
     } else if ((i == 6 && j >=3 && j < 5) || (i == 7 && j >= 4 && j < 6)) { // Savannah
-        return 7.0;
+        return BiomeType::savannah;
     } else { // Rainforest
-        return 8.0;
+        return BiomeType::rainforest;
     }
 
 }
 
 void gen::MapGenerator::_getBiomeDrawData(std::vector<jsoncons::json> &faceVertices) {
+    LayerView<BiomeType> biomeMap = _climateLayers.getChannel<BiomeType>("biome");
     double invwidth = 1.0 / (_extents.maxx - _extents.minx);
     double invheight = 1.0 / (_extents.maxy - _extents.miny);
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
-        dcel::Face f = _voronoi.faces[i];
-
-        if (f.outerComponent.ref == -1) {
+    for (int i = 0; i < _mesh.faceCount(); i++) {
+        if (_mesh.outerComponent(i) == -1) {
             continue;
         }
 
@@ -1086,163 +1225,136 @@ void gen::MapGenerator::_getBiomeDrawData(std::vector<jsoncons::json> &faceVerti
         }
         
 
-        dcel::HalfEdge h = _voronoi.outerComponent(f);
-        dcel::Ref startRef = h.id;
+        int h = _mesh.outerComponent(i);
+        int startRef = h;
 
         std::vector<double> vertices;
-        dcel::Vertex v;
         bool outOfBoundsEdge = false;
         do {
-            v = _voronoi.origin(h);
+            dcel::Point pos = _mesh.position(_mesh.origin(h));
             outOfBoundsEdge = !_isEdgeInMap(h);
-            vertices.push_back((v.position.x - _extents.minx) * invwidth);
-            vertices.push_back((v.position.y - _extents.miny) * invheight);
-            h = _voronoi.next(h);
-        } while (h.id != startRef && !outOfBoundsEdge);
+            vertices.push_back((pos.x - _extents.minx) * invwidth);
+            vertices.push_back((pos.y - _extents.miny) * invheight);
+            h = _mesh.next(h);
+        } while (h != startRef && !outOfBoundsEdge);
         if (outOfBoundsEdge) {
             continue;
         }
-        double type = _biomeMap(i);
-        faceVertices.push_back(_getBiomeJSON(i, vertices));
+        faceVertices.push_back(_getBiomeJSON(biomeMap[i], vertices));
     }
 }
 
-jsoncons::json gen::MapGenerator::_getBiomeJSON(double i, std::vector<double> &vertices) {
+jsoncons::json gen::MapGenerator::_getBiomeJSON(BiomeType type, std::vector<double> &vertices) {
     jsoncons::json json;
-    
-    double type = _biomeMap(i);
-    std::string name = _toBiomeString(type);
-    std::vector<double> neighbors;
-    _biomeMap.getNeighbours(i, neighbors);
-
-    std::vector<std::string> neighborTypes;
-
-    for(unsigned int i =0; i < neighbors.size(); i++) {
-        neighborTypes.push_back(_toBiomeString(neighbors[i]));
-    }
-
-
-    json["name"] = name;
+    json["name"] = _toBiomeString(type);
     json["vertices"] = vertices;
 
     return json;
 }
 
-std::string gen::MapGenerator::_toBiomeString(double v) {
-    if (v == 1.0) {
-        return "Tundra";
-    } else if (v == 2.0) {
-        return "Grassland";
-    } else if (v == 3.0) {
-        return "Desert";
-    } else if (v == 4.0) {
-        return "Steppe/Woodland";
-    } else if (v  == 5.0) {
-        return "Boreal Forest";
-    } else if (v == 6.0) {
-        return "Seasonal Forest";
-    } else if (v == 7.0) {
-        return "Savannah";
-    } else {        
-        return "Rainforest";
+std::string gen::MapGenerator::_toBiomeString(BiomeType v) {
+    switch (v) {
+        case BiomeType::tundra:         return "Tundra";
+        case BiomeType::grassland:      return "Grassland";
+        case BiomeType::desert:         return "Desert";
+        case BiomeType::woodland:       return "Steppe/Woodland";
+        case BiomeType::borealForest:   return "Boreal Forest";
+        case BiomeType::seasonalForest: return "Seasonal Forest";
+        case BiomeType::savannah:       return "Savannah";
+        default:                        return "Rainforest";
     }
 }
 
 void gen::MapGenerator::_fillDepressions() {
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    double maxHeight = _heightMap.getMax();
-    NodeMap<double> finalHeightMap(vmp, maxHeight);
-    dcel::Vertex v;
-    for (unsigned int i = 0; i < _vertexMap.edge.size(); i++) {
-        v = _vertexMap.edge[i];
-        finalHeightMap.set(v, _heightMap(v));
+    std::vector<int> edges;
+    edges.reserve(_vertexMap->edge.size());
+    for (unsigned int i = 0; i < _vertexMap->edge.size(); i++) {
+        edges.push_back(_vertexMap->getVertexIndex(_vertexMap->edge[i]));
     }
 
     double eps = 1e-5;
-    std::vector<int> *neighbours;
-    for (;;) {
-        bool heightUpdated = false;
-        for (unsigned int i = 0; i < _heightMap.size(); i++) {
-            if (_heightMap(i) == finalHeightMap(i)) {
-                continue;
-            }
+    NodeMap<LayerValue> finalHeightMap(_vertexMap, 0.0);
+    int numThreads = Parallel::getThreadCount(_numThreads);
+    if (numThreads > 1 && (int)_heightMap.size() >= _minParallelDrainageVertexCount) {
+        std::vector<int> tiles;
+        int numTiles = _getDrainageTiles(numThreads, tiles);
+        Drainage::fillDepressions(_heightMap.data(), (int)_heightMap.size(), _neighbourMap,
+                                  edges, eps, tiles, numTiles, numThreads,
+                                  finalHeightMap.data());
+    } else {
+        Drainage::fillDepressions(_heightMap.data(), (int)_heightMap.size(), _neighbourMap,
+                                  edges, eps, finalHeightMap.data());
+    }
 
-            neighbours = _neighbourMap.getPointer(i);
-            for (unsigned int nidx = 0; nidx < neighbours->size(); nidx++) {
-                double nval = finalHeightMap(neighbours->at(nidx));
-                if (_heightMap(i) >= nval + eps) {
-                    finalHeightMap.set(i, _heightMap(i));
-                    heightUpdated = true;
-                    break;
-                }
+    _heightMap = finalHeightMap;
+}
 
-                double hval = nval + eps;
-                if ((finalHeightMap(i) > hval) && (hval > _heightMap(i))) {
-                    finalHeightMap.set(i, hval);
-                    heightUpdated = true;
-                }
-            }
-        }
+/*
+    Split the vertices into a grid of roughly square tiles, with about
+    _drainageTilesPerThread tiles for each thread. Returns the number of
+    tiles.
+*/
+int gen::MapGenerator::_getDrainageTiles(int numThreads, std::vector<int> &tiles) {
+    double width = _extents.maxx - _extents.minx;
+    double height = _extents.maxy - _extents.miny;
+    int targetTiles = numThreads * _drainageTilesPerThread;
+    int isize = std::max(1, (int)(sqrt(targetTiles * width / height) + 0.5));
+    int jsize = std::max(1, (int)ceil((double)targetTiles / isize));
+    double dx = width / isize;
+    double dy = height / jsize;
 
-        if (!heightUpdated) {
-            break;
-        }
+    tiles.resize(_vertexMap->size());
+    for (unsigned int i = 0; i < _vertexMap->size(); i++) {
+        dcel::Point p = _vertexMap->vertices[i].position;
+        int ti = std::min(std::max((int)floor((p.x - _extents.minx) / dx), 0), isize - 1);
+        int tj = std::min(std::max((int)floor((p.y - _extents.miny) / dy), 0), jsize - 1);
+        tiles[i] = tj * isize + ti;
     }
 
-    _heightMap = finalHeightMap;
+    return isize * jsize;
 }
 
 void gen::MapGenerator::_calculateFlowMap(NodeMap<int> &flowMap) {
-    dcel::Vertex v, n;
-    std::vector<int> *nbs;
-    for (unsigned int i = 0; i < _vertexMap.interior.size(); i++) {
-        v = _vertexMap.interior[i];
-
-        nbs = _neighbourMap.getPointer(v);
-        dcel::Vertex minVertex;
-        double minHeight = _heightMap(v);
-        for (unsigned int nidx = 0; nidx < nbs->size(); nidx++) {
-            n = _vertexMap.vertices[nbs->at(nidx)];
-            if (!_vertexMap.isVertex(n)) {
-                continue;
-            }
-
-            if (_heightMap(n) < minHeight) {
-                minHeight = _heightMap(n);
-                minVertex = n;
-            }
-        }
+    std::vector<int> interior;
+    interior.reserve(_vertexMap->interior.size());
+    for (unsigned int i = 0; i < _vertexMap->interior.size(); i++) {
+        interior.push_back(_vertexMap->getVertexIndex(_vertexMap->interior[i]));
+    }
 
-        flowMap.set(v, flowMap.getNodeIndex(minVertex));
+    int numThreads = _numThreads;
+    if ((int)_heightMap.size() < _minParallelDrainageVertexCount) {
+        numThreads = 1;
     }
+    Drainage::getReceivers(_heightMap.data(), _neighbourMap, interior,
+                           numThreads, flowMap.data());
 }
 
-void gen::MapGenerator::_calculateFluxMap(NodeMap<double> &fluxMap) {
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<int> flowMap(vmp, -1);
+void gen::MapGenerator::_calculateFluxMap(NodeMap<LayerValue> &fluxMap) {
+    NodeMap<int> flowMap(_vertexMap, -1);
     _calculateFlowMap(flowMap);
 
-    for (unsigned int i = 0; i < flowMap.size(); i++) {
-        int next = i;
-        while (next != -1) {
-            fluxMap.set(next, fluxMap(next) + 1.0);
-            next = flowMap(next);
-        }
+    std::vector<int> flowOrder;
+    int numThreads = Parallel::getThreadCount(_numThreads);
+    if (numThreads > 1 && (int)flowMap.size() >= _minParallelDrainageVertexCount) {
+        Drainage::accumulateFlux(flowMap.data(), (int)flowMap.size(), numThreads,
+                                 flowOrder, fluxMap.data());
+    } else {
+        Drainage::getFlowOrder(flowMap.data(), (int)flowMap.size(), flowOrder);
+        Drainage::accumulateFlux(flowMap.data(), flowOrder, fluxMap.data());
     }
 
     double maxFlux = _calculateFluxCap(fluxMap);
+    LayerValue *flux = fluxMap.data();
     for (unsigned int i = 0; i < fluxMap.size(); i++) {
-        double f = fluxMap(i);
-        f = fmin(maxFlux, f);
-        f /= maxFlux;
-        fluxMap.set(i, f);
+        flux[i] = fmin(maxFlux, flux[i]) / maxFlux;
     }
 
     _fluxMap = fluxMap;
     _flowMap = flowMap;
+    _flowOrder = flowOrder;
 }
 
-double gen::MapGenerator::_calculateFluxCap(NodeMap<double> &fluxMap) {
+double gen::MapGenerator::_calculateFluxCap(NodeMap<LayerValue> &fluxMap) {
     double max = fluxMap.getMax();
 
     int nbins = 1000;
@@ -1250,9 +1362,9 @@ double gen::MapGenerator::_calculateFluxCap(NodeMap<double> &fluxMap) {
 
     double step = (double)max / (double)nbins;
     double invstep = 1.0 / step;
+    const LayerValue *flux = fluxMap.data();
     for (unsigned int i = 0; i < fluxMap.size(); i++) {
-        double f = fluxMap(i);
-        int binidx = (int)floor(f * invstep);
+        int binidx = (int)floor(flux[i] * invstep);
         if (binidx >= (int)bins.size()) {
             binidx = bins.size() - 1;
         }
@@ -1273,15 +1385,15 @@ double gen::MapGenerator::_calculateFluxCap(NodeMap<double> &fluxMap) {
     return maxflux;
 }
 
-void gen::MapGenerator::_calculateSlopeMap(NodeMap<double> &slopeMap) {
+void gen::MapGenerator::_calculateSlopeMap(NodeMap<LayerValue> &slopeMap) {
     for (unsigned int i = 0; i < slopeMap.size(); i++) {
         slopeMap.set(i, _calculateSlope(i));
     }
 }
 
 double gen::MapGenerator::_calculateSlope(int i) {
-    dcel::Vertex v = _vertexMap.vertices[i];
-    if (!_vertexMap.isInterior(v)) {
+    dcel::Vertex v = _vertexMap->vertices[i];
+    if (!_vertexMap->isInterior(v)) {
         return 0.0;
     }
 
@@ -1293,11 +1405,633 @@ double gen::MapGenerator::_calculateSlope(int i) {
     return slope;
 }
 
+/*
+    Each instruction is recorded with the height operations it generated
+    and the region of the map it can change, so that an edited instruction
+    can later be applied by updateInstruction() without re-running the
+    whole program.
+
+    When checkpoints are enabled with setCheckpointInterval(), the height
+    map is also saved every few instructions and after each erode, so that
+    resumeInstructions() can perform an edited program from the last
+    checkpoint before its first changed instruction.
+
+    Random values used by the instructions, such as noise seeds, are drawn
+    from a generator seeded once from rand(), so that other uses of rand()
+    after the program do not change the values drawn by a resumed program.
+*/
 void gen::MapGenerator::performInstructions() {
     gen::config::print("Performing instructions...");
 
-    for(unsigned int i = 0; i < _instructions.size(); i++) {
-        gen::MapGenerator::_performInstruction(_instructions[i]);
+    _executeHeightProgram();
+    _initialHeights.assign(_heightMap.data(), _heightMap.data() + _heightMap.size());
+    _isHeightMapErodedBeforeInstructions = _isHeightMapEroded;
+    _replayBaseHeights.clear();
+    _replayBaseIndex = 0;
+    _instructionRecords.clear();
+    _discardCheckpoints(-1);
+    _instructionRandom.seed((std::mt19937::result_type)rand());
+    _unusedInstructionRandomValues.clear();
+
+    std::vector<int> noReplayValues;
+    _performInstructionRange(0, noReplayValues);
+}
+
+/*
+    Perform the instructions read by readInstructionFile() after a previous
+    program, starting from the last checkpoint at or before the first
+    instruction that differs from the previous program. Returns the index
+    of the first instruction performed, or the instruction count if the
+    program is unchanged.
+
+    The instructions draw the random values drawn by the previous program
+    from the same position in order. When an edited program draws more
+    values than the previous one, the new values continue from the state
+    of the instruction random generator after the previous program, so
+    the heights are the same as when performing the edited program from
+    the same seed regardless of how rand() was used in between. Values
+    that the edited program does not use are kept for the next resumed
+    program. Climate layers that depend on changed vertices are marked
+    stale and can be brought up to date with updateBiomes().
+*/
+int gen::MapGenerator::resumeInstructions() {
+    if (!_isInitialized) {
+        throw std::runtime_error("MapGenerator must be initialized.");
+    }
+
+    if (_initialHeights.size() != _heightMap.size()) {
+        performInstructions();
+        return 0;
+    }
+
+    int numInstructions = (int)_instructions.size();
+    int numRecords = (int)_instructionRecords.size();
+    int firstChanged = 0;
+    while (firstChanged < numInstructions && firstChanged < numRecords &&
+            _isInstructionEqual(_instructions[firstChanged], 
+                                _instructionRecords[firstChanged].instruction)) {
+        firstChanged++;
+    }
+    if (firstChanged == numInstructions && firstChanged == numRecords) {
+        gen::config::print("Instructions are unchanged.");
+        return numInstructions;
+    }
+
+    // The heights after the last erode before the resumed instructions are
+    // needed to replay later edits, and are in the checkpoint after it
+    int cidx = _findCheckpoint(firstChanged);
+    int baseIndex = 0;
+    int baseCidx = -1;
+    while (cidx >= 0) {
+        baseIndex = 0;
+        for (int i = _checkpoints[cidx].instructionIndex - 1; i >= 0; i--) {
+            if (_instructionRecords[i].isBarrier) {
+                baseIndex = i + 1;
+                break;
+            }
+        }
+        baseCidx = _findCheckpoint(baseIndex);
+        if (baseIndex == 0 || 
+                (baseCidx >= 0 && _checkpoints[baseCidx].instructionIndex == baseIndex)) {
+            break;
+        }
+        cidx--;
+    }
+    int startIndex = cidx >= 0 ? _checkpoints[cidx].instructionIndex : 0;
+    if (cidx < 0) {
+        baseIndex = 0;
+    }
+
+    std::vector<LayerValue> previousHeights(_heightMap.data(), 
+                                            _heightMap.data() + _heightMap.size());
+    _heightProgram.clear();
+    if (cidx >= 0) {
+        _readCheckpoint(_checkpoints[cidx], _heightMap.data());
+    } else {
+        std::copy(_initialHeights.begin(), _initialHeights.end(), _heightMap.data());
+    }
+
+    _replayBaseIndex = baseIndex;
+    _replayBaseHeights.clear();
+    if (baseIndex > 0) {
+        _replayBaseHeights.resize(_heightMap.size());
+        _readCheckpoint(_checkpoints[baseCidx], _replayBaseHeights.data());
+    }
+
+    _isHeightMapEroded = baseIndex > 0 || _isHeightMapErodedBeforeInstructions;
+
+    std::vector<int> replayValues;
+    for (int i = startIndex; i < numRecords; i++) {
+        std::vector<int> &values = _instructionRecords[i].randomValues;
+        replayValues.insert(replayValues.end(), values.begin(), values.end());
+    }
+    replayValues.insert(replayValues.end(), _unusedInstructionRandomValues.begin(),
+                                            _unusedInstructionRandomValues.end());
+    _instructionRecords.resize(startIndex);
+    _discardCheckpoints(startIndex);
+
+    gen::config::print("Resuming instructions from instruction " + 
+                       gen::config::toString(startIndex) + 
+                       " (first changed instruction: " + 
+                       gen::config::toString(firstChanged) + ")...");
+    _performInstructionRange(startIndex, replayValues);
+
+    std::vector<int> changedVertices;
+    LayerValue *heights = _heightMap.data();
+    for (unsigned int i = 0; i < _heightMap.size(); i++) {
+        if (heights[i] != previousHeights[i]) {
+            changedVertices.push_back(i);
+        }
+    }
+    gen::config::print("Updated " + gen::config::toString(changedVertices.size()) +
+                       " vertices.");
+
+    _isLandFaceTableInitialized = false;
+    _markClimateStale(changedVertices);
+
+    return startIndex;
+}
+
+/*
+    Save the height map after every numInstructions instructions or after
+    milliseconds of work, whichever comes first, and after each erode.
+    Values <= 0 disable the corresponding interval. Pointwise instructions
+    are applied in batches, so their work is counted when the batch is
+    applied.
+*/
+void gen::MapGenerator::setCheckpointInterval(int numInstructions, double milliseconds) {
+    _checkpointInstructionInterval = numInstructions;
+    _checkpointTimeInterval = 0.001 * milliseconds;
+}
+
+/*
+    Store checkpoint heights in filename instead of in memory. An empty
+    filename stores them in memory.
+*/
+void gen::MapGenerator::setCheckpointFile(std::string filename) {
+    _discardCheckpoints(-1);
+    _checkpointFilename = filename;
+    _checkpointFileSize = 0;
+}
+
+void gen::MapGenerator::_performInstructionRange(int startIndex, 
+                                                 std::vector<int> &replayValues) {
+    _instructionRecords.reserve(_instructions.size());
+
+    StopWatch timer;
+    timer.start();
+    int lastCheckpointIndex = startIndex;
+    unsigned int replayIndex = 0;
+
+    beginHeightProgram();
+    for(unsigned int i = startIndex; i < _instructions.size(); i++) {
+        InstructionRecord record;
+        record.instruction = _instructions[i];
+        std::vector<int> values;
+        if (replayIndex < replayValues.size()) {
+            values.assign(replayValues.begin() + replayIndex, replayValues.end());
+        }
+        _beginInstructionRandomValues(values);
+        if (_isPointwiseInstruction(_instructions[i])) {
+            int begin = _heightProgram.size();
+            gen::MapGenerator::_performInstruction(_instructions[i]);
+            record.program = _heightProgram.slice(begin, _heightProgram.size());
+        } else {
+            record.isBarrier = true;
+            gen::MapGenerator::_performInstruction(_instructions[i]);
+            _replayBaseHeights.assign(_heightMap.data(), _heightMap.data() + _heightMap.size());
+            _replayBaseIndex = i + 1;
+        }
+        record.randomValues = _endInstructionRandomValues();
+        replayIndex += record.randomValues.size();
+        _initializeInstructionFootprint(record);
+        _instructionRecords.push_back(record);
+
+        if (!_isCheckpointEnabled()) {
+            continue;
+        }
+
+        timer.stop();
+        int count = i + 1 - lastCheckpointIndex;
+        bool isDue = record.isBarrier ||
+                     (_checkpointInstructionInterval > 0 && 
+                        count >= _checkpointInstructionInterval) ||
+                     (_checkpointTimeInterval > 0.0 && 
+                        timer.getTime() >= _checkpointTimeInterval);
+        if (isDue) {
+            _executeHeightProgram();
+            _addCheckpoint(i + 1);
+            lastCheckpointIndex = i + 1;
+            timer.reset();
+        }
+        timer.start();
+    }
+    endHeightProgram();
+
+    _unusedInstructionRandomValues.clear();
+    if (replayIndex < replayValues.size()) {
+        _unusedInstructionRandomValues.assign(replayValues.begin() + replayIndex, 
+                                              replayValues.end());
+    }
+}
+
+bool gen::MapGenerator::_isInstructionEqual(gen::MapInstruction &instruction1, 
+                                            gen::MapInstruction &instruction2) {
+    return instruction1.FnName == instruction2.FnName && 
+           instruction1.Params == instruction2.Params;
+}
+
+bool gen::MapGenerator::_isCheckpointEnabled() {
+    return _checkpointInstructionInterval > 0 || _checkpointTimeInterval > 0.0;
+}
+
+void gen::MapGenerator::_addCheckpoint(int instructionIndex) {
+    HeightCheckpoint checkpoint;
+    checkpoint.instructionIndex = instructionIndex;
+    if (_checkpointFilename.empty()) {
+        checkpoint.heights.assign(_heightMap.data(), _heightMap.data() + _heightMap.size());
+        _checkpoints.push_back(checkpoint);
+        return;
+    }
+
+    std::ios::openmode mode = std::ios::binary | std::ios::in | std::ios::out;
+    if (_checkpointFileSize == 0) {
+        mode |= std::ios::trunc;
+    }
+    std::fstream file(_checkpointFilename, mode);
+    file.seekp(_checkpointFileSize);
+    uint64_t numBytes = (uint64_t)_heightMap.size() * sizeof(LayerValue);
+    file.write((char*)_heightMap.data(), numBytes);
+    if (!file.good()) {
+        throw std::runtime_error("Unable to write checkpoint file: " + _checkpointFilename);
+    }
+
+    checkpoint.fileOffset = _checkpointFileSize;
+    _checkpointFileSize += numBytes;
+    _checkpoints.push_back(checkpoint);
+}
+
+void gen::MapGenerator::_readCheckpoint(HeightCheckpoint &checkpoint, LayerValue *heights) {
+    if (!checkpoint.heights.empty()) {
+        std::copy(checkpoint.heights.begin(), checkpoint.heights.end(), heights);
+        return;
+    }
+
+    std::ifstream file(_checkpointFilename, std::ios::binary);
+    file.seekg(checkpoint.fileOffset);
+    file.read((char*)heights, (uint64_t)_heightMap.size() * sizeof(LayerValue));
+    if (!file.good()) {
+        throw std::runtime_error("Unable to read checkpoint file: " + _checkpointFilename);
+    }
+}
+
+/*
+    Index of the last checkpoint taken at or before instructionIndex, or -1
+*/
+int gen::MapGenerator::_findCheckpoint(int instructionIndex) {
+    int cidx = -1;
+    for (unsigned int i = 0; i < _checkpoints.size(); i++) {
+        if (_checkpoints[i].instructionIndex > instructionIndex) {
+            break;
+        }
+        cidx = i;
+    }
+    return cidx;
+}
+
+/*
+    Remove the checkpoints taken after instructionIndex
+*/
+void gen::MapGenerator::_discardCheckpoints(int instructionIndex) {
+    int keep = _findCheckpoint(instructionIndex) + 1;
+    if (keep < (int)_checkpoints.size() && !_checkpointFilename.empty()) {
+        _checkpointFileSize = _checkpoints[keep].fileOffset;
+    }
+    _checkpoints.resize(keep);
+}
+
+/*
+    Replace instruction index and update the height map as if the program
+    had been performed with the new instruction.
+
+    Instructions other than erode change each vertex from its position and
+    current height only. When the edited instruction and every instruction
+    after it are of this kind, only the vertices in the footprints of the
+    old and new instruction can change, and they are recomputed from the
+    heights after the last erode by applying the recorded operations of the
+    instructions that overlap the footprints. Otherwise the whole recorded
+    program is replayed.
+
+    Random values drawn by the old instruction, such as noise seeds, are
+    reused by a new instruction with the same function, as they would be
+    when performing the edited program from the same seed.
+
+    Height changes made after performInstructions() other than through
+    updateInstruction() are overwritten in the recomputed region. Climate
+    layers that depend on changed vertices are marked stale and can be
+    brought up to date with updateBiomes().
+*/
+void gen::MapGenerator::updateInstruction(int index, gen::MapInstruction instruction) {
+    if (!_isInitialized) {
+        throw std::runtime_error("MapGenerator must be initialized.");
+    }
+
+    if (_instructionRecords.size() != _instructions.size()) {
+        throw std::runtime_error("Instructions must be performed before they can be updated.");
+    }
+
+    if (index < 0 || index >= (int)_instructions.size()) {
+        throw std::range_error("Instruction out of range: " + std::to_string(index));
+    }
+
+    InstructionRecord oldRecord = _instructionRecords[index];
+    InstructionRecord newRecord = _recordInstruction(instruction, oldRecord);
+    _instructions[index] = instruction;
+    _instructionRecords[index] = newRecord;
+
+    std::vector<int> changedVertices;
+    if (oldRecord.isBarrier || newRecord.isBarrier || index < _replayBaseIndex) {
+        _replayInstructions();
+        changedVertices.reserve(_heightMap.size());
+        for (unsigned int i = 0; i < _heightMap.size(); i++) {
+            changedVertices.push_back(i);
+        }
+    } else {
+        _replayInstructionRegion(oldRecord, newRecord, changedVertices);
+    }
+    gen::config::print("Updated " + gen::config::toString(changedVertices.size()) +
+                       " vertices for instruction " + gen::config::toString(index) + ".");
+
+    _discardCheckpoints(index);
+
+    _isLandFaceTableInitialized = false;
+    _markClimateStale(changedVertices);
+}
+
+/*
+    The map extents for an instruction that can change any vertex, and
+    empty extents for an instruction that changes no vertices
+*/
+Extents2d gen::MapGenerator::getInstructionFootprint(int index) {
+    if (index < 0 || index >= (int)_instructionRecords.size()) {
+        throw std::range_error("Instruction out of range: " + std::to_string(index));
+    }
+
+    InstructionRecord &record = _instructionRecords[index];
+    if (record.isGlobal) {
+        return _extents;
+    }
+    if (!record.hasFootprint) {
+        return Extents2d();
+    }
+    return record.footprint;
+}
+
+/*
+    Between beginHeightProgram() and endHeightProgram(), the pointwise
+    height primitives (hills, cones, depressions, pits, slopes, noise and
+    makeContinent) are collected and then applied in a single blocked sweep
+    over the height map. Operations that depend on other vertices, such as
+    normalize, relax and erode, apply the pending primitives first.
+*/
+void gen::MapGenerator::beginHeightProgram() {
+    _isHeightProgramRecording = true;
+}
+
+void gen::MapGenerator::endHeightProgram() {
+    _isHeightProgramRecording = false;
+    _executeHeightProgram();
+}
+
+void gen::MapGenerator::_updateHeightProgram() {
+    if (!_isHeightProgramRecording) {
+        _executeHeightProgram();
+    }
+}
+
+void gen::MapGenerator::_executeHeightProgram() {
+    if (_heightProgram.empty()) {
+        return;
+    }
+    _heightProgram.execute(_vertexGrid, _heightMap.data(), _numThreads);
+    _heightProgram.clear();
+}
+
+bool gen::MapGenerator::_isPointwiseInstruction(gen::MapInstruction& mapInstruction) {
+    return mapInstruction.FnName != "erode";
+}
+
+/*
+    Generates the height operations of a pointwise instruction without
+    applying them
+*/
+gen::MapGenerator::InstructionRecord gen::MapGenerator::_recordInstruction(
+                                            gen::MapInstruction& mapInstruction,
+                                            InstructionRecord& previous) {
+    InstructionRecord record;
+    record.instruction = mapInstruction;
+    if (!_isPointwiseInstruction(mapInstruction)) {
+        record.isBarrier = true;
+        _initializeInstructionFootprint(record);
+        return record;
+    }
+
+    std::vector<int> replayValues;
+    if (previous.instruction.FnName == mapInstruction.FnName) {
+        replayValues = previous.randomValues;
+    }
+
+    _executeHeightProgram();
+    bool isRecording = _isHeightProgramRecording;
+    _isHeightProgramRecording = true;
+    _beginInstructionRandomValues(replayValues);
+    _performInstruction(mapInstruction);
+    record.randomValues = _endInstructionRandomValues();
+    _isHeightProgramRecording = isRecording;
+
+    record.program = _heightProgram.slice(0, _heightProgram.size());
+    _heightProgram.clear();
+    _initializeInstructionFootprint(record);
+
+    return record;
+}
+
+/*
+    Between _beginInstructionRandomValues() and _endInstructionRandomValues(),
+    _instructionRand() returns replayValues in order before drawing new
+    values from the instruction random generator, and the values it
+    returns are collected
+*/
+void gen::MapGenerator::_beginInstructionRandomValues(std::vector<int> &replayValues) {
+    _isRecordingRandomValues = true;
+    _instructionRandomValues = replayValues;
+    _instructionRandomIndex = 0;
+}
+
+std::vector<int> gen::MapGenerator::_endInstructionRandomValues() {
+    _isRecordingRandomValues = false;
+    _instructionRandomValues.resize(_instructionRandomIndex);
+    std::vector<int> values;
+    values.swap(_instructionRandomValues);
+    return values;
+}
+
+int gen::MapGenerator::_instructionRand() {
+    if (!_isRecordingRandomValues) {
+        return rand();
+    }
+
+    if (_instructionRandomIndex < _instructionRandomValues.size()) {
+        return _instructionRandomValues[_instructionRandomIndex++];
+    }
+
+    int value = (int)(_instructionRandom() % ((unsigned long long)RAND_MAX + 1));
+    _instructionRandomValues.push_back(value);
+    _instructionRandomIndex++;
+    return value;
+}
+
+double gen::MapGenerator::_instructionRandomDouble(double min, double max) {
+    return min + (double)_instructionRand() / ((double)RAND_MAX / (max - min));
+}
+
+void gen::MapGenerator::_initializeInstructionFootprint(InstructionRecord &record) {
+    if (record.isBarrier || !record.program.isLocal()) {
+        record.isGlobal = true;
+        record.hasFootprint = true;
+        record.footprint = _extents;
+        return;
+    }
+    record.isGlobal = false;
+    record.hasFootprint = record.program.getExtents(record.footprint);
+}
+
+bool gen::MapGenerator::_isInstructionInRegion(InstructionRecord &record,
+                                               std::vector<Extents2d> &region) {
+    if (record.isGlobal) {
+        return true;
+    }
+    if (!record.hasFootprint) {
+        return false;
+    }
+    for (unsigned int i = 0; i < region.size(); i++) {
+        if (_isExtentsOverlapping(record.footprint, region[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Apply the recorded program to the heights from before the first
+    instruction. Erode instructions are performed again, other instructions
+    reuse their recorded operations.
+*/
+void gen::MapGenerator::_replayInstructions() {
+    _heightProgram.clear();
+    std::copy(_initialHeights.begin(), _initialHeights.end(), _heightMap.data());
+    _replayBaseHeights.clear();
+    _replayBaseIndex = 0;
+
+    beginHeightProgram();
+    for (unsigned int i = 0; i < _instructionRecords.size(); i++) {
+        InstructionRecord &record = _instructionRecords[i];
+        if (record.isBarrier) {
+            _performInstruction(record.instruction);
+            _replayBaseHeights.assign(_heightMap.data(), _heightMap.data() + _heightMap.size());
+            _replayBaseIndex = i + 1;
+        } else {
+            _heightProgram.append(record.program);
+        }
+    }
+    endHeightProgram();
+}
+
+/*
+    Recompute the vertices in the footprints of the old and new version of
+    an instruction from the heights after the last barrier instruction.
+    Instructions whose footprint does not overlap the region leave its
+    vertices unchanged and are skipped.
+*/
+void gen::MapGenerator::_replayInstructionRegion(InstructionRecord &oldRecord,
+                                                 InstructionRecord &newRecord,
+                                                 std::vector<int> &changedVertices) {
+    bool isGlobal = oldRecord.isGlobal || newRecord.isGlobal;
+    std::vector<Extents2d> region;
+    if (isGlobal) {
+        changedVertices.reserve(_heightMap.size());
+        for (unsigned int i = 0; i < _heightMap.size(); i++) {
+            changedVertices.push_back(i);
+        }
+    } else {
+        if (oldRecord.hasFootprint) {
+            region.push_back(oldRecord.footprint);
+        }
+        if (newRecord.hasFootprint) {
+            region.push_back(newRecord.footprint);
+        }
+
+        std::vector<int> found;
+        for (unsigned int r = 0; r < region.size(); r++) {
+            found.clear();
+            _vertexGrid.getVerticesInExtents(region[r], found);
+            for (unsigned int k = 0; k < found.size(); k++) {
+                dcel::Point p = _vertexMap->vertices[found[k]].position;
+                bool isFound = false;
+                for (unsigned int j = 0; j < r; j++) {
+                    if (region[j].containsPoint(p)) {
+                        isFound = true;
+                        break;
+                    }
+                }
+                if (!isFound) {
+                    changedVertices.push_back(found[k]);
+                }
+            }
+        }
+    }
+
+    if (changedVertices.empty()) {
+        return;
+    }
+
+    HeightProgram program;
+    for (unsigned int i = _replayBaseIndex; i < _instructionRecords.size(); i++) {
+        InstructionRecord &record = _instructionRecords[i];
+        if (isGlobal || _isInstructionInRegion(record, region)) {
+            program.append(record.program);
+        }
+    }
+
+    std::vector<LayerValue> &baseHeights = _replayBaseIndex == 0 ? _initialHeights :
+                                                                   _replayBaseHeights;
+    int count = (int)changedVertices.size();
+    std::vector<double> xs(count);
+    std::vector<double> ys(count);
+    LayerValue *heights = _heightMap.data();
+    for (int k = 0; k < count; k++) {
+        int vidx = changedVertices[k];
+        dcel::Point p = _vertexMap->vertices[vidx].position;
+        xs[k] = p.x;
+        ys[k] = p.y;
+        heights[vidx] = baseHeights[vidx];
+    }
+    program.execute(changedVertices.data(), xs.data(), ys.data(), count, heights);
+}
+
+void gen::MapGenerator::_markClimateStale(std::vector<int> &indices) {
+    if (!_isTemperatureCalculated || !_isPrecipitationCalculated) {
+        return;
+    }
+
+    _isClimateVertexStale.resize(_heightMap.size(), false);
+    for (unsigned int i = 0; i < indices.size(); i++) {
+        int idx = indices[i];
+        if (idx < 0 || idx >= (int)_isClimateVertexStale.size() || _isClimateVertexStale[idx]) {
+            continue;
+        }
+        _isClimateVertexStale[idx] = true;
+        _staleClimateVertices.push_back(idx);
     }
 }
 
@@ -1359,33 +2093,29 @@ void gen::MapGenerator::_getContourDrawData(std::vector<std::vector<double> > &d
 }
 
 void gen::MapGenerator::_getContourPaths(std::vector<VertexList> &paths) {
-    std::vector<int> adjacentEdgeCounts(_vertexMap.vertices.size(), 0);
-    std::vector<bool> isEdgeVisited(_voronoi.edges.size(), false);
-    dcel::HalfEdge h;
-    dcel::Vertex v1, v2;
-    for (unsigned int i = 0; i < _voronoi.edges.size(); i++) {
-        h = _voronoi.edges[i];
-        if (!_isEdgeInMap(h) || isEdgeVisited[h.id.ref]) { 
+    std::vector<int> adjacentEdgeCounts(_vertexMap->vertices.size(), 0);
+    std::vector<bool> isEdgeVisited(_mesh.edgeCount(), false);
+    for (int i = 0; i < _mesh.edgeCount(); i++) {
+        if (!_isEdgeInMap(i) || isEdgeVisited[i]) { 
             continue; 
         }
 
-        if (!_isContourEdge(h)) { 
+        if (!_isContourEdge(i)) { 
             continue; 
         }
 
-        v1 = _voronoi.origin(h);
-        v2 = _voronoi.origin(_voronoi.twin(h));
-        int idx1 = _vertexMap.getVertexIndex(v1);
-        int idx2 = _vertexMap.getVertexIndex(v2);
+        int twin = _mesh.twin(i);
+        int idx1 = _vertexMap->getVertexIndex(_mesh.origin(i));
+        int idx2 = _vertexMap->getVertexIndex(_mesh.origin(twin));
         adjacentEdgeCounts[idx1]++;
         adjacentEdgeCounts[idx2]++;
 
-        isEdgeVisited[h.id.ref] = true;
-        isEdgeVisited[h.twin.ref] = true;
+        isEdgeVisited[i] = true;
+        isEdgeVisited[twin] = true;
     }
 
-    std::vector<bool> isEndVertex(_vertexMap.vertices.size(), false);
-    std::vector<bool> isContourVertex(_vertexMap.vertices.size(), false);
+    std::vector<bool> isEndVertex(_vertexMap->vertices.size(), false);
+    std::vector<bool> isContourVertex(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < adjacentEdgeCounts.size(); i++) {
         if (adjacentEdgeCounts[i] == 1) {
             isEndVertex[i] = true;
@@ -1395,7 +2125,7 @@ void gen::MapGenerator::_getContourPaths(std::vector<VertexList> &paths) {
         }
     }
 
-    std::vector<bool> isVertexInContour(_vertexMap.vertices.size(), false);
+    std::vector<bool> isVertexInContour(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < isEndVertex.size(); i++) {
         if (!isEndVertex[i] || isVertexInContour[i]) {
             continue;
@@ -1435,7 +2165,7 @@ void gen::MapGenerator::_getLandFaces(std::vector<bool> &isLandFace) {
     _getFaceHeights(faceHeights);
 
     isLandFace.clear();
-    isLandFace.reserve(_voronoi.faces.size());
+    isLandFace.reserve(_mesh.faceCount());
     for (unsigned int i = 0; i < faceHeights.size(); i++) {
         isLandFace.push_back(_isLand(faceHeights[i]));
     }
@@ -1457,7 +2187,7 @@ bool gen::MapGenerator::_isLand(double isolevel) {
 
 void gen::MapGenerator::_cleanupLandFaces(std::vector<bool> &isLandFace) {
     std::vector<std::vector<int> > islands;
-    std::vector<bool> isFaceProcessed(_voronoi.faces.size(), false);
+    std::vector<bool> isFaceProcessed(_mesh.faceCount(), false);
     std::vector<int> connectedFaces;
     for (unsigned int i = 0; i < isLandFace.size(); i++) {
         if (isFaceProcessed[i]) {
@@ -1494,8 +2224,7 @@ void gen::MapGenerator::_getConnectedFaces(int seed,
         queue.pop_back();
 
         bool faceType = isLandFace[fidx];
-        for (unsigned int nidx = 0; nidx < _faceNeighbours[fidx].size(); nidx++) {
-            int nfidx = _faceNeighbours[fidx][nidx];
+        for (int nfidx : _faceNeighbours[fidx]) {
             if ((isLandFace[nfidx] == faceType) && !isFaceProcessed[nfidx]) {
                 queue.push_back(nfidx);
                 isFaceProcessed[nfidx] = true;
@@ -1507,24 +2236,21 @@ void gen::MapGenerator::_getConnectedFaces(int seed,
 }
 
 
-bool gen::MapGenerator::_isContourEdge(dcel::HalfEdge &h) {
-    dcel::Face f1 = _voronoi.incidentFace(h);
-    dcel::Face f2 = _voronoi.incidentFace(_voronoi.twin(h));
-    return (_isLandFace(f1.id.ref) && !_isLandFace(f2.id.ref)) ||
-           (_isLandFace(f2.id.ref) && !_isLandFace(f1.id.ref));
+bool gen::MapGenerator::_isContourEdge(int eidx) {
+    int f1 = _mesh.incidentFace(eidx);
+    int f2 = _mesh.incidentFace(_mesh.twin(eidx));
+    return (_isLandFace(f1) && !_isLandFace(f2)) ||
+           (_isLandFace(f2) && !_isLandFace(f1));
 }
 
 bool gen::MapGenerator::_isContourEdge(dcel::Vertex &v1, dcel::Vertex &v2) {
-    std::vector<dcel::HalfEdge> edges;
+    std::vector<int> edges;
     edges.reserve(3);
-    _voronoi.getIncidentEdges(v1, edges);
+    _mesh.getIncidentEdges(v1.id.ref, edges);
 
-    dcel::HalfEdge h;
-    dcel::Vertex v;
     for (unsigned int i = 0; i < edges.size(); i++) {
-        h = edges[i];
-        v = _voronoi.origin(_voronoi.twin(h));
-        if (v.id.ref == v2.id.ref) {
+        int h = edges[i];
+        if (_mesh.origin(_mesh.twin(h)) == v2.id.ref) {
             return _isContourEdge(h);
         }
     }
@@ -1536,19 +2262,17 @@ void gen::MapGenerator::_getContourPath(int seed, std::vector<bool> &isContourVe
                                                   std::vector<bool> &isEndVertex, 
                                                   std::vector<bool> &isVertexInContour, 
                                                   VertexList &path) {
-    dcel::Vertex v = _vertexMap.vertices[seed];
+    dcel::Vertex v = _vertexMap->vertices[seed];
     dcel::Vertex lastVertex = v;
 
-    std::vector<int> *nbs;
     for (;;) {
         path.push_back(v);
-        isVertexInContour[_vertexMap.getVertexIndex(v)] = true;
+        isVertexInContour[_vertexMap->getVertexIndex(v)] = true;
         
-        nbs = _neighbourMap.getPointer(v);
         bool isFound = false;
-        for (unsigned int i = 0; i < nbs->size(); i++) {
-            dcel::Vertex n = _vertexMap.vertices[nbs->at(i)];
-            int nidx = _vertexMap.getVertexIndex(n);
+        for (int nbidx : _neighbourMap[_vertexMap->getVertexIndex(v)]) {
+            dcel::Vertex n = _vertexMap->vertices[nbidx];
+            int nidx = _vertexMap->getVertexIndex(n);
             if (n.id.ref != lastVertex.id.ref && isContourVertex[nidx] && 
                     _isContourEdge(v, n)) {
                 lastVertex = v;
@@ -1562,7 +2286,7 @@ void gen::MapGenerator::_getContourPath(int seed, std::vector<bool> &isContourVe
             break;
         }
 
-        int vidx = _vertexMap.getVertexIndex(v);
+        int vidx = _vertexMap->getVertexIndex(v);
         if (isEndVertex[vidx] || isVertexInContour[vidx]) {
             path.push_back(v);
             isVertexInContour[vidx] = true;
@@ -1599,17 +2323,17 @@ void gen::MapGenerator::_getRiverPaths(std::vector<VertexList> &riverPaths) {
     VertexList riverVertices;
     _getRiverVertices(riverVertices);
 
-    std::vector<bool> isVertexInRiver(_vertexMap.vertices.size(), false);
+    std::vector<bool> isVertexInRiver(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < riverVertices.size(); i++) {
-        int idx = _vertexMap.getVertexIndex(riverVertices[i]);
+        int idx = _vertexMap->getVertexIndex(riverVertices[i]);
         isVertexInRiver[idx] = true;
     }
 
     VertexList fixedVertices;
     _getFixedRiverVertices(riverVertices, fixedVertices);
-    std::vector<bool> isFixedVertex(_vertexMap.vertices.size(), false);
+    std::vector<bool> isFixedVertex(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < fixedVertices.size(); i++) {
-        int vidx = _vertexMap.getVertexIndex(fixedVertices[i]);
+        int vidx = _vertexMap->getVertexIndex(fixedVertices[i]);
         isFixedVertex[vidx] = true;
     }
 
@@ -1622,12 +2346,12 @@ void gen::MapGenerator::_getRiverPaths(std::vector<VertexList> &riverPaths) {
         path.clear();
         int next = i;
         while (isVertexInRiver[next]) {
-            path.push_back(_vertexMap.vertices[next]);
+            path.push_back(_vertexMap->vertices[next]);
             next = _flowMap(next);
 
             if (next == -1) { break; }
             if (isFixedVertex[next]) {
-                path.push_back(_vertexMap.vertices[next]);
+                path.push_back(_vertexMap->vertices[next]);
                 break;
             }
         }
@@ -1638,50 +2362,66 @@ void gen::MapGenerator::_getRiverPaths(std::vector<VertexList> &riverPaths) {
     }
 }
 
+/*
+    River vertices are the vertices on the downstream paths of vertices with
+    enough flux, ending at the coast or at an outlet. Paths that leave the
+    land before reaching the coast are dropped. Whether the path from each
+    vertex is kept is resolved along the flow order, receivers first, so
+    each vertex is visited once. Flux does not decrease downstream, so only
+    vertices with enough flux can be on a path.
+*/
 void gen::MapGenerator::_getRiverVertices(VertexList &vertices) {
-    std::vector<bool> isVertexAdded(_vertexMap.vertices.size(), false);
-
-    dcel::Vertex v;
-    VertexList pathVertices;
-    for (unsigned int i = 0; i < _vertexMap.vertices.size(); i++) {
-        v = _vertexMap.vertices[i];
-        if (_fluxMap(v) < _riverFluxThreshold || _isCoastVertex(i)) {
+    int count = (int)_vertexMap->vertices.size();
+    std::vector<bool> isRiverFlux(count, false);
+    std::vector<bool> isCoast(count, false);
+    std::vector<bool> isLand(count, false);
+    for (int i = 0; i < count; i++) {
+        if (_fluxMap(i) >= _riverFluxThreshold) {
+            isRiverFlux[i] = true;
+            isCoast[i] = _isCoastVertex(i);
+            isLand[i] = isCoast[i] || _isLandVertex(i);
+        }
+    }
+
+    std::vector<bool> isPathKept(count, false);
+    for (unsigned int k = 0; k < _flowOrder.size(); k++) {
+        int v = _flowOrder[k];
+        if (!isRiverFlux[v]) {
             continue;
         }
 
-        int next = _flowMap.getNodeIndex(v);
-        pathVertices.clear();
-        while (next != -1) {
-            pathVertices.push_back(_vertexMap.vertices[next]);
-            if (_isCoastVertex(next)) { 
-                break; 
-            }
-            if (!_isLandVertex(next)) { 
-                pathVertices.clear();
-                break; 
-            }
-            next = _flowMap(next);
-        }
+        int next = _flowMap(v);
+        isPathKept[v] = isCoast[v] || (isLand[v] && (next == -1 || isPathKept[next]));
+    }
 
-        if (pathVertices.empty()) { continue; }
+    // Paths are added in vertex order, and a path can stop at the first
+    // vertex that is already added since the rest of it has been added
+    // with that vertex
+    std::vector<bool> isVertexAdded(count, false);
+    for (int i = 0; i < count; i++) {
+        if (!isRiverFlux[i] || isCoast[i] || !isPathKept[i]) {
+            continue;
+        }
 
-        for (unsigned int i = 0; i < pathVertices.size(); i++) {
-            int idx = _vertexMap.getVertexIndex(pathVertices[i]);
-            if (!isVertexAdded[idx]) {
-                vertices.push_back(pathVertices[i]);
-                isVertexAdded[idx] = true;
+        int next = i;
+        while (next != -1 && !isVertexAdded[next]) {
+            vertices.push_back(_vertexMap->vertices[next]);
+            isVertexAdded[next] = true;
+            if (isCoast[next]) {
+                break;
             }
+            next = _flowMap(next);
         }
     }
 }
 
 bool gen::MapGenerator::_isLandVertex(int vidx) {
-    std::vector<dcel::Face> faces;
+    std::vector<int> faces;
     faces.reserve(6);
-    _voronoi.getIncidentFaces(_vertexMap.vertices[vidx], faces);
+    _mesh.getIncidentFaces(_vertexMap->vertices[vidx].id.ref, faces);
 
     for (unsigned int i = 0; i < faces.size(); i++) {
-        if (_isLandFace(faces[i].id.ref)) {
+        if (_isLandFace(faces[i])) {
             return true;
         }
     }
@@ -1690,14 +2430,14 @@ bool gen::MapGenerator::_isLandVertex(int vidx) {
 }
 
 bool gen::MapGenerator::_isCoastVertex(int vidx) {
-    std::vector<dcel::Face> faces;
+    std::vector<int> faces;
     faces.reserve(6);
-    _voronoi.getIncidentFaces(_vertexMap.vertices[vidx], faces);
+    _mesh.getIncidentFaces(_vertexMap->vertices[vidx].id.ref, faces);
 
     bool hasLand = false;
     bool hasSea = false;
     for (unsigned int i = 0; i < faces.size(); i++) {
-        if (_isLandFace(faces[i].id.ref)) {
+        if (_isLandFace(faces[i])) {
             hasLand = true;
         } else {
             hasSea = true;
@@ -1709,27 +2449,23 @@ bool gen::MapGenerator::_isCoastVertex(int vidx) {
 
 void gen::MapGenerator::_getFixedRiverVertices(VertexList &riverVertices, 
                                                VertexList &fixedVertices) {
-    std::vector<bool> isVertexInRiver(_vertexMap.vertices.size(), false);
+    std::vector<bool> isVertexInRiver(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < riverVertices.size(); i++) {
-        int idx = _vertexMap.getVertexIndex(riverVertices[i]);
+        int idx = _vertexMap->getVertexIndex(riverVertices[i]);
         isVertexInRiver[idx] = true;
     }
 
-    std::vector<bool> isEdgeProcessed(_voronoi.edges.size(), false);
-    std::vector<int> adjacentEdgeCounts(_vertexMap.vertices.size(), 0);
+    std::vector<bool> isEdgeProcessed(_mesh.edgeCount(), false);
+    std::vector<int> adjacentEdgeCounts(_vertexMap->vertices.size(), 0);
 
-    dcel::HalfEdge h;
-    dcel::Vertex p1, p2;
-    for (unsigned int i = 0; i < _voronoi.edges.size(); i++) {
-        h = _voronoi.edges[i];
-        if (!_isEdgeInMap(h) || isEdgeProcessed[h.id.ref]) { 
+    for (int i = 0; i < _mesh.edgeCount(); i++) {
+        if (!_isEdgeInMap(i) || isEdgeProcessed[i]) { 
             continue; 
         }
 
-        p1 = _voronoi.origin(h);
-        p2 = _voronoi.origin(_voronoi.twin(h));
-        int idx1 = _vertexMap.getVertexIndex(p1);
-        int idx2 = _vertexMap.getVertexIndex(p2);
+        int twin = _mesh.twin(i);
+        int idx1 = _vertexMap->getVertexIndex(_mesh.origin(i));
+        int idx2 = _vertexMap->getVertexIndex(_mesh.origin(twin));
 
         if (!isVertexInRiver[idx1] || !isVertexInRiver[idx2]) {
             continue;
@@ -1738,13 +2474,13 @@ void gen::MapGenerator::_getFixedRiverVertices(VertexList &riverVertices,
         adjacentEdgeCounts[idx1]++;
         adjacentEdgeCounts[idx2]++;
 
-        isEdgeProcessed[h.id.ref] = true;
-        isEdgeProcessed[h.twin.ref] = true;
+        isEdgeProcessed[i] = true;
+        isEdgeProcessed[twin] = true;
     }
 
     for (unsigned int i = 0; i < adjacentEdgeCounts.size(); i++) {
         if (adjacentEdgeCounts[i] == 1 || adjacentEdgeCounts[i] == 3) {
-            fixedVertices.push_back(_vertexMap.vertices[i]);
+            fixedVertices.push_back(_vertexMap->vertices[i]);
         }
     }
 }
@@ -1792,11 +2528,10 @@ void gen::MapGenerator::_getSlopeDrawData(std::vector<double> &data) {
 }
 
 void gen::MapGenerator::_getSlopeSegments(std::vector<Segment> &segments) {
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<double> slopeMap(vmp, 0.0);
+    NodeMap<LayerValue> slopeMap(_vertexMap, 0.0);
     _calculateHorizontalSlopeMap(slopeMap);
 
-    NodeMap<double> nearSlopeMap(vmp, 0.0);
+    NodeMap<LayerValue> nearSlopeMap(_vertexMap, 0.0);
     _calculateVerticalSlopeMap(nearSlopeMap);
 
     std::vector<double> faceSlopes = _computeFaceValues(slopeMap);
@@ -1836,15 +2571,15 @@ void gen::MapGenerator::_getSlopeSegments(std::vector<Segment> &segments) {
     }
 }
 
-void gen::MapGenerator::_calculateHorizontalSlopeMap(NodeMap<double> &slopeMap) {
+void gen::MapGenerator::_calculateHorizontalSlopeMap(NodeMap<LayerValue> &slopeMap) {
     for (unsigned int i = 0; i < slopeMap.size(); i++) {
         slopeMap.set(i, _calculateHorizontalSlope(i));
     }
 }
 
 double gen::MapGenerator::_calculateHorizontalSlope(int i) {
-    dcel::Vertex v = _vertexMap.vertices[i];
-    if (!_vertexMap.isInterior(v)) {
+    dcel::Vertex v = _vertexMap->vertices[i];
+    if (!_vertexMap->isInterior(v)) {
         return 0.0;
     }
 
@@ -1854,15 +2589,15 @@ double gen::MapGenerator::_calculateHorizontalSlope(int i) {
     return nx;
 }
 
-void gen::MapGenerator::_calculateVerticalSlopeMap(NodeMap<double> &slopeMap) {
+void gen::MapGenerator::_calculateVerticalSlopeMap(NodeMap<LayerValue> &slopeMap) {
     for (unsigned int i = 0; i < slopeMap.size(); i++) {
         slopeMap.set(i, _calculateVerticalSlope(i));
     }
 }
 
 double gen::MapGenerator::_calculateVerticalSlope(int i) {
-    dcel::Vertex v = _vertexMap.vertices[i];
-    if (!_vertexMap.isInterior(v)) {
+    dcel::Vertex v = _vertexMap->vertices[i];
+    if (!_vertexMap->isInterior(v)) {
         return 0.0;
     }
 
@@ -1874,21 +2609,21 @@ double gen::MapGenerator::_calculateVerticalSlope(int i) {
 
 void gen::MapGenerator::_calculateVertexNormal(int vidx, 
                                                double *nx, double *ny, double *nz) {
-    std::vector<int> *nbs = _neighbourMap.getPointer(vidx);
-    if (nbs->size() != 3) {
+    IndexRange nbs = _neighbourMap[vidx];
+    if (nbs.size() != 3) {
         return;
     }
 
-    dcel::Point p0 = _vertexMap.vertices[nbs->at(0)].position;
-    dcel::Point p1 = _vertexMap.vertices[nbs->at(1)].position;
-    dcel::Point p2 = _vertexMap.vertices[ nbs->at(2)].position;
+    dcel::Point p0 = _vertexMap->vertices[nbs[0]].position;
+    dcel::Point p1 = _vertexMap->vertices[nbs[1]].position;
+    dcel::Point p2 = _vertexMap->vertices[nbs[2]].position;
 
     double v0x = p1.x - p0.x;
     double v0y = p1.y - p0.y;
-    double v0z = _heightMap(nbs->at(1)) - _heightMap(nbs->at(0));
+    double v0z = _heightMap(nbs[1]) - _heightMap(nbs[0]);
     double v1x = p2.x - p0.x;
     double v1y = p2.y - p0.y;
-    double v1z = _heightMap(nbs->at(2)) - _heightMap(nbs->at(0));
+    double v1z = _heightMap(nbs[2]) - _heightMap(nbs[0]);
 
     double vnx = v0y*v1z - v0z*v1y;
     double vny = v0z*v1x - v0x*v1z;
@@ -1926,8 +2661,7 @@ void gen::MapGenerator::_getTownDrawData(std::vector<double> &data) {
 }
 
 gen::MapGenerator::CityLocation gen::MapGenerator::_getCityLocation() {
-    std::shared_ptr<VertexMap> vmp = std::make_shared<VertexMap>(_vertexMap);
-    NodeMap<double> cityScores(vmp, 0.0);
+    NodeMap<LayerValue> cityScores(_vertexMap, 0.0);
     _getCityScores(cityScores);
 
     std::vector<double> faceScores = _computeFaceValues(cityScores);
@@ -1949,9 +2683,9 @@ gen::MapGenerator::CityLocation gen::MapGenerator::_getCityLocation() {
     return loc;
 }
 
-void gen::MapGenerator::_getCityScores(NodeMap<double> &cityScores) {
-    NodeMap<double> fluxMap = _fluxMap;
-    fluxMap.relax();
+void gen::MapGenerator::_getCityScores(NodeMap<LayerValue> &cityScores) {
+    NodeMap<LayerValue> fluxMap = _fluxMap;
+    fluxMap.relax(_neighbourMap);
 
     double neginf = -1e2;
     double eps = 1e-6;
@@ -1964,7 +2698,7 @@ void gen::MapGenerator::_getCityScores(NodeMap<double> &cityScores) {
 
         score += _fluxScoreBonus * sqrt(fluxMap(i));
 
-        p = _vertexMap.vertices[i].position;
+        p = _vertexMap->vertices[i].position;
         double extentsDist = fmax(0.0, _pointToEdgeDistance(p));
         score -= _nearEdgeScorePenalty * (1.0 / (extentsDist + eps));
 
@@ -2008,14 +2742,14 @@ void gen::MapGenerator::_updateCityMovementCost(City &city) {
     _getFaceHeights(faceHeights);
     std::vector<double> faceFlux = _computeFaceValues(_fluxMap);
     std::vector<dcel::Point> facePositions = _computeFacePositions();
-    std::vector<bool> isFaceInMap(_voronoi.faces.size(), false);
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
+    std::vector<bool> isFaceInMap(_mesh.faceCount(), false);
+    for (int i = 0; i < _mesh.faceCount(); i++) {
         isFaceInMap[i] = _extents.containsPoint(facePositions[i]);
     }
 
     double inf = std::numeric_limits<double>::infinity();
-    std::vector<double> movementCosts(_voronoi.faces.size(), inf);
-    std::vector<int> parents(_voronoi.faces.size(), -1);
+    std::vector<double> movementCosts(_mesh.faceCount(), inf);
+    std::vector<int> parents(_mesh.faceCount(), -1);
     int rootid = city.faceid;
     movementCosts[rootid] = 0;
     std::queue<int> queue;
@@ -2025,8 +2759,7 @@ void gen::MapGenerator::_updateCityMovementCost(City &city) {
         int fidx = queue.front();
         queue.pop();
 
-        for (unsigned int idx = 0; idx < _faceNeighbours[fidx].size(); idx++) {
-            int nidx = _faceNeighbours[fidx][idx];
+        for (int nidx : _faceNeighbours[fidx]) {
             if (!isFaceInMap[nidx] || movementCosts[nidx] != inf) {
                 continue;
             }
@@ -2087,7 +2820,7 @@ void gen::MapGenerator::_getTerritoryDrawData(
 }
 
 void gen::MapGenerator::_getTerritoryBorders(std::vector<VertexList> &borders) {
-    std::vector<int> faceTerritories(_voronoi.faces.size(), -1);
+    std::vector<int> faceTerritories(_mesh.faceCount(), -1);
     _getFaceTerritories(faceTerritories);
     _territoryData = faceTerritories;
 
@@ -2096,8 +2829,8 @@ void gen::MapGenerator::_getTerritoryBorders(std::vector<VertexList> &borders) {
 
 void gen::MapGenerator::_getFaceTerritories(std::vector<int> &faceTerritories) {
     std::vector<dcel::Point> facePositions = _computeFacePositions();
-    std::vector<bool> isFaceInMap(_voronoi.faces.size(), false);
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
+    std::vector<bool> isFaceInMap(_mesh.faceCount(), false);
+    for (int i = 0; i < _mesh.faceCount(); i++) {
         isFaceInMap[i] = _extents.containsPoint(facePositions[i]);
     }
 
@@ -2150,8 +2883,7 @@ void gen::MapGenerator::_smoothTerritoryBoundaries(
         }
 
         std::fill(neighbourCounts.begin(), neighbourCounts.end(), 0);
-        for (unsigned int idx = 0; idx < _faceNeighbours[fidx].size(); idx++) {
-            int nidx = _faceNeighbours[fidx][idx];
+        for (int nidx : _faceNeighbours[fidx]) {
             if (faceTerritories[nidx] == -1) {
                 continue;
             }
@@ -2204,8 +2936,7 @@ void gen::MapGenerator::_getConnectedTerritory(int fidx,
         fidx = queue.back();
         queue.pop_back();
 
-        for (unsigned int idx = 0; idx < _faceNeighbours[fidx].size(); idx++) {
-            int nidx = _faceNeighbours[fidx][idx];
+        for (int nidx : _faceNeighbours[fidx]) {
             if (faceTerritories[nidx] == -1) {
                 continue;
             }
@@ -2259,8 +2990,7 @@ int gen::MapGenerator::_getTerritoryOwner(std::vector<int> &territory,
     for (unsigned int i = 0; i < territory.size(); i++) {
         int fidx = territory[i];
 
-        for (unsigned int idx = 0; idx < _faceNeighbours[fidx].size(); idx++) {
-            int nidx = _faceNeighbours[fidx][idx];
+        for (int nidx : _faceNeighbours[fidx]) {
             if (faceTerritories[nidx] == -1 || isFaceProcessed[nidx]) {
                 continue;
             }
@@ -2283,31 +3013,27 @@ int gen::MapGenerator::_getTerritoryOwner(std::vector<int> &territory,
 
 void gen::MapGenerator::_getBorderPaths(std::vector<int> &faceTerritories, 
                                         std::vector<VertexList> &borders) {
-    std::vector<dcel::HalfEdge> borderEdges;
+    std::vector<int> borderEdges;
     _getBorderEdges(faceTerritories, borderEdges);
 
-    std::vector<int> vertexBorderCounts(_vertexMap.vertices.size(), 0);
-    dcel::HalfEdge h;
-    dcel::Vertex v1, v2;
+    std::vector<int> vertexBorderCounts(_vertexMap->vertices.size(), 0);
     for (unsigned int i = 0; i < borderEdges.size(); i++) {
-        h = borderEdges[i];
-        v1 = _voronoi.origin(h);
-        v2 = _voronoi.origin(_voronoi.twin(h));
-        int vidx1 = _vertexMap.getVertexIndex(v1);
-        int vidx2 = _vertexMap.getVertexIndex(v2);
+        int h = borderEdges[i];
+        int vidx1 = _vertexMap->getVertexIndex(_mesh.origin(h));
+        int vidx2 = _vertexMap->getVertexIndex(_mesh.origin(_mesh.twin(h)));
 
         vertexBorderCounts[vidx1]++;
         vertexBorderCounts[vidx2]++;
     }
 
-    std::vector<bool> isEndVertex(_vertexMap.vertices.size(), false);
+    std::vector<bool> isEndVertex(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < vertexBorderCounts.size(); i++) {
         if (vertexBorderCounts[i] == 1 || vertexBorderCounts[i] == 3) {
             isEndVertex[i] = true;
         }
     }
 
-    std::vector<bool> isVertexProcessed(_vertexMap.vertices.size(), false);
+    std::vector<bool> isVertexProcessed(_vertexMap->vertices.size(), false);
     for (unsigned int i = 0; i < isEndVertex.size(); i++) {
         if (!isEndVertex[i]) {
             continue;
@@ -2328,29 +3054,24 @@ void gen::MapGenerator::_getBorderPaths(std::vector<int> &faceTerritories,
 }
 
 void gen::MapGenerator::_getBorderEdges(std::vector<int> &faceTerritories, 
-                                        std::vector<dcel::HalfEdge> &borderEdges) {
-    std::vector<bool> isEdgeVisited(_voronoi.edges.size(), false);
-    dcel::HalfEdge h;
-    for (unsigned int i = 0; i < _voronoi.edges.size(); i++) {
-        h = _voronoi.edges[i];
-        if (!_isEdgeInMap(h) || isEdgeVisited[h.id.ref]) { 
+                                        std::vector<int> &borderEdges) {
+    std::vector<bool> isEdgeVisited(_mesh.edgeCount(), false);
+    for (int i = 0; i < _mesh.edgeCount(); i++) {
+        if (!_isEdgeInMap(i) || isEdgeVisited[i]) { 
             continue; 
         }
 
-        if (_isBorderEdge(h, faceTerritories)) { 
-            borderEdges.push_back(h);
-            isEdgeVisited[h.id.ref] = true;
-            isEdgeVisited[h.twin.ref] = true;
+        if (_isBorderEdge(i, faceTerritories)) { 
+            borderEdges.push_back(i);
+            isEdgeVisited[i] = true;
+            isEdgeVisited[_mesh.twin(i)] = true;
         }
     }
 }
 
-bool gen::MapGenerator::_isBorderEdge(dcel::HalfEdge &h, 
-                                      std::vector<int> &faceTerritories) {
-    dcel::Face f1 = _voronoi.incidentFace(h);
-    dcel::Face f2 = _voronoi.incidentFace(_voronoi.twin(h));
-    int city1 = faceTerritories[f1.id.ref];
-    int city2 = faceTerritories[f2.id.ref];
+bool gen::MapGenerator::_isBorderEdge(int eidx, std::vector<int> &faceTerritories) {
+    int city1 = faceTerritories[_mesh.incidentFace(eidx)];
+    int city2 = faceTerritories[_mesh.incidentFace(_mesh.twin(eidx))];
     
     if (city1 == -1 || city2 == -1) {
         return false;
@@ -2361,16 +3082,13 @@ bool gen::MapGenerator::_isBorderEdge(dcel::HalfEdge &h,
 
 bool gen::MapGenerator::_isBorderEdge(dcel::Vertex &v1, dcel::Vertex &v2, 
                                       std::vector<int> &faceTerritories) {
-    std::vector<dcel::HalfEdge> edges;
+    std::vector<int> edges;
     edges.reserve(3);
-    _voronoi.getIncidentEdges(v1, edges);
+    _mesh.getIncidentEdges(v1.id.ref, edges);
 
-    dcel::HalfEdge h;
-    dcel::Vertex v;
     for (unsigned int i = 0; i < edges.size(); i++) {
-        h = edges[i];
-        v = _voronoi.origin(_voronoi.twin(h));
-        if (v.id.ref == v2.id.ref) {
+        int h = edges[i];
+        if (_mesh.origin(_mesh.twin(h)) == v2.id.ref) {
             return _isBorderEdge(h, faceTerritories);
         }
     }
@@ -2384,19 +3102,18 @@ void gen::MapGenerator::_getBorderPath(int vidx,
                                        std::vector<bool> &isVertexProcessed,
                                        VertexList &path) {
 
-    dcel::Vertex v = _vertexMap.vertices[vidx];
+    dcel::Vertex v = _vertexMap->vertices[vidx];
     dcel::Vertex lastVertex = v;
 
-    std::vector<int> *nbs;
     for (;;) {
         path.push_back(v);
-        isVertexProcessed[_vertexMap.getVertexIndex(v)] = true;
+        isVertexProcessed[_vertexMap->getVertexIndex(v)] = true;
         
-        nbs = _neighbourMap.getPointer(v);
+        IndexRange nbs = _neighbourMap[_vertexMap->getVertexIndex(v)];
         bool isFound = false;
-        for (unsigned int i = 0; i < nbs->size(); i++) {
-            dcel::Vertex n = _vertexMap.vertices[nbs->at(i)];
-            int nidx = _vertexMap.getVertexIndex(n);
+        for (int nbidx : nbs) {
+            dcel::Vertex n = _vertexMap->vertices[nbidx];
+            int nidx = _vertexMap->getVertexIndex(n);
             if (n.id.ref != lastVertex.id.ref && 
                             _isBorderEdge(v, n, faceTerritories) && 
                             !isVertexProcessed[nidx]) {
@@ -2408,9 +3125,9 @@ void gen::MapGenerator::_getBorderPath(int vidx,
         }
 
         if (!isFound) {
-            for (unsigned int i = 0; i < nbs->size(); i++) {
-                dcel::Vertex n = _vertexMap.vertices[nbs->at(i)];;
-                int nidx = _vertexMap.getVertexIndex(n);
+            for (int nbidx : nbs) {
+                dcel::Vertex n = _vertexMap->vertices[nbidx];
+                int nidx = _vertexMap->getVertexIndex(n);
                 if (isEndVertex[nidx]) {
                     path.push_back(n);
                     isVertexProcessed[nidx] = true;
@@ -2423,7 +3140,7 @@ void gen::MapGenerator::_getBorderPath(int vidx,
             break;
         }
 
-        int vidx = _vertexMap.getVertexIndex(v);
+        int vidx = _vertexMap->getVertexIndex(v);
         if (isEndVertex[vidx]) {
             path.push_back(v);
             isVertexProcessed[vidx] = true;
@@ -3060,8 +3777,8 @@ void gen::MapGenerator::_initializeAreaLabelOrientationScores(std::vector<Label>
 
 void gen::MapGenerator::_initializeAreaLabelOrientationScore(Label &label) {
     std::vector<dcel::Point> facePositions = _computeFacePositions();
-    std::vector<bool> isFaceInMap(_voronoi.faces.size(), false);
-    for (unsigned int i = 0; i < _voronoi.faces.size(); i++) {
+    std::vector<bool> isFaceInMap(_mesh.faceCount(), false);
+    for (int i = 0; i < _mesh.faceCount(); i++) {
         isFaceInMap[i] = _extents.containsPoint(facePositions[i]);
     }
 
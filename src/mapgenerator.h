@@ -9,20 +9,32 @@
 #include <queue>
 #include <string>
 #include <map>
+#include <random>
 
 #include "jsoncons/json.hpp"
 #include "extents2d.h"
 #include "dcel.h"
+#include "flatdcel.h"
+#include "meshfile.h"
+#include "meshcache.h"
 #include "poissondiscsampler.h"
 #include "delaunay.h"
+#include "sweephull.h"
 #include "voronoi.h"
 #include "vertexmap.h"
 #include "nodemap.h"
+#include "layerstack.h"
+#include "heightprogram.h"
+#include "vertexgrid.h"
+#include "adjacencylist.h"
+#include "drainage.h"
+#include "parallel.h"
 #include "fontface.h"
 #include "spatialpointgrid.h"
 #include "resources.h"
 #include "stopwatch.h"
 #include "fastnoise.h"
+#include "noisefield.h"
 #include "config.h"
 #include "cereal/cereal.hpp"
 #include "cereal/types/string.hpp"
@@ -35,6 +47,29 @@
 
 namespace gen {
 
+	enum class SamplerType : char {
+		bridson = 0x00,
+		tiled = 0x01,
+		tileset = 0x02
+	};
+
+	enum class TriangulatorType : char {
+		sweephull = 0x00,
+		incremental = 0x01
+	};
+
+	enum class BiomeType : char {
+		none = 0x00,
+		tundra = 0x01,
+		grassland = 0x02,
+		desert = 0x03,
+		woodland = 0x04,
+		borealForest = 0x05,
+		seasonalForest = 0x06,
+		savannah = 0x07,
+		rainforest = 0x08
+	};
+
 	class MapGenerator {
 
 	public:
@@ -44,6 +79,12 @@ namespace gen {
 		MapGenerator(Extents2d extents, double resolution);
 
 		void initialize();
+		void setSamplerType(SamplerType type);
+		void setTriangulatorType(TriangulatorType type);
+		void setMeshLayout(dcel::MeshLayout layout);
+		void setThreadCount(int numThreads);
+		void setMeshCache(std::string directory, uint64_t maxBytes);
+		void setNoiseField(NoiseFieldSampling sampling, std::string cacheDirectory);
 		void normalize();
 		void round();
 		void relax();
@@ -63,12 +104,22 @@ namespace gen {
 		double randomDouble(double min, double max);
 
 		void generateBiomes();
+		void updateBiomes();
 		
 		void performInstructions();
+		void updateInstruction(int index, gen::MapInstruction instruction);
+		int resumeInstructions();
+		void setCheckpointInterval(int numInstructions, double milliseconds);
+		void setCheckpointFile(std::string filename);
+		Extents2d getInstructionFootprint(int index);
+		void beginHeightProgram();
+		void endHeightProgram();
 		void addInstruction(gen::MapInstruction instruction);
 
 		void addCity(std::string cityName, std::string territoryName);
 		void addTown(std::string townName);
+		void clearCities();
+		void clearTowns();
 
 		void readHeightMapFile(std::string filename);
 		void readVoronoiFile(std::string filename);
@@ -171,6 +222,22 @@ namespace gen {
 			double score = 0.0;
 		};
 
+		struct InstructionRecord {
+			MapInstruction instruction;
+			HeightProgram program;       // pointwise operations of the instruction
+			Extents2d footprint;         // bounds of the vertices it can change
+			bool hasFootprint = false;   // false if it changes no vertices
+			bool isGlobal = false;       // can change any vertex
+			bool isBarrier = false;      // reads neighbouring vertices (erode)
+			std::vector<int> randomValues;    // random values drawn by the instruction
+		};
+
+		struct HeightCheckpoint {
+			int instructionIndex = 0;           // instructions performed before the checkpoint
+			std::vector<LayerValue> heights;    // empty when stored in the checkpoint file
+			uint64_t fileOffset = 0;
+		};
+
 		struct LabelOffset {
 			dcel::Point offset;
 			double score = 0.0;
@@ -180,6 +247,10 @@ namespace gen {
 		};
 
 		void _initializeVoronoiData();
+		void _initializeCachedVoronoiData();
+		MeshCache::Key _getMeshCacheKey(unsigned int seed);
+		void _printPredicateStats();
+		void _printMeshMemoryReport();
 		void _initializeMapData();
 		void _initializeNeighbourMap();
 		void _initializeFaceNeighbours();
@@ -188,35 +259,70 @@ namespace gen {
 		jsoncons::json _getExtentsJSON();
 		void _outputVertices(std::vector<dcel::Vertex>& verts,
 			std::string filename);
-		std::vector<double> _computeFaceValues(NodeMap<double>& heightMap);
+		std::vector<double> _computeFaceValues(NodeMap<LayerValue>& heightMap);
 		std::vector<dcel::Point> _computeFacePositions();
 		dcel::Point _computeFacePosition(int fidx);
-		bool _isEdgeInMap(dcel::HalfEdge& h);
-		bool _isContourEdge(dcel::HalfEdge& h,
+		bool _isEdgeInMap(int eidx);
+		bool _isContourEdge(int eidx,
 			std::vector<double>& faceheights,
 			double isolevel);
-		void _calculateErosionMap(NodeMap<double>& erosionMap);
+		void _calculateErosionMap(NodeMap<LayerValue>& erosionMap);
 		void _fillDepressions();
+		int _getDrainageTiles(int numThreads, std::vector<int>& tiles);
 		void _calculateFlowMap(NodeMap<int>& flowMap);
-		void _calculateFluxMap(NodeMap<double>& fluxMap);
-		double _calculateFluxCap(NodeMap<double>& fluxMap);
-		void _calculateSlopeMap(NodeMap<double>& slopeMap);
+		void _calculateFluxMap(NodeMap<LayerValue>& fluxMap);
+		double _calculateFluxCap(NodeMap<LayerValue>& fluxMap);
+		void _calculateSlopeMap(NodeMap<LayerValue>& slopeMap);
 		double _calculateSlope(int i);
 
 		void _performInstruction(MapInstruction& mapInstruction);
-
-		void _calculatePrecipitationMap(NodeMap<double>& precipitationMap);
-		void _calculateTemperatureMap(NodeMap<double>& temperatureMap);
-		void _calculateBiomeMap(NodeMap<double>& biomeMap);
-		double _getLifeZone(double temp, double precip);
+		bool _isPointwiseInstruction(MapInstruction& mapInstruction);
+		InstructionRecord _recordInstruction(MapInstruction& mapInstruction,
+			InstructionRecord& previous);
+		void _beginInstructionRandomValues(std::vector<int>& replayValues);
+		std::vector<int> _endInstructionRandomValues();
+		int _instructionRand();
+		double _instructionRandomDouble(double min, double max);
+		void _initializeInstructionFootprint(InstructionRecord& record);
+		bool _isInstructionInRegion(InstructionRecord& record,
+			std::vector<Extents2d>& region);
+		void _replayInstructions();
+		void _replayInstructionRegion(InstructionRecord& oldRecord,
+			InstructionRecord& newRecord,
+			std::vector<int>& changedVertices);
+		void _markClimateStale(std::vector<int>& indices);
+		void _performInstructionRange(int startIndex, std::vector<int>& replayValues);
+		bool _isInstructionEqual(MapInstruction& instruction1, MapInstruction& instruction2);
+		bool _isCheckpointEnabled();
+		void _addCheckpoint(int instructionIndex);
+		void _readCheckpoint(HeightCheckpoint& checkpoint, LayerValue* heights);
+		int _findCheckpoint(int instructionIndex);
+		void _discardCheckpoints(int instructionIndex);
+		void _updateHeightProgram();
+		void _executeHeightProgram();
+
+		void _calculatePrecipitationMap(LayerView<LayerValue> precipitationMap);
+		void _calculateTemperatureMap(LayerView<LayerValue> temperatureMap);
+		void _calculateBiomeMap(LayerView<LayerValue> temperatureMap,
+			LayerView<LayerValue> precipitationMap,
+			LayerView<BiomeType> biomeMap);
+		BiomeType _getLifeZone(double temp, double precip);
 		void _getBiomeDrawData(std::vector<jsoncons::json>& faceVertices);
-		jsoncons::json _getBiomeJSON(double i, std::vector<double>& vertices);
-		std::string _toBiomeString(double v);
+		jsoncons::json _getBiomeJSON(BiomeType type, std::vector<double>& vertices);
+		std::string _toBiomeString(BiomeType v);
 		double _calculateHeightTemperature(int i, double max);
-		void _calculateLatitudeTemperatures(NodeMap<double>& temperatureMap);
+		void _calculateLatitudeTemperatures(LayerView<LayerValue> temperatureMap);
 		double _calculateLatitudeTemperature(int i);
+		bool _calculateFaceTemperature(int fidx, double* value);
+		bool _calculateFaceTemperature(int fidx, double noise, double* value);
 		double _calculateHeightPrecipitation(int i);
-		double _calculateVertexNoise(int i, FastNoise& noiseMap);
+		double _calculateVertexPrecipitation(int i);
+		double _calculateVertexPrecipitation(int i, double noise);
+		NoiseField _createNoiseField(FastNoise& noise);
+		double _calculateVertexNoise(int i, NoiseField& noiseMap);
+		double _normalizeNoise(double noise);
+		void _fillVertexNoise(NoiseField& noiseMap, std::vector<int>& vertices,
+			std::vector<double>& noise);
 
 		void _getContourDrawData(std::vector<std::vector<double> >& data);
 		void _getContourPaths(std::vector<VertexList>& paths);
@@ -229,7 +335,7 @@ namespace gen {
 		void _getConnectedFaces(int seed, std::vector<bool>& isLandFace,
 			std::vector<bool>& isFaceProcessed,
 			std::vector<int>& faces);
-		bool _isContourEdge(dcel::HalfEdge& h);
+		bool _isContourEdge(int eidx);
 		bool _isContourEdge(dcel::Vertex& v1, dcel::Vertex& v2);
 		void _getContourPath(int seed, std::vector<bool>& isContourVertex,
 			std::vector<bool>& isEndVertex,
@@ -248,16 +354,16 @@ namespace gen {
 
 		void _getSlopeDrawData(std::vector<double>& data);
 		void _getSlopeSegments(std::vector<Segment>& segments);
-		void _calculateHorizontalSlopeMap(NodeMap<double>& slopeMap);
+		void _calculateHorizontalSlopeMap(NodeMap<LayerValue>& slopeMap);
 		double _calculateHorizontalSlope(int i);
-		void _calculateVerticalSlopeMap(NodeMap<double>& slopeMap);
+		void _calculateVerticalSlopeMap(NodeMap<LayerValue>& slopeMap);
 		double _calculateVerticalSlope(int i);
 		void _calculateVertexNormal(int vidx, double* nx, double* ny, double* nz);
 
 		void _getCityDrawData(std::vector<double>& data);
 		void _getTownDrawData(std::vector<double>& data);
 		CityLocation _getCityLocation();
-		void _getCityScores(NodeMap<double>& cityScores);
+		void _getCityScores(NodeMap<LayerValue>& cityScores);
 		double _getPointDistance(dcel::Point& p1, dcel::Point& p2);
 		double _pointToEdgeDistance(dcel::Point p);
 		void _updateCityMovementCost(City& city);
@@ -283,8 +389,8 @@ namespace gen {
 		void _getBorderPaths(std::vector<int>& faceTerritories,
 			std::vector<VertexList>& borders);
 		void _getBorderEdges(std::vector<int>& faceTerritories,
-			std::vector<dcel::HalfEdge>& borderEdges);
-		bool _isBorderEdge(dcel::HalfEdge& h, std::vector<int>& faceTerritories);
+			std::vector<int>& borderEdges);
+		bool _isBorderEdge(int eidx, std::vector<int>& faceTerritories);
 		bool _isBorderEdge(dcel::Vertex& v1, dcel::Vertex& v2,
 			std::vector<int>& faceTerritories);
 		void _getBorderPath(int vidx, std::vector<int>& faceTerritories,
@@ -361,23 +467,40 @@ namespace gen {
 		double _defaultExtentsWidth = 20.0 * 1.7777;
 		double _defaultExtentsHeight = 20.0;
 
-		dcel::DCEL _voronoi;
-		VertexMap _vertexMap;
-		NodeMap<std::vector<int> > _neighbourMap;
-		std::vector<std::vector<int> > _faceNeighbours;
-		std::vector<std::vector<int> > _faceVertices;
-		std::vector<std::vector<int> > _faceEdges;
-		NodeMap<double> _heightMap;
-		NodeMap<double> _fluxMap;
+		dcel::FlatDCEL _mesh;    // Voronoi diagram, may be a mapped mesh file
+		std::shared_ptr<VertexMap> _vertexMap;    // shared by all NodeMaps, read only
+		AdjacencyList _neighbourMap;      // vertex map index -> neighbour map indices
+		AdjacencyList _faceNeighbours;    // face -> neighbouring faces
+		AdjacencyList _faceVertices;      // face -> vertex ids in edge order
+		AdjacencyList _faceEdges;         // face -> outer component edges
+		VertexGrid _vertexGrid;           // vertex map positions for radius queries
+		NodeMap<LayerValue> _heightMap;
+		NodeMap<LayerValue> _fluxMap;
 		NodeMap<int> _flowMap;
+		std::vector<int> _flowOrder;      // vertex map indices, each after the vertex it flows to
 		bool _isInitialized = false;
 		std::vector<MapInstruction> _instructions;
-
-		NodeMap<double> _temperatureMap;
-		NodeMap<double> _precipitationMap;
-		NodeMap<double> _biomeMap;
-		FastNoise _precipitationNoiseMap;
-		FastNoise _temperatureNoiseMap;
+		std::vector<InstructionRecord> _instructionRecords;    // same indices as _instructions
+		std::vector<LayerValue> _initialHeights;       // heights before the first instruction
+		std::vector<LayerValue> _replayBaseHeights;    // heights after the last barrier instruction
+		int _replayBaseIndex = 0;                      // first instruction after the last barrier
+		bool _isRecordingRandomValues = false;
+		std::vector<int> _instructionRandomValues;
+		unsigned int _instructionRandomIndex = 0;
+		std::mt19937 _instructionRandom;                  // random values drawn by instructions
+		std::vector<int> _unusedInstructionRandomValues;  // drawn by the previous program but not used
+		bool _isHeightMapErodedBeforeInstructions = false;
+		std::vector<HeightCheckpoint> _checkpoints;    // ordered by instruction index
+		int _checkpointInstructionInterval = 0;        // <= 0 disables
+		double _checkpointTimeInterval = 0.0;          // seconds of work, <= 0 disables
+		std::string _checkpointFilename;               // empty stores checkpoints in memory
+		uint64_t _checkpointFileSize = 0;
+		HeightProgram _heightProgram;
+		bool _isHeightProgramRecording = false;
+
+		LayerStack _climateLayers;    // temperature, precipitation and biome channels
+		NoiseField _precipitationNoiseMap;
+		NoiseField _temperatureNoiseMap;
 		double _mapScale = .25;
 		double _mapOffset = 0.2;
 		double _equatorPosition = 0.5;
@@ -388,12 +511,26 @@ namespace gen {
 		double _warmerZone = 0.8;
 		bool _isTemperatureCalculated = false;
 		bool _isPrecipitationCalculated = false;
+		std::vector<int> _staleClimateVertices;    // climate entries to recompute in updateBiomes()
+		std::vector<bool> _isClimateVertexStale;
+		std::vector<bool> _climateLandFaceTable;   // land faces when the climate was calculated
 
 		std::vector<bool> _isLandFaceTable;
 		bool _isLandFaceTableInitialized = false;
 
 		double _samplePadFactor = 3.5;
 		int _poissonSamplerKValue = 25;
+		SamplerType _samplerType = SamplerType::bridson;
+		TriangulatorType _triangulatorType = TriangulatorType::sweephull;
+		dcel::MeshLayout _meshLayout = dcel::MeshLayout::full;
+		int _numThreads = 0;    // <= 0 uses all hardware threads
+		int _verticesPerGridCell = 256;
+		int _minParallelDrainageVertexCount = 65536;
+		int _drainageTilesPerThread = 4;
+		std::string _meshCacheDirectory;    // empty disables the mesh cache
+		uint64_t _meshCacheSize = 0;
+		NoiseFieldSampling _noiseFieldSampling = NoiseFieldSampling::exact;
+		std::string _noiseCacheDirectory;    // empty disables the noise field cache
 		double _fluxCapPercentile = 0.995;
 		double _maxErosionRate = 50.0;
 		double _erosionRiverFactor = 500.0;
@@ -0,0 +1,198 @@
+#include "meshcache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdio>
+
+#include "cacheutil.h"
+
+std::string MeshCache::getKeyName(const Key &key) {
+    uint64_t hash = CacheUtil::hashSeed;
+    hash = CacheUtil::hashBytes(&key.extents.minx, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.extents.miny, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.extents.maxx, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.extents.maxy, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.resolution, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.padFactor, sizeof(double), hash);
+    hash = CacheUtil::hashBytes(&key.kValue, sizeof(int), hash);
+    hash = CacheUtil::hashBytes(&key.seed, sizeof(unsigned int), hash);
+    hash = CacheUtil::hashBytes(&key.samplerType, sizeof(int), hash);
+    hash = CacheUtil::hashBytes(&key.triangulatorType, sizeof(int), hash);
+    hash = CacheUtil::hashBytes(&key.formatVersion, sizeof(uint32_t), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mesh", (unsigned long long)hash);
+    return std::string(name);
+}
+
+bool MeshCache::load(std::string directory, const Key &key, dcel::FlatDCEL &mesh) {
+    std::string name = getKeyName(key);
+    std::string path = CacheUtil::getPath(directory, name);
+    if (!MeshFile::isMeshFile(path)) {
+        return false;
+    }
+
+    // Held while the entry is validated, so that an invalid entry is not
+    // removed after another process has stored a new one in its place
+    CacheUtil::FileLock lock(CacheUtil::getPath(directory, _lockName));
+    if (!lock.isLocked()) {
+        return false;
+    }
+
+    std::vector<_Entry> entries = _readIndex(directory);
+    try {
+        std::shared_ptr<MeshFile::MappedMesh> mappedMesh =
+            std::make_shared<MeshFile::MappedMesh>(path);
+        Extents2d e = mappedMesh->extents();
+        bool isMatch = e.minx == key.extents.minx && e.miny == key.extents.miny &&
+                       e.maxx == key.extents.maxx && e.maxy == key.extents.maxy &&
+                       mappedMesh->resolution() == key.resolution;
+        if (!isMatch || !mappedMesh->isChecksumValid()) {
+            throw std::runtime_error("Invalid mesh cache entry: " + path);
+        }
+
+        mesh = MeshFile::getFlatDCEL(mappedMesh);
+        _updateEntry(entries, name, mappedMesh->header().fileSize);
+    } catch (std::exception &e) {
+        std::remove(path.c_str());
+        _removeEntry(entries, name);
+        _writeIndex(directory, entries);
+        return false;
+    }
+
+    _writeIndex(directory, entries);
+    return true;
+}
+
+bool MeshCache::store(std::string directory, const Key &key,
+                      const dcel::FlatDCEL &mesh, uint64_t maxBytes) {
+    if (!CacheUtil::createDirectory(directory)) {
+        return false;
+    }
+
+    std::string name = getKeyName(key);
+    std::string path = CacheUtil::getPath(directory, name);
+    std::string tempPath = CacheUtil::getTempPath(path);
+    try {
+        MeshFile::write(tempPath, mesh, key.extents, key.resolution);
+    } catch (std::exception &e) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    CacheUtil::FileLock lock(CacheUtil::getPath(directory, _lockName));
+    if (!lock.isLocked()) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    uint64_t size = (uint64_t)file.tellg();
+    file.close();
+
+    std::vector<_Entry> entries = _readIndex(directory);
+    _updateEntry(entries, name, size);
+    _evictEntries(directory, entries, maxBytes, name);
+
+    return _writeIndex(directory, entries);
+}
+
+/*
+    The index is a text file with one "<name> <size> <lastUse>" line per
+    entry, where lastUse increases each time an entry is loaded or stored.
+*/
+std::vector<MeshCache::_Entry> MeshCache::_readIndex(std::string directory) {
+    std::vector<_Entry> entries;
+    std::ifstream file(CacheUtil::getPath(directory, "index"));
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream istr(line);
+        _Entry e;
+        if (istr >> e.name >> e.size >> e.lastUse) {
+            entries.push_back(e);
+        }
+    }
+
+    return entries;
+}
+
+bool MeshCache::_writeIndex(std::string directory, std::vector<_Entry> &entries) {
+    std::string path = CacheUtil::getPath(directory, "index");
+    std::string tempPath = CacheUtil::getTempPath(path);
+    {
+        std::ofstream file(tempPath);
+        for (unsigned int i = 0; i < entries.size(); i++) {
+            file << entries[i].name << " " << entries[i].size << " " <<
+                    entries[i].lastUse << "\n";
+        }
+
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::_updateEntry(std::vector<_Entry> &entries, std::string name, uint64_t size) {
+    uint64_t lastUse = 0;
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        lastUse = std::max(lastUse, entries[i].lastUse);
+    }
+
+    _removeEntry(entries, name);
+    _Entry e;
+    e.name = name;
+    e.size = size;
+    e.lastUse = lastUse + 1;
+    entries.push_back(e);
+}
+
+void MeshCache::_removeEntry(std::vector<_Entry> &entries, std::string name) {
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].name == name) {
+            entries.erase(entries.begin() + i);
+            return;
+        }
+    }
+}
+
+void MeshCache::_evictEntries(std::string directory, std::vector<_Entry> &entries,
+                              uint64_t maxBytes, std::string keepName) {
+    std::sort(entries.begin(), entries.end(),
+              [](const _Entry &a, const _Entry &b) {
+                  return a.lastUse > b.lastUse;
+              });
+
+    uint64_t totalSize = 0;
+    bool isFull = false;
+    std::vector<_Entry> keptEntries;
+    for (unsigned int i = 0; i < entries.size(); i++) {
+        if (entries[i].name != keepName && totalSize + entries[i].size > maxBytes) {
+            isFull = true;
+        }
+
+        if (entries[i].name == keepName || !isFull) {
+            totalSize += entries[i].size;
+            keptEntries.push_back(entries[i]);
+        } else {
+            std::remove(CacheUtil::getPath(directory, entries[i].name).c_str());
+        }
+    }
+
+    entries = keptEntries;
+}
@@ -0,0 +1,77 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "dcel.h"
+#include "flatdcel.h"
+#include "extents2d.h"
+#include "meshfile.h"
+
+/*
+    On-disk cache of generated Voronoi meshes
+
+    Meshes are stored in the MeshFile format under a name derived from a
+    hash of every parameter that determines the mesh (Key). A text index in
+    the cache directory records the size and last use of each entry, and
+    the least recently used entries are removed when the cache grows past
+    its size limit.
+
+    Several processes can share a cache directory. Files are written under
+    temporary names unique to each process and renamed into place, and
+    entries are validated, renamed into place and the index is updated
+    while holding an advisory lock on the lock file in the directory.
+
+    The cache is best effort. A missing, unreadable or corrupt entry is
+    treated as a miss, and failures to store are reported to the caller
+    without throwing.
+*/
+namespace MeshCache {
+
+struct Key {
+    Extents2d extents;
+    double resolution = 0.0;
+    double padFactor = 0.0;
+    int kValue = 0;
+    unsigned int seed = 0;
+    int samplerType = 0;
+    int triangulatorType = 0;
+    uint32_t formatVersion = MeshFile::_version;
+};
+
+const char _lockName[] = "index.lock";
+
+struct _Entry {
+    std::string name;
+    uint64_t size;
+    uint64_t lastUse;
+};
+
+// Name of the cache entry for key
+std::string getKeyName(const Key &key);
+
+// Load the mesh for key into mesh, which reads the mapped cache entry in
+// place. Returns false on a cache miss.
+bool load(std::string directory, const Key &key, dcel::FlatDCEL &mesh);
+
+// Store mesh under key and evict entries until the cache is at most
+// maxBytes. Returns false if the mesh could not be stored.
+bool store(std::string directory, const Key &key,
+           const dcel::FlatDCEL &mesh, uint64_t maxBytes);
+
+std::vector<_Entry> _readIndex(std::string directory);
+bool _writeIndex(std::string directory, std::vector<_Entry> &entries);
+void _updateEntry(std::vector<_Entry> &entries, std::string name, uint64_t size);
+void _removeEntry(std::vector<_Entry> &entries, std::string name);
+void _evictEntries(std::string directory, std::vector<_Entry> &entries,
+                   uint64_t maxBytes, std::string keepName);
+
+}
+
+#endif
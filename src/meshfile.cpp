@@ -0,0 +1,289 @@
+#include "meshfile.h"
+
+#include <string.h>
+#include <limits>
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__MACOSX)
+    #define MESHFILE_MMAP_SUPPORTED
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+MeshFile::MappedMesh::MappedMesh(std::string filename) {
+    _openFile(filename);
+    try {
+        _validateHeader(filename);
+    } catch (...) {
+        _closeFile();
+        throw;
+    }
+
+    const uint64_t *offsets = _header->arrayOffsets;
+    vertexX = (const double*)(_data + offsets[vertexXArray]);
+    vertexY = (const double*)(_data + offsets[vertexYArray]);
+    vertexEdge = (const int32_t*)(_data + offsets[vertexEdgeArray]);
+    edgeOrigin = (const int32_t*)(_data + offsets[edgeOriginArray]);
+    edgeTwin = (const int32_t*)(_data + offsets[edgeTwinArray]);
+    edgeNext = (const int32_t*)(_data + offsets[edgeNextArray]);
+    edgePrev = (const int32_t*)(_data + offsets[edgePrevArray]);
+    edgeFace = (const int32_t*)(_data + offsets[edgeFaceArray]);
+    faceEdge = (const int32_t*)(_data + offsets[faceEdgeArray]);
+}
+
+MeshFile::MappedMesh::~MappedMesh() {
+    _closeFile();
+}
+
+bool MeshFile::MappedMesh::isChecksumValid() const {
+    uint64_t payloadSize = _header->fileSize - _header->headerSize;
+    uint64_t checksum = _computeChecksum(_data + _header->headerSize,
+                                         payloadSize, payloadSize, _checksumSeed);
+    return checksum == _header->checksum;
+}
+
+void MeshFile::MappedMesh::_openFile(std::string filename) {
+#ifdef MESHFILE_MMAP_SUPPORTED
+    _fd = open(filename.c_str(), O_RDONLY);
+    if (_fd == -1) {
+        throw std::runtime_error("Unable to open mesh file: " + filename);
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) == -1 || st.st_size == 0) {
+        close(_fd);
+        _fd = -1;
+        throw std::runtime_error("Invalid mesh file: " + filename);
+    }
+    _size = (uint64_t)st.st_size;
+
+    void *addr = mmap(NULL, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (addr == MAP_FAILED) {
+        close(_fd);
+        _fd = -1;
+        throw std::runtime_error("Unable to map mesh file: " + filename);
+    }
+    _data = (const char*)addr;
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open mesh file: " + filename);
+    }
+
+    _size = (uint64_t)file.tellg();
+    file.seekg(0);
+    _buffer.resize((_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    file.read((char*)_buffer.data(), _size);
+    if (!file) {
+        throw std::runtime_error("Unable to read mesh file: " + filename);
+    }
+    _data = (const char*)_buffer.data();
+#endif
+    _header = (const Header*)_data;
+}
+
+void MeshFile::MappedMesh::_closeFile() {
+#ifdef MESHFILE_MMAP_SUPPORTED
+    if (_data != nullptr) {
+        munmap((void*)_data, _size);
+    }
+    if (_fd != -1) {
+        close(_fd);
+    }
+#endif
+    _data = nullptr;
+    _header = nullptr;
+    _fd = -1;
+    _size = 0;
+    _buffer.clear();
+}
+
+void MeshFile::MappedMesh::_validateHeader(std::string filename) {
+    if (_size < sizeof(Header) || memcmp(_header->magic, _magic, 8) != 0) {
+        throw std::runtime_error("Invalid mesh file: " + filename);
+    }
+
+    if (_header->version != _version) {
+        throw std::runtime_error("Unsupported mesh file version " +
+                                 std::to_string(_header->version) + ": " + filename);
+    }
+
+    if (_header->byteOrder != _byteOrderMark) {
+        throw std::runtime_error("Mesh file byte order does not match: " + filename);
+    }
+
+    uint64_t maxCount = (uint64_t)std::numeric_limits<int>::max();
+    if (_header->fileSize != _size ||
+            _header->headerSize < sizeof(Header) ||
+            _header->headerSize > _size ||
+            _header->vertexCount > maxCount ||
+            _header->edgeCount > maxCount ||
+            _header->faceCount > maxCount) {
+        throw std::runtime_error("Invalid mesh file: " + filename);
+    }
+
+    for (int i = 0; i < numMeshArrays; i++) {
+        uint64_t offset = _header->arrayOffsets[i];
+        uint64_t size = _getArraySize((MeshArray)i, _header->vertexCount,
+                                                    _header->edgeCount,
+                                                    _header->faceCount);
+        if (offset % _alignment != 0 || offset < _header->headerSize ||
+                size > _size || offset > _size - size) {
+            throw std::runtime_error("Invalid mesh file: " + filename);
+        }
+    }
+}
+
+dcel::FlatDCEL MeshFile::getFlatDCEL(std::shared_ptr<const MappedMesh> mesh) {
+    dcel::FlatDCEL flat(mesh, mesh->vertexCount(), mesh->edgeCount(), mesh->faceCount());
+    flat.vertexX = mesh->vertexX;
+    flat.vertexY = mesh->vertexY;
+    flat.vertexEdge = mesh->vertexEdge;
+    flat.edgeOrigin = mesh->edgeOrigin;
+    flat.edgeTwin = mesh->edgeTwin;
+    flat.edgeNext = mesh->edgeNext;
+    flat.edgePrev = mesh->edgePrev;
+    flat.edgeFace = mesh->edgeFace;
+    flat.faceEdge = mesh->faceEdge;
+
+    return flat;
+}
+
+void MeshFile::write(std::string filename, const dcel::FlatDCEL &mesh,
+                     Extents2d extents, double resolution) {
+    if (mesh.getLayout() == dcel::MeshLayout::compact) {
+        write(filename, mesh.toFullLayout(), extents, resolution);
+        return;
+    }
+
+    Header header;
+    _initializeHeader(header, mesh, extents, resolution);
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open mesh file: " + filename);
+    }
+
+    std::vector<char> padding(_alignment, 0);
+    file.write((char*)&header, sizeof(Header));
+    file.write(padding.data(), header.headerSize - sizeof(Header));
+
+    uint64_t nv = header.vertexCount;
+    uint64_t ne = header.edgeCount;
+    uint64_t nf = header.faceCount;
+    for (int i = 0; i < numMeshArrays; i++) {
+        uint64_t size = _getArraySize((MeshArray)i, nv, ne, nf);
+        file.write(_getArrayData(mesh, (MeshArray)i), size);
+        file.write(padding.data(), _alignOffset(size) - size);
+    }
+
+    if (!file) {
+        throw std::runtime_error("Unable to write mesh file: " + filename);
+    }
+}
+
+bool MeshFile::isMeshFile(std::string filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[8];
+    file.read(magic, 8);
+    return file && memcmp(magic, _magic, 8) == 0;
+}
+
+uint64_t MeshFile::_getArraySize(MeshArray a, uint64_t nv, uint64_t ne, uint64_t nf) {
+    switch (a) {
+        case vertexXArray:
+        case vertexYArray:
+            return nv * sizeof(double);
+        case vertexEdgeArray:
+            return nv * sizeof(int32_t);
+        case faceEdgeArray:
+            return nf * sizeof(int32_t);
+        default:
+            return ne * sizeof(int32_t);
+    }
+}
+
+uint64_t MeshFile::_alignOffset(uint64_t offset) {
+    return (offset + _alignment - 1) / _alignment * _alignment;
+}
+
+/*
+    64-bit FNV-1a applied to 8 byte words. Bytes in [size, paddedSize)
+    are hashed as zeros, so hashing an array followed by its padding gives
+    the same result as hashing the padded array as it is stored in the file.
+*/
+uint64_t MeshFile::_computeChecksum(const char *data, uint64_t size,
+                                    uint64_t paddedSize, uint64_t hash) {
+    const uint64_t prime = 1099511628211ULL;
+
+    uint64_t numWords = size / sizeof(uint64_t);
+    for (uint64_t i = 0; i < numWords; i++) {
+        uint64_t word;
+        memcpy(&word, data + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+
+    uint64_t tailSize = size - numWords * sizeof(uint64_t);
+    uint64_t end = numWords * sizeof(uint64_t);
+    if (tailSize > 0) {
+        uint64_t word = 0;
+        memcpy(&word, data + end, tailSize);
+        hash = (hash ^ word) * prime;
+        end += sizeof(uint64_t);
+    }
+
+    for (; end < paddedSize; end += sizeof(uint64_t)) {
+        hash = hash * prime;
+    }
+
+    return hash;
+}
+
+void MeshFile::_initializeHeader(Header &header, const dcel::FlatDCEL &mesh,
+                                 Extents2d extents, double resolution) {
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, _magic, 8);
+    header.version = _version;
+    header.byteOrder = _byteOrderMark;
+    header.headerSize = _alignOffset(sizeof(Header));
+    header.vertexCount = mesh.vertexCount();
+    header.edgeCount = mesh.edgeCount();
+    header.faceCount = mesh.faceCount();
+    header.minx = extents.minx;
+    header.miny = extents.miny;
+    header.maxx = extents.maxx;
+    header.maxy = extents.maxy;
+    header.resolution = resolution;
+
+    uint64_t offset = header.headerSize;
+    uint64_t checksum = _checksumSeed;
+    for (int i = 0; i < numMeshArrays; i++) {
+        uint64_t size = _getArraySize((MeshArray)i, header.vertexCount,
+                                                    header.edgeCount,
+                                                    header.faceCount);
+        uint64_t paddedSize = _alignOffset(size);
+        header.arrayOffsets[i] = offset;
+        checksum = _computeChecksum(_getArrayData(mesh, (MeshArray)i),
+                                    size, paddedSize, checksum);
+        offset += paddedSize;
+    }
+
+    header.fileSize = offset;
+    header.checksum = checksum;
+}
+
+const char* MeshFile::_getArrayData(const dcel::FlatDCEL &mesh, MeshArray a) {
+    switch (a) {
+        case vertexXArray:    return (const char*)mesh.vertexX;
+        case vertexYArray:    return (const char*)mesh.vertexY;
+        case vertexEdgeArray: return (const char*)mesh.vertexEdge;
+        case edgeOriginArray: return (const char*)mesh.edgeOrigin;
+        case edgeTwinArray:   return (const char*)mesh.edgeTwin;
+        case edgeNextArray:   return (const char*)mesh.edgeNext;
+        case edgePrevArray:   return (const char*)mesh.edgePrev;
+        case edgeFaceArray:   return (const char*)mesh.edgeFace;
+        case faceEdgeArray:   return (const char*)mesh.faceEdge;
+        default:              return nullptr;
+    }
+}
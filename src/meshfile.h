@@ -0,0 +1,230 @@
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <stdint.h>
+#include <memory>
+
+#include "dcel.h"
+#include "flatdcel.h"
+#include "extents2d.h"
+
+/*
+    Flat binary mesh file format
+
+    The file is a fixed size header followed by the FlatDCEL arrays, each
+    stored as a raw little-endian array that starts on a 64 byte boundary:
+
+        vertexX, vertexY                                  (double)
+        vertexEdge                                        (int32)
+        edgeOrigin, edgeTwin, edgeNext, edgePrev, edgeFace (int32)
+        faceEdge                                          (int32)
+
+    The header holds the component counts, map extents, sample resolution,
+    the byte offset of each array and a checksum of everything after the
+    header. Because the arrays are stored exactly as they are used, a file
+    can be memory mapped read-only and traversed in place, and processes
+    mapping the same file share its pages.
+
+    Face inner components are not stored.
+*/
+namespace MeshFile {
+
+const char _magic[8] = {'M', 'A', 'P', 'M', 'E', 'S', 'H', '\0'};
+const uint32_t _version = 1;
+const uint32_t _byteOrderMark = 0x01020304;
+const uint64_t _alignment = 64;
+const uint64_t _checksumSeed = 14695981039346656037ULL;
+
+enum MeshArray {
+    vertexXArray = 0,
+    vertexYArray,
+    vertexEdgeArray,
+    edgeOriginArray,
+    edgeTwinArray,
+    edgeNextArray,
+    edgePrevArray,
+    edgeFaceArray,
+    faceEdgeArray,
+    numMeshArrays
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t headerSize;
+    uint64_t fileSize;
+
+    uint64_t vertexCount;
+    uint64_t edgeCount;
+    uint64_t faceCount;
+
+    double minx;
+    double miny;
+    double maxx;
+    double maxy;
+    double resolution;
+
+    uint64_t arrayOffsets[numMeshArrays];
+    uint64_t checksum;
+};
+
+/*
+    Read-only view of a mesh file. On POSIX systems the file is memory
+    mapped and the arrays are used directly from the page cache. Elsewhere
+    the file is read into a single buffer.
+
+    Accessors match FlatDCEL and are only bounds checked in builds without
+    NDEBUG.
+*/
+class MappedMesh {
+public:
+    MappedMesh(std::string filename);
+    ~MappedMesh();
+
+    inline const Header& header() const {
+        return *_header;
+    }
+
+    inline int vertexCount() const {
+        return (int)_header->vertexCount;
+    }
+
+    inline int edgeCount() const {
+        return (int)_header->edgeCount;
+    }
+
+    inline int faceCount() const {
+        return (int)_header->faceCount;
+    }
+
+    inline Extents2d extents() const {
+        return Extents2d(_header->minx, _header->miny,
+                         _header->maxx, _header->maxy);
+    }
+
+    inline double resolution() const {
+        return _header->resolution;
+    }
+
+    inline int origin(int h) const {
+        _checkHalfEdge(h);
+        return edgeOrigin[h];
+    }
+
+    inline int twin(int h) const {
+        _checkHalfEdge(h);
+        return edgeTwin[h];
+    }
+
+    inline int next(int h) const {
+        _checkHalfEdge(h);
+        return edgeNext[h];
+    }
+
+    inline int prev(int h) const {
+        _checkHalfEdge(h);
+        return edgePrev[h];
+    }
+
+    inline int incidentFace(int h) const {
+        _checkHalfEdge(h);
+        return edgeFace[h];
+    }
+
+    inline int incidentEdge(int v) const {
+        _checkVertex(v);
+        return vertexEdge[v];
+    }
+
+    inline int outerComponent(int f) const {
+        _checkFace(f);
+        return faceEdge[f];
+    }
+
+    inline dcel::Point position(int v) const {
+        _checkVertex(v);
+        return dcel::Point(vertexX[v], vertexY[v]);
+    }
+
+    bool isChecksumValid() const;
+
+    const double *vertexX = nullptr;
+    const double *vertexY = nullptr;
+    const int32_t *vertexEdge = nullptr;
+
+    const int32_t *edgeOrigin = nullptr;
+    const int32_t *edgeTwin = nullptr;
+    const int32_t *edgeNext = nullptr;
+    const int32_t *edgePrev = nullptr;
+    const int32_t *edgeFace = nullptr;
+
+    const int32_t *faceEdge = nullptr;
+
+private:
+    MappedMesh(const MappedMesh &);
+    MappedMesh& operator=(const MappedMesh &);
+
+    void _openFile(std::string filename);
+    void _closeFile();
+    void _validateHeader(std::string filename);
+
+    inline void _checkVertex(int v) const {
+#ifndef NDEBUG
+        if (v < 0 || v >= vertexCount()) {
+            throw std::range_error("Vertex out of range: " + std::to_string(v));
+        }
+#endif
+    }
+
+    inline void _checkHalfEdge(int h) const {
+#ifndef NDEBUG
+        if (h < 0 || h >= edgeCount()) {
+            throw std::range_error("HalfEdge out of range: " + std::to_string(h));
+        }
+#endif
+    }
+
+    inline void _checkFace(int f) const {
+#ifndef NDEBUG
+        if (f < 0 || f >= faceCount()) {
+            throw std::range_error("Face out of range: " + std::to_string(f));
+        }
+#endif
+    }
+
+    const char *_data = nullptr;
+    uint64_t _size = 0;
+    const Header *_header = nullptr;
+    int _fd = -1;
+    std::vector<uint64_t> _buffer;
+};
+
+// FlatDCEL that reads the arrays of mesh in place and keeps it mapped
+dcel::FlatDCEL getFlatDCEL(std::shared_ptr<const MappedMesh> mesh);
+
+// Write mesh to filename in the flat mesh file format. A compact mesh is
+// written in the full layout with the same indices.
+void write(std::string filename, const dcel::FlatDCEL &mesh,
+           Extents2d extents, double resolution);
+
+// True if filename starts with a mesh file header
+bool isMeshFile(std::string filename);
+
+uint64_t _getArraySize(MeshArray a, uint64_t nv, uint64_t ne, uint64_t nf);
+uint64_t _alignOffset(uint64_t offset);
+uint64_t _computeChecksum(const char *data, uint64_t size,
+                          uint64_t paddedSize, uint64_t hash);
+void _initializeHeader(Header &header, const dcel::FlatDCEL &mesh,
+                       Extents2d extents, double resolution);
+const char* _getArrayData(const dcel::FlatDCEL &mesh, MeshArray a);
+
+}
+
+#endif
@@ -1,13 +1,39 @@
 #ifndef NODEMAP_H
 #define NODEMAP_H
 
+#include <stdint.h>
+#include <limits>
+#include <type_traits>
+
 #include "vertexmap.h"
 #include "dcel.h"
+#include "adjacencylist.h"
+#include "nodemapkernels.h"
 #include "cereal/cereal.hpp"
 #include "cereal/types/vector.hpp"
 
 namespace gen {
 
+/*
+    Storage type of the floating point map layers. Layers are stored in
+    single precision when the project is built with
+    MAP_GENERATION_SINGLE_PRECISION defined, which halves their memory and
+    bandwidth. Bulk operations accumulate in double in either mode.
+*/
+#ifdef MAP_GENERATION_SINGLE_PRECISION
+typedef float LayerValue;
+#else
+typedef double LayerValue;
+#endif
+
+// Element type of the node values in a serialized NodeMap
+enum class NodeElementType : uint8_t {
+    float64 = 0x00,
+    float32 = 0x01,
+    int32 = 0x02,
+    int8 = 0x03
+};
+
 template <class T>
 class NodeMap {
 
@@ -26,24 +52,21 @@ public:
         return _vertexMap->size();
     }
 
+    // Unchecked contiguous node values, indexed like the NodeMap
+    T* data() {
+        return _nodes.data();
+    }
+
+    const T* data() const {
+        return _nodes.data();
+    }
+
     T getMin() {
-        T minval = _nodes[0];
-        for (unsigned int i = 0; i < _nodes.size(); i++) {
-            if (_nodes[i] < minval) {
-                minval = _nodes[i];
-            }
-        }
-        return minval;
+        return NodeMapKernels::getMin(_nodes.data(), (int)_nodes.size());
     }
 
     T getMax() {
-        T maxval = _nodes[0];
-        for (unsigned int i = 0; i < _nodes.size(); i++) {
-            if (_nodes[i] > maxval) {
-                maxval = _nodes[i];
-            }
-        }
-        return maxval;
+        return NodeMapKernels::getMax(_nodes.data(), (int)_nodes.size());
     }
 
     int getNodeIndex(dcel::Vertex &v) {
@@ -51,14 +74,12 @@ public:
     }
 
     void fill(T fillval) {
-        for (unsigned int i = 0; i < _nodes.size(); i++) {
-            _nodes[i] = fillval;
-        }
+        std::fill(_nodes.begin(), _nodes.end(), fillval);
     }
 
     T operator()(int idx) {
         if (!_isInRange(idx)) {
-            throw std::range_error("Index out of range:" + idx);
+            throw std::range_error("Index out of range: " + std::to_string(idx));
         }
         return _nodes[idx];
     }
@@ -73,7 +94,7 @@ public:
 
     T* getPointer(int idx) {
         if (!_isInRange(idx)) {
-            throw std::range_error("Index out of range:" + idx);
+            throw std::range_error("Index out of range: " + std::to_string(idx));
         }
         return &_nodes[idx];
     }
@@ -88,7 +109,7 @@ public:
 
     void set(int idx, T val) {
         if (!_isInRange(idx)) {
-            throw std::range_error("Index out of range:" + idx);
+            throw std::range_error("Index out of range: " + std::to_string(idx));
         }
         _nodes[idx] = val;
     }
@@ -103,7 +124,7 @@ public:
 
     void getNeighbours(int idx, std::vector<T> &nbs) {
         if (!_isInRange(idx)) {
-            throw std::range_error("Index out of range:" + idx);
+            throw std::range_error("Index out of range: " + std::to_string(idx));
         }
         std::vector<int> indices;
         indices.reserve(3);
@@ -161,27 +182,16 @@ public:
 
     // Normalize height map values to range [0, 1]
     void normalize() {
-        double min = std::numeric_limits<double>::infinity();
-        double max = -std::numeric_limits<double>::infinity();
-        for (unsigned int i = 0; i < size(); i++) {
-            min = fmin(min, (*this)(i));
-            max = fmax(max, (*this)(i));
-        }
-
-        for (unsigned int i = 0; i < size(); i++) {
-            double val = (*this)(i);
-            double normalized = (val - min) / (max - min);
-            set(i, normalized);
-        }
+        T min, max;
+        NodeMapKernels::getMinMax(_nodes.data(), (int)_nodes.size(), &min, &max);
+        NodeMapKernels::normalize(_nodes.data(), (int)_nodes.size(), 
+                                  (double)min, (double)max);
     }
 
     // Normalize height map and square root the values
     void round() {
         normalize();
-        for (unsigned int i = 0; i < size(); i++) {
-            double rounded = sqrt((*this)(i));
-            set(i, rounded);
-        }
+        NodeMapKernels::squareRoot(_nodes.data(), (int)_nodes.size());
     }
 
     //  Replace height with average of its neighbours
@@ -189,7 +199,7 @@ public:
         std::vector<double> averages;
         averages.reserve(size());
 
-        std::vector<double> nbs;
+        std::vector<T> nbs;
         for (unsigned int i = 0; i < size(); i++) {
             nbs.clear();
             getNeighbours(i, nbs);
@@ -205,30 +215,40 @@ public:
         }
 
         for (unsigned int i = 0; i < size(); i++) {
-            set(i, averages[i]);
+            set(i, (T)averages[i]);
         }
     }
 
+    //  Replace height with average of its neighbours, where neighbours[i]
+    //  holds the node indices adjacent to node i
+    void relax(const AdjacencyList &neighbours) {
+        std::vector<T> averages(_nodes.size());
+        NodeMapKernels::gatherAverage(_nodes.data(), 
+                                      neighbours.offsets.data(),
+                                      neighbours.indices.data(),
+                                      (int)_nodes.size(), averages.data());
+        _nodes.swap(averages);
+    }
+
     // Translate height map so that level is at zero
     void setLevel(double level) {
-        for (unsigned int i = 0; i < size(); i++) {
-            double newval = (*this)(i) - level;
-            set(i, newval);
-        }
+        NodeMapKernels::subtract(_nodes.data(), (int)_nodes.size(), level);
     }
 
-    void setLevelToMedian() {
-        std::vector<double> values;
-        values.reserve(size());
-        for (unsigned int i = 0; i < size(); i++) {
-            values.push_back((*this)(i));
-        }
+    // this = this - a*other, where other uses the same vertex map
+    void subtractScaled(const NodeMap<T> &other, double a) {
+        NodeMapKernels::subtractScaled(_nodes.data(), other.data(), 
+                                       (int)_nodes.size(), a);
+    }
 
-        std::sort(values.begin(), values.end());
+    void setLevelToMedian() {
+        std::vector<double> values(_nodes.begin(), _nodes.end());
         int mididx = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + mididx, values.end());
         double median;
         if (values.size() % 2 == 0) {
-            median = 0.5 * (values[mididx - 1] + values[mididx]);
+            double lower = *std::max_element(values.begin(), values.begin() + mididx);
+            median = 0.5 * (lower + values[mididx]);
         } else {
             median = values[mididx];
         }
@@ -236,12 +256,89 @@ public:
         setLevel(median);
     }
 
+    size_t getMemoryUsage() const {
+        return _nodes.capacity() * sizeof(T);
+    }
+
+    /*
+        Serialized as a tag, the element type and the node values. Files
+        written before the element type was stored begin with the size of
+        a vector of doubles in place of the tag. Values stored with a
+        different element type are converted to T on load.
+    */
+    template <class Archive>
+    void save(Archive &archive) const {
+        uint64_t tag = _serializationTag;
+        NodeElementType type = _getElementType();
+        archive(tag, (uint8_t)type);
+        switch (type) {
+            case NodeElementType::float64: _saveValues<double>(archive); break;
+            case NodeElementType::float32: _saveValues<float>(archive); break;
+            case NodeElementType::int32:   _saveValues<int32_t>(archive); break;
+            case NodeElementType::int8:    _saveValues<int8_t>(archive); break;
+        }
+        archive(_vertexMap);
+    }
+
     template <class Archive>
-	inline void serialize(Archive & archive) {
-		archive(_nodes, _vertexMap);
-	}
+    void load(Archive &archive) {
+        uint64_t tag;
+        archive(tag);
+        if (tag != _serializationTag) {
+            std::vector<double> values((size_t)tag);
+            archive(cereal::binary_data(values.data(), values.size() * sizeof(double)));
+            _setValues(values);
+            archive(_vertexMap);
+            return;
+        }
+
+        uint8_t type;
+        archive(type);
+        switch ((NodeElementType)type) {
+            case NodeElementType::float64: _loadValues<double>(archive); break;
+            case NodeElementType::float32: _loadValues<float>(archive); break;
+            case NodeElementType::int32:   _loadValues<int32_t>(archive); break;
+            case NodeElementType::int8:    _loadValues<int8_t>(archive); break;
+            default:
+                throw std::runtime_error("Unknown NodeMap element type: " + 
+                                         std::to_string((int)type));
+        }
+        archive(_vertexMap);
+    }
     
 private:
+    static NodeElementType _getElementType() {
+        if (std::is_floating_point<T>::value) {
+            return sizeof(T) == sizeof(float) ? NodeElementType::float32 : 
+                                                NodeElementType::float64;
+        }
+        return sizeof(T) == 1 ? NodeElementType::int8 : NodeElementType::int32;
+    }
+
+    template <class S, class Archive>
+    void _saveValues(Archive &archive) const {
+        std::vector<S> values(_nodes.size());
+        for (unsigned int i = 0; i < _nodes.size(); i++) {
+            values[i] = static_cast<S>(_nodes[i]);
+        }
+        archive(values);
+    }
+
+    template <class S, class Archive>
+    void _loadValues(Archive &archive) {
+        std::vector<S> values;
+        archive(values);
+        _setValues(values);
+    }
+
+    template <class S>
+    void _setValues(std::vector<S> &values) {
+        _nodes.resize(values.size());
+        for (unsigned int i = 0; i < values.size(); i++) {
+            _nodes[i] = static_cast<T>(values[i]);
+        }
+    }
+
     void _initializeNodes() {
         _nodes = std::vector<T>(size(), T());
     }
@@ -250,6 +347,8 @@ private:
         return idx >= 0 && idx < (int)_nodes.size();
     }
 
+    static const uint64_t _serializationTag = std::numeric_limits<uint64_t>::max();
+
     std::shared_ptr<VertexMap> _vertexMap;
     std::vector<T> _nodes;
 };
@@ -0,0 +1,122 @@
+#include "nodemapkernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define NODEMAPKERNELS_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef NODEMAPKERNELS_SSE2
+
+/*
+    Reductions keep four independent accumulators (eight lanes) to hide the
+    latency of minpd/maxpd, then fold the lanes and the scalar tail.
+*/
+double NodeMapKernels::getMin(const double *x, int n) {
+    if (n < 8) {
+        return getMin<double>(x, n);
+    }
+
+    __m128d m0 = _mm_loadu_pd(x);
+    __m128d m1 = _mm_loadu_pd(x + 2);
+    __m128d m2 = _mm_loadu_pd(x + 4);
+    __m128d m3 = _mm_loadu_pd(x + 6);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        m0 = _mm_min_pd(m0, _mm_loadu_pd(x + i));
+        m1 = _mm_min_pd(m1, _mm_loadu_pd(x + i + 2));
+        m2 = _mm_min_pd(m2, _mm_loadu_pd(x + i + 4));
+        m3 = _mm_min_pd(m3, _mm_loadu_pd(x + i + 6));
+    }
+    m0 = _mm_min_pd(_mm_min_pd(m0, m1), _mm_min_pd(m2, m3));
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, m0);
+    double minval = std::min(lanes[0], lanes[1]);
+    for (; i < n; i++) {
+        minval = std::min(minval, x[i]);
+    }
+
+    return minval;
+}
+
+double NodeMapKernels::getMax(const double *x, int n) {
+    if (n < 8) {
+        return getMax<double>(x, n);
+    }
+
+    __m128d m0 = _mm_loadu_pd(x);
+    __m128d m1 = _mm_loadu_pd(x + 2);
+    __m128d m2 = _mm_loadu_pd(x + 4);
+    __m128d m3 = _mm_loadu_pd(x + 6);
+    int i = 8;
+    for (; i + 8 <= n; i += 8) {
+        m0 = _mm_max_pd(m0, _mm_loadu_pd(x + i));
+        m1 = _mm_max_pd(m1, _mm_loadu_pd(x + i + 2));
+        m2 = _mm_max_pd(m2, _mm_loadu_pd(x + i + 4));
+        m3 = _mm_max_pd(m3, _mm_loadu_pd(x + i + 6));
+    }
+    m0 = _mm_max_pd(_mm_max_pd(m0, m1), _mm_max_pd(m2, m3));
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, m0);
+    double maxval = std::max(lanes[0], lanes[1]);
+    for (; i < n; i++) {
+        maxval = std::max(maxval, x[i]);
+    }
+
+    return maxval;
+}
+
+void NodeMapKernels::getMinMax(const double *x, int n, double *minval, double *maxval) {
+    if (n < 8) {
+        *minval = getMin<double>(x, n);
+        *maxval = getMax<double>(x, n);
+        return;
+    }
+
+    __m128d min0 = _mm_loadu_pd(x);
+    __m128d min1 = _mm_loadu_pd(x + 2);
+    __m128d max0 = min0;
+    __m128d max1 = min1;
+    int i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m128d a = _mm_loadu_pd(x + i);
+        __m128d b = _mm_loadu_pd(x + i + 2);
+        min0 = _mm_min_pd(min0, a);
+        min1 = _mm_min_pd(min1, b);
+        max0 = _mm_max_pd(max0, a);
+        max1 = _mm_max_pd(max1, b);
+    }
+    min0 = _mm_min_pd(min0, min1);
+    max0 = _mm_max_pd(max0, max1);
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, min0);
+    double minv = std::min(lanes[0], lanes[1]);
+    _mm_storeu_pd(lanes, max0);
+    double maxv = std::max(lanes[0], lanes[1]);
+    for (; i < n; i++) {
+        minv = std::min(minv, x[i]);
+        maxv = std::max(maxv, x[i]);
+    }
+
+    *minval = minv;
+    *maxval = maxv;
+}
+
+#else
+
+double NodeMapKernels::getMin(const double *x, int n) {
+    return getMin<double>(x, n);
+}
+
+double NodeMapKernels::getMax(const double *x, int n) {
+    return getMax<double>(x, n);
+}
+
+void NodeMapKernels::getMinMax(const double *x, int n, double *minval, double *maxval) {
+    *minval = getMin<double>(x, n);
+    *maxval = getMax<double>(x, n);
+}
+
+#endif
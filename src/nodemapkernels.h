@@ -0,0 +1,122 @@
+#ifndef NODEMAPKERNELS_H
+#define NODEMAPKERNELS_H
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+/*
+    Bulk operations on contiguous node value arrays. The loops take raw
+    pointers and do no range checks so that the compiler can vectorize
+    them. The double overloads of the reductions use SSE2 when it is
+    available.
+
+    Every kernel applies the same floating point operations to each element
+    as the equivalent element-by-element loop, so results are bit-identical
+    to the unvectorized code. Arithmetic is carried out in double and only
+    the result is stored as T, so single precision layers lose precision in
+    storage but not in the intermediate values.
+*/
+namespace NodeMapKernels {
+
+// Reductions of an empty array return T()
+template <class T>
+T getMin(const T *x, int n) {
+    if (n <= 0) {
+        return T();
+    }
+
+    T minval = x[0];
+    for (int i = 1; i < n; i++) {
+        if (x[i] < minval) {
+            minval = x[i];
+        }
+    }
+    return minval;
+}
+
+template <class T>
+T getMax(const T *x, int n) {
+    if (n <= 0) {
+        return T();
+    }
+
+    T maxval = x[0];
+    for (int i = 1; i < n; i++) {
+        if (x[i] > maxval) {
+            maxval = x[i];
+        }
+    }
+    return maxval;
+}
+
+template <class T>
+void getMinMax(const T *x, int n, T *minval, T *maxval) {
+    *minval = getMin(x, n);
+    *maxval = getMax(x, n);
+}
+
+// x = (x - min) / (max - min)
+template <class T>
+void normalize(T *x, int n, double minval, double maxval) {
+    double range = maxval - minval;
+    for (int i = 0; i < n; i++) {
+        x[i] = (T)((x[i] - minval) / range);
+    }
+}
+
+// x = sqrt(x)
+template <class T>
+void squareRoot(T *x, int n) {
+    for (int i = 0; i < n; i++) {
+        x[i] = (T)sqrt((double)x[i]);
+    }
+}
+
+// x = x - value
+template <class T>
+void subtract(T *x, int n, double value) {
+    for (int i = 0; i < n; i++) {
+        x[i] = (T)(x[i] - value);
+    }
+}
+
+// x = x - a*y
+template <class T>
+void subtractScaled(T *x, const T *y, int n, double a) {
+    for (int i = 0; i < n; i++) {
+        x[i] = (T)(x[i] - a * y[i]);
+    }
+}
+
+/*
+    out[i] = average of x over the neighbours of node i, where the
+    neighbours of node i are indices[offsets[i]] to indices[offsets[i + 1] - 1].
+    Nodes without neighbours keep x[i].
+*/
+template <class T>
+void gatherAverage(const T *x, const int *offsets, const int *indices,
+                   int n, T *out) {
+    for (int i = 0; i < n; i++) {
+        int begin = offsets[i];
+        int end = offsets[i + 1];
+        if (begin == end) {
+            out[i] = x[i];
+            continue;
+        }
+
+        double sum = 0.0;
+        for (int j = begin; j < end; j++) {
+            sum += x[indices[j]];
+        }
+        out[i] = (T)(sum / (end - begin));
+    }
+}
+
+double getMin(const double *x, int n);
+double getMax(const double *x, int n);
+void getMinMax(const double *x, int n, double *minval, double *maxval);
+
+}
+
+#endif
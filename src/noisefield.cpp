@@ -0,0 +1,284 @@
+#include "noisefield.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "cacheutil.h"
+#include "parallel.h"
+
+gen::NoiseField::NoiseField(FastNoise noise) : _noise(noise) {
+}
+
+gen::NoiseField::NoiseField(FastNoise noise, Extents2d extents, double spacing,
+                            NoiseFieldSampling sampling) :
+                            _noise(noise), _sampling(sampling) {
+    if (_sampling != NoiseFieldSampling::exact) {
+        _initializeGrid(extents, spacing);
+    }
+}
+
+gen::NoiseFieldSampling gen::NoiseField::getSampling() const {
+    return _sampling;
+}
+
+bool gen::NoiseField::isBaked() const {
+    return _values != nullptr;
+}
+
+int gen::NoiseField::getWidth() const {
+    return _width;
+}
+
+int gen::NoiseField::getHeight() const {
+    return _height;
+}
+
+const gen::FastNoise& gen::NoiseField::getNoise() const {
+    return _noise;
+}
+
+void gen::NoiseField::bake(int numThreads) {
+    if (_sampling == NoiseFieldSampling::exact) {
+        return;
+    }
+
+    std::shared_ptr<std::vector<float> > values(new std::vector<float>((size_t)_width*_height));
+    std::vector<float> &grid = *values;
+    Parallel::forEachRange(0, _height, numThreads,
+        [this, &grid](int begin, int end, int) {
+            std::vector<double> xs(_width);
+            std::vector<double> ys(_width);
+            std::vector<double> noise(_width);
+            for (int i = 0; i < _width; i++) {
+                xs[i] = _originx + i*_spacing;
+            }
+            for (int j = begin; j < end; j++) {
+                std::fill(ys.begin(), ys.end(), _originy + j*_spacing);
+                _noise.FillNoise(xs.data(), ys.data(), noise.data(), _width);
+                float *row = grid.data() + (size_t)j*_width;
+                for (int i = 0; i < _width; i++) {
+                    row[i] = (float)noise[i];
+                }
+            }
+        }
+    );
+    _values = values;
+}
+
+/*
+    A cache entry is the magic "NFLD", the format version, the number of
+    key values, the key values as doubles and the grid as width*height
+    floats in row order.
+*/
+bool gen::NoiseField::loadCache(std::string directory) {
+    if (_sampling == NoiseFieldSampling::exact || !_isCacheable()) {
+        return false;
+    }
+
+    std::string path = CacheUtil::getPath(directory, getCacheName());
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t keyCount = 0;
+    file.read(magic, 4);
+    file.read((char*)&version, sizeof(uint32_t));
+    file.read((char*)&keyCount, sizeof(uint32_t));
+    std::vector<double> key = _getKey();
+    if (!file || memcmp(magic, "NFLD", 4) != 0 || version != _cacheVersion ||
+            keyCount != key.size()) {
+        return false;
+    }
+
+    std::vector<double> storedKey(keyCount);
+    file.read((char*)storedKey.data(), keyCount*sizeof(double));
+    if (!file || storedKey != key) {
+        return false;
+    }
+
+    std::shared_ptr<std::vector<float> > values(new std::vector<float>((size_t)_width*_height));
+    file.read((char*)values->data(), values->size()*sizeof(float));
+    if (!file) {
+        return false;
+    }
+
+    _values = values;
+    return true;
+}
+
+bool gen::NoiseField::storeCache(std::string directory) {
+    if (!isBaked() || !_isCacheable() || !CacheUtil::createDirectory(directory)) {
+        return false;
+    }
+
+    std::string path = CacheUtil::getPath(directory, getCacheName());
+    std::string tempPath = CacheUtil::getTempPath(path);
+    {
+        std::vector<double> key = _getKey();
+        uint32_t version = _cacheVersion;
+        uint32_t keyCount = (uint32_t)key.size();
+        std::ofstream file(tempPath, std::ios::binary);
+        file.write("NFLD", 4);
+        file.write((char*)&version, sizeof(uint32_t));
+        file.write((char*)&keyCount, sizeof(uint32_t));
+        file.write((char*)key.data(), key.size()*sizeof(double));
+        file.write((char*)_values->data(), _values->size()*sizeof(float));
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::remove(path.c_str());
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string gen::NoiseField::getCacheName() const {
+    std::vector<double> key = _getKey();
+    uint64_t hash = CacheUtil::hashBytes(key.data(), key.size()*sizeof(double),
+                                         CacheUtil::hashSeed);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.noise", (unsigned long long)hash);
+    return std::string(name);
+}
+
+double gen::NoiseField::getNoise(double x, double y) const {
+    if (!isBaked()) {
+        return _noise.GetNoise(x, y);
+    }
+
+    if (_sampling == NoiseFieldSampling::bicubic) {
+        return _sampleBicubic(x, y);
+    }
+    return _sampleBilinear(x, y);
+}
+
+void gen::NoiseField::fillNoise(const double *xs, const double *ys, double *out, int n) const {
+    if (!isBaked()) {
+        _noise.FillNoise(xs, ys, out, n);
+        return;
+    }
+
+    if (_sampling == NoiseFieldSampling::bicubic) {
+        for (int i = 0; i < n; i++) {
+            out[i] = _sampleBicubic(xs[i], ys[i]);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            out[i] = _sampleBilinear(xs[i], ys[i]);
+        }
+    }
+}
+
+void gen::NoiseField::_initializeGrid(Extents2d extents, double spacing) {
+    _spacing = spacing;
+    _invspacing = 1.0 / spacing;
+    _originx = extents.minx - _padding*spacing;
+    _originy = extents.miny - _padding*spacing;
+    _width = (int)ceil((extents.maxx - extents.minx) * _invspacing) + 1 + 2*_padding;
+    _height = (int)ceil((extents.maxy - extents.miny) * _invspacing) + 1 + 2*_padding;
+}
+
+/*
+    Cellular noise lookups depend on a second generator that is not part
+    of the key
+*/
+bool gen::NoiseField::_isCacheable() const {
+    return !(_noise.GetNoiseType() == FastNoise::Cellular &&
+             _noise.GetCellularReturnType() == FastNoise::NoiseLookup);
+}
+
+std::vector<double> gen::NoiseField::_getKey() const {
+    int index0, index1;
+    _noise.GetCellularDistance2Indices(index0, index1);
+
+    std::vector<double> key;
+    key.push_back((double)_noise.GetNoiseType());
+    key.push_back((double)_noise.GetSeed());
+    key.push_back(_noise.GetFrequency());
+    key.push_back((double)_noise.GetFractalOctaves());
+    key.push_back(_noise.GetFractalLacunarity());
+    key.push_back(_noise.GetFractalGain());
+    key.push_back((double)_noise.GetFractalType());
+    key.push_back((double)_noise.GetInterp());
+    key.push_back((double)_noise.GetCellularDistanceFunction());
+    key.push_back((double)_noise.GetCellularReturnType());
+    key.push_back((double)index0);
+    key.push_back((double)index1);
+    key.push_back(_noise.GetCellularJitter());
+    key.push_back(_originx);
+    key.push_back(_originy);
+    key.push_back(_spacing);
+    key.push_back((double)_width);
+    key.push_back((double)_height);
+    return key;
+}
+
+double gen::NoiseField::_sampleBilinear(double x, double y) const {
+    double gx = std::min(std::max((x - _originx) * _invspacing, 0.0), (double)(_width - 1));
+    double gy = std::min(std::max((y - _originy) * _invspacing, 0.0), (double)(_height - 1));
+    int i = std::min((int)gx, _width - 2);
+    int j = std::min((int)gy, _height - 2);
+    double tx = gx - i;
+    double ty = gy - j;
+
+    const float *row0 = _values->data() + (size_t)j*_width + i;
+    const float *row1 = row0 + _width;
+    double v0 = row0[0] + tx*(row0[1] - row0[0]);
+    double v1 = row1[0] + tx*(row1[1] - row1[0]);
+    return v0 + ty*(v1 - v0);
+}
+
+/*
+    Catmull-Rom interpolation of the 4x4 samples around the point, with
+    sample indices clamped to the grid
+*/
+double gen::NoiseField::_sampleBicubic(double x, double y) const {
+    double gx = std::min(std::max((x - _originx) * _invspacing, 0.0), (double)(_width - 1));
+    double gy = std::min(std::max((y - _originy) * _invspacing, 0.0), (double)(_height - 1));
+    int i = std::min((int)gx, _width - 2);
+    int j = std::min((int)gy, _height - 2);
+    double tx = gx - i;
+    double ty = gy - j;
+
+    double rows[4];
+    if (i >= 1 && j >= 1 && i + 2 < _width && j + 2 < _height) {
+        const float *p = _values->data() + (size_t)(j - 1)*_width + (i - 1);
+        for (int k = 0; k < 4; k++, p += _width) {
+            rows[k] = _cubic(p[0], p[1], p[2], p[3], tx);
+        }
+        return _cubic(rows[0], rows[1], rows[2], rows[3], ty);
+    }
+
+    for (int k = 0; k < 4; k++) {
+        int jj = j - 1 + k;
+        rows[k] = _cubic(_getValue(i - 1, jj), _getValue(i, jj),
+                         _getValue(i + 1, jj), _getValue(i + 2, jj), tx);
+    }
+    return _cubic(rows[0], rows[1], rows[2], rows[3], ty);
+}
+
+double gen::NoiseField::_getValue(int i, int j) const {
+    i = std::min(std::max(i, 0), _width - 1);
+    j = std::min(std::max(j, 0), _height - 1);
+    return (*_values)[(size_t)j*_width + i];
+}
+
+double gen::NoiseField::_cubic(double p0, double p1, double p2, double p3, double t) const {
+    double a = -0.5*p0 + 1.5*p1 - 1.5*p2 + 0.5*p3;
+    double b = p0 - 2.5*p1 + 2.0*p2 - 0.5*p3;
+    double c = -0.5*p0 + 0.5*p2;
+    return ((a*t + b)*t + c)*t + p1;
+}
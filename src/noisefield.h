@@ -0,0 +1,96 @@
+#ifndef NOISEFIELD_H
+#define NOISEFIELD_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+#include "extents2d.h"
+#include "fastnoise.h"
+
+namespace gen {
+
+enum class NoiseFieldSampling : char {
+    exact    = 0x00,
+    bilinear = 0x01,
+    bicubic  = 0x02
+};
+
+/*
+    2D noise that is either evaluated exactly with FastNoise or baked once
+    onto a regular grid and interpolated.
+
+    The grid covers the extents with square cells of the given spacing,
+    padded by two samples on each side so that bicubic sampling has support
+    at the edges. Points outside the padded grid are clamped to it. Sampling
+    a baked field costs the same for any noise type or number of octaves.
+
+    Baked values are stored as float and shared between copies of a field,
+    so fields can be copied into height programs without copying the grid.
+
+    Baked grids can be cached on disk under a name derived from the noise
+    parameters (type, seed, frequency, octaves and the remaining fractal and
+    cellular settings) and the grid geometry. The cache is best effort: a
+    missing or mismatched entry is a miss, and failures to store are
+    reported to the caller without throwing.
+*/
+class NoiseField {
+
+public:
+    NoiseField() {}
+    NoiseField(FastNoise noise);
+    NoiseField(FastNoise noise, Extents2d extents, double spacing,
+               NoiseFieldSampling sampling);
+
+    NoiseFieldSampling getSampling() const;
+    bool isBaked() const;
+    int getWidth() const;
+    int getHeight() const;
+    const FastNoise& getNoise() const;
+
+    // Evaluate the noise onto the grid, split by rows across numThreads
+    void bake(int numThreads = 1);
+
+    // Load the baked grid from the cache directory. Returns false on a
+    // cache miss.
+    bool loadCache(std::string directory);
+
+    // Store the baked grid in the cache directory. Returns false if the
+    // grid could not be stored.
+    bool storeCache(std::string directory);
+
+    std::string getCacheName() const;
+
+    double getNoise(double x, double y) const;
+    void fillNoise(const double *xs, const double *ys, double *out, int n) const;
+
+private:
+    void _initializeGrid(Extents2d extents, double spacing);
+    bool _isCacheable() const;
+    std::vector<double> _getKey() const;
+    double _sampleBilinear(double x, double y) const;
+    double _sampleBicubic(double x, double y) const;
+    double _getValue(int i, int j) const;
+    double _cubic(double p0, double p1, double p2, double p3, double t) const;
+
+    FastNoise _noise;
+    NoiseFieldSampling _sampling = NoiseFieldSampling::exact;
+
+    double _originx = 0.0;
+    double _originy = 0.0;
+    double _spacing = 1.0;
+    double _invspacing = 1.0;
+    int _width = 0;
+    int _height = 0;
+    std::shared_ptr<std::vector<float> > _values;
+
+    static const int _padding = 2;
+    static const uint32_t _cacheVersion = 1;
+};
+
+}
+
+#endif
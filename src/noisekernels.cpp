@@ -0,0 +1,839 @@
+#include "noisekernels.h"
+
+#include "heightkernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define NOISEKERNELS_X86
+    #include <immintrin.h>
+#endif
+
+#if defined(NOISEKERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define NOISEKERNELS_TARGET_SSE4 __attribute__((target("sse4.1")))
+    #define NOISEKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define NOISEKERNELS_TARGET_SSE4
+    #define NOISEKERNELS_TARGET_AVX2
+#endif
+
+namespace NoiseKernels {
+
+namespace {
+
+using gen::FastNoise;
+
+// Same constants as the FastNoise simplex implementation
+const double SQRT3 = 1.7320508075688772935274463415059;
+const double F2 = 0.5 * (SQRT3 - 1.0);
+const double G2 = (3.0 - SQRT3) / 6.0;
+
+struct KernelParams {
+    const NoiseTables *tables;
+    int offset;
+    const CellularParams *cellular;
+};
+
+#ifdef NOISEKERNELS_X86
+
+/*
+    SSE4.1 implementations process two points per vector. Integer lattice
+    coordinates are held in the low two lanes of an __m128i and the table
+    lookups are done one lane at a time.
+*/
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128i floorSse4(__m128d f) {
+    __m128d adjust = _mm_and_pd(_mm_cmpnge_pd(f, _mm_setzero_pd()), _mm_set1_pd(-1.0));
+    return _mm_add_epi32(_mm_cvttpd_epi32(f), _mm_cvttpd_epi32(adjust));
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128i roundSse4(__m128d f) {
+    __m128d half = _mm_blendv_pd(_mm_set1_pd(0.5), _mm_set1_pd(-0.5),
+                                 _mm_cmpnge_pd(f, _mm_setzero_pd()));
+    return _mm_cvttpd_epi32(_mm_add_pd(f, half));
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128i gatherSse4(const int *table, __m128i idx) {
+    return _mm_setr_epi32(table[_mm_cvtsi128_si32(idx)],
+                          table[_mm_extract_epi32(idx, 1)], 0, 0);
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128d gatherSse4(const double *table, __m128i idx) {
+    return _mm_setr_pd(table[_mm_cvtsi128_si32(idx)],
+                       table[_mm_extract_epi32(idx, 1)]);
+}
+
+// Lattice hash table[(x & 0xff) + row] with row = perm[(y & 0xff) + offset],
+// where the row is shared by the corners with the same y
+NOISEKERNELS_TARGET_SSE4
+inline __m128i rowSse4(const int *perm, __m128i offset, __m128i y) {
+    return gatherSse4(perm, _mm_add_epi32(_mm_and_si128(y, _mm_set1_epi32(0xff)), offset));
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128i indexSse4(const int *table, __m128i x, __m128i row) {
+    return gatherSse4(table, _mm_add_epi32(_mm_and_si128(x, _mm_set1_epi32(0xff)), row));
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128d lerpSse4(__m128d a, __m128d b, __m128d t) {
+    return _mm_add_pd(a, _mm_mul_pd(t, _mm_sub_pd(b, a)));
+}
+
+template<FastNoise::Interp I>
+NOISEKERNELS_TARGET_SSE4
+inline __m128d interpSse4(__m128d t) {
+    if (I == FastNoise::Hermite) {
+        return _mm_mul_pd(_mm_mul_pd(t, t),
+                          _mm_sub_pd(_mm_set1_pd(3.0), _mm_mul_pd(_mm_set1_pd(2.0), t)));
+    }
+    if (I == FastNoise::Quintic) {
+        __m128d poly = _mm_sub_pd(_mm_mul_pd(t, _mm_set1_pd(6.0)), _mm_set1_pd(15.0));
+        poly = _mm_add_pd(_mm_mul_pd(t, poly), _mm_set1_pd(10.0));
+        return _mm_mul_pd(_mm_mul_pd(_mm_mul_pd(t, t), t), poly);
+    }
+    return t;
+}
+
+// xd*GRAD_X[lut] + yd*GRAD_Y[lut] for the 12 gradients of FastNoise
+//     GRAD_X = {1, -1, 1, -1, 1, -1, 1, -1, 0, 0, 0, 0}
+//     GRAD_Y = {1, 1, -1, -1, 0, 0, 0, 0, 1, -1, 1, -1}
+// with the gradient components computed from the bits of lut
+NOISEKERNELS_TARGET_SSE4
+inline __m128d gradCoordSse4(__m128i lut, __m128d xd, __m128d yd) {
+    __m128i one = _mm_set1_epi32(1);
+    __m128i below4 = _mm_cmplt_epi32(lut, _mm_set1_epi32(4));
+    __m128i below8 = _mm_cmplt_epi32(lut, _mm_set1_epi32(8));
+    __m128i sign0 = _mm_sub_epi32(one, _mm_slli_epi32(_mm_and_si128(lut, one), 1));
+    __m128i sign1 = _mm_sub_epi32(one, _mm_and_si128(lut, _mm_set1_epi32(2)));
+    __m128i gx = _mm_and_si128(below8, sign0);
+    __m128i gy = _mm_blendv_epi8(_mm_andnot_si128(below8, sign0), sign1, below4);
+    return _mm_add_pd(_mm_mul_pd(xd, _mm_cvtepi32_pd(gx)),
+                      _mm_mul_pd(yd, _mm_cvtepi32_pd(gy)));
+}
+
+NOISEKERNELS_TARGET_SSE4
+inline __m128d valCoordSse4(int seed, __m128i x, __m128i y) {
+    __m128i h = _mm_xor_si128(_mm_set1_epi32(seed),
+                              _mm_mullo_epi32(_mm_set1_epi32(1619), x));
+    h = _mm_xor_si128(h, _mm_mullo_epi32(_mm_set1_epi32(31337), y));
+    h = _mm_mullo_epi32(_mm_mullo_epi32(_mm_mullo_epi32(h, h), h), _mm_set1_epi32(60493));
+    return _mm_div_pd(_mm_cvtepi32_pd(h), _mm_set1_pd(2147483648.0));
+}
+
+template<FastNoise::CellularDistanceFunction D>
+NOISEKERNELS_TARGET_SSE4
+inline __m128d distanceSse4(__m128d vx, __m128d vy) {
+    __m128d sq = _mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy));
+    if (D == FastNoise::Euclidean) {
+        return sq;
+    }
+    __m128d sign = _mm_set1_pd(-0.0);
+    __m128d manhattan = _mm_add_pd(_mm_andnot_pd(sign, vx), _mm_andnot_pd(sign, vy));
+    if (D == FastNoise::Manhattan) {
+        return manhattan;
+    }
+    return _mm_add_pd(manhattan, sq);
+}
+
+template<FastNoise::Interp I>
+struct ValueSse4 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d operator()(__m128d x, __m128d y) const {
+        const NoiseTables &t = *p.tables;
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m128i one = _mm_set1_epi32(1);
+        __m128i x0 = floorSse4(x);
+        __m128i y0 = floorSse4(y);
+        __m128i x1 = _mm_add_epi32(x0, one);
+        __m128i y1 = _mm_add_epi32(y0, one);
+        __m128d xs = interpSse4<I>(_mm_sub_pd(x, _mm_cvtepi32_pd(x0)));
+        __m128d ys = interpSse4<I>(_mm_sub_pd(y, _mm_cvtepi32_pd(y0)));
+
+        __m128i row0 = rowSse4(t.perm, offset, y0);
+        __m128i row1 = rowSse4(t.perm, offset, y1);
+        __m128d v00 = gatherSse4(t.valueLUT, indexSse4(t.perm, x0, row0));
+        __m128d v10 = gatherSse4(t.valueLUT, indexSse4(t.perm, x1, row0));
+        __m128d v01 = gatherSse4(t.valueLUT, indexSse4(t.perm, x0, row1));
+        __m128d v11 = gatherSse4(t.valueLUT, indexSse4(t.perm, x1, row1));
+        __m128d xf0 = lerpSse4(v00, v10, xs);
+        __m128d xf1 = lerpSse4(v01, v11, xs);
+        return lerpSse4(xf0, xf1, ys);
+    }
+};
+
+template<FastNoise::Interp I>
+struct PerlinSse4 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d operator()(__m128d x, __m128d y) const {
+        const NoiseTables &t = *p.tables;
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m128i one = _mm_set1_epi32(1);
+        __m128i x0 = floorSse4(x);
+        __m128i y0 = floorSse4(y);
+        __m128i x1 = _mm_add_epi32(x0, one);
+        __m128i y1 = _mm_add_epi32(y0, one);
+        __m128d xd0 = _mm_sub_pd(x, _mm_cvtepi32_pd(x0));
+        __m128d yd0 = _mm_sub_pd(y, _mm_cvtepi32_pd(y0));
+        __m128d xs = interpSse4<I>(xd0);
+        __m128d ys = interpSse4<I>(yd0);
+        __m128d xd1 = _mm_sub_pd(xd0, _mm_set1_pd(1.0));
+        __m128d yd1 = _mm_sub_pd(yd0, _mm_set1_pd(1.0));
+
+        __m128i row0 = rowSse4(t.perm, offset, y0);
+        __m128i row1 = rowSse4(t.perm, offset, y1);
+        __m128d g00 = gradCoordSse4(indexSse4(t.perm12, x0, row0), xd0, yd0);
+        __m128d g10 = gradCoordSse4(indexSse4(t.perm12, x1, row0), xd1, yd0);
+        __m128d g01 = gradCoordSse4(indexSse4(t.perm12, x0, row1), xd0, yd1);
+        __m128d g11 = gradCoordSse4(indexSse4(t.perm12, x1, row1), xd1, yd1);
+        __m128d xf0 = lerpSse4(g00, g10, xs);
+        __m128d xf1 = lerpSse4(g01, g11, xs);
+        return lerpSse4(xf0, xf1, ys);
+    }
+};
+
+struct SimplexSse4 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d corner(__m128i offset, __m128i i, __m128i j, __m128d x, __m128d y) const {
+        __m128d t = _mm_sub_pd(_mm_sub_pd(_mm_set1_pd(0.5), _mm_mul_pd(x, x)),
+                               _mm_mul_pd(y, y));
+        __m128d outside = _mm_cmplt_pd(t, _mm_setzero_pd());
+        t = _mm_mul_pd(t, t);
+        __m128i lut = indexSse4(p.tables->perm12, i, rowSse4(p.tables->perm, offset, j));
+        __m128d n = _mm_mul_pd(_mm_mul_pd(t, t), gradCoordSse4(lut, x, y));
+        return _mm_blendv_pd(n, _mm_setzero_pd(), outside);
+    }
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d operator()(__m128d x, __m128d y) const {
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m128d one = _mm_set1_pd(1.0);
+        __m128d g2 = _mm_set1_pd(G2);
+
+        __m128d t = _mm_mul_pd(_mm_add_pd(x, y), _mm_set1_pd(F2));
+        __m128i i = floorSse4(_mm_add_pd(x, t));
+        __m128i j = floorSse4(_mm_add_pd(y, t));
+
+        t = _mm_mul_pd(_mm_cvtepi32_pd(_mm_add_epi32(i, j)), g2);
+        __m128d x0 = _mm_sub_pd(x, _mm_sub_pd(_mm_cvtepi32_pd(i), t));
+        __m128d y0 = _mm_sub_pd(y, _mm_sub_pd(_mm_cvtepi32_pd(j), t));
+
+        __m128d upper = _mm_cmpgt_pd(x0, y0);
+        __m128d i1 = _mm_and_pd(upper, one);
+        __m128d j1 = _mm_andnot_pd(upper, one);
+
+        __m128d x1 = _mm_add_pd(_mm_sub_pd(x0, i1), g2);
+        __m128d y1 = _mm_add_pd(_mm_sub_pd(y0, j1), g2);
+        __m128d x2 = _mm_add_pd(_mm_sub_pd(x0, one), _mm_set1_pd(2*G2));
+        __m128d y2 = _mm_add_pd(_mm_sub_pd(y0, one), _mm_set1_pd(2*G2));
+
+        __m128i ione = _mm_set1_epi32(1);
+        __m128d n0 = corner(offset, i, j, x0, y0);
+        __m128d n1 = corner(offset, _mm_add_epi32(i, _mm_cvttpd_epi32(i1)),
+                            _mm_add_epi32(j, _mm_cvttpd_epi32(j1)), x1, y1);
+        __m128d n2 = corner(offset, _mm_add_epi32(i, ione), _mm_add_epi32(j, ione), x2, y2);
+        return _mm_mul_pd(_mm_set1_pd(70.0), _mm_add_pd(_mm_add_pd(n0, n1), n2));
+    }
+};
+
+template<FastNoise::CellularDistanceFunction D>
+struct CellularSse4 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d operator()(__m128d x, __m128d y) const {
+        const NoiseTables &t = *p.tables;
+        const CellularParams &cp = *p.cellular;
+        __m128i zero = _mm_setzero_si128();
+        __m128d jitter = _mm_set1_pd(cp.jitter);
+        __m128i xr = roundSse4(x);
+        __m128i yr = roundSse4(y);
+        __m128i rows[3];
+        for (int dy = -1; dy <= 1; dy++) {
+            rows[dy + 1] = rowSse4(t.perm, zero, _mm_add_epi32(yr, _mm_set1_epi32(dy)));
+        }
+
+        __m128d distance = _mm_set1_pd(999999);
+        __m128d xc = _mm_setzero_pd();
+        __m128d yc = _mm_setzero_pd();
+        for (int dx = -1; dx <= 1; dx++) {
+            __m128i xi = _mm_add_epi32(xr, _mm_set1_epi32(dx));
+            __m128d xid = _mm_cvtepi32_pd(xi);
+            for (int dy = -1; dy <= 1; dy++) {
+                __m128i yi = _mm_add_epi32(yr, _mm_set1_epi32(dy));
+                __m128d yid = _mm_cvtepi32_pd(yi);
+                __m128i lut = indexSse4(t.perm, xi, rows[dy + 1]);
+                __m128d vecX = _mm_add_pd(_mm_sub_pd(xid, x),
+                                          _mm_mul_pd(gatherSse4(t.cellX, lut), jitter));
+                __m128d vecY = _mm_add_pd(_mm_sub_pd(yid, y),
+                                          _mm_mul_pd(gatherSse4(t.cellY, lut), jitter));
+                __m128d newDistance = distanceSse4<D>(vecX, vecY);
+
+                __m128d closer = _mm_cmplt_pd(newDistance, distance);
+                distance = _mm_blendv_pd(distance, newDistance, closer);
+                xc = _mm_blendv_pd(xc, xid, closer);
+                yc = _mm_blendv_pd(yc, yid, closer);
+            }
+        }
+
+        if (cp.returnType == FastNoise::CellValue) {
+            return valCoordSse4(cp.seed, _mm_cvttpd_epi32(xc), _mm_cvttpd_epi32(yc));
+        }
+        return distance;
+    }
+};
+
+template<FastNoise::CellularDistanceFunction D>
+struct Cellular2EdgeSse4 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_SSE4
+    __m128d operator()(__m128d x, __m128d y) const {
+        const NoiseTables &t = *p.tables;
+        const CellularParams &cp = *p.cellular;
+        __m128i zero = _mm_setzero_si128();
+        __m128d jitter = _mm_set1_pd(cp.jitter);
+        __m128i xr = roundSse4(x);
+        __m128i yr = roundSse4(y);
+        __m128i rows[3];
+        for (int dy = -1; dy <= 1; dy++) {
+            rows[dy + 1] = rowSse4(t.perm, zero, _mm_add_epi32(yr, _mm_set1_epi32(dy)));
+        }
+
+        __m128d distance[FN_CELLULAR_INDEX_MAX + 1];
+        for (int i = 0; i <= FN_CELLULAR_INDEX_MAX; i++) {
+            distance[i] = _mm_set1_pd(999999);
+        }
+        for (int dx = -1; dx <= 1; dx++) {
+            __m128i xi = _mm_add_epi32(xr, _mm_set1_epi32(dx));
+            __m128d xid = _mm_cvtepi32_pd(xi);
+            for (int dy = -1; dy <= 1; dy++) {
+                __m128i yi = _mm_add_epi32(yr, _mm_set1_epi32(dy));
+                __m128i lut = indexSse4(t.perm, xi, rows[dy + 1]);
+                __m128d vecX = _mm_add_pd(_mm_sub_pd(xid, x),
+                                          _mm_mul_pd(gatherSse4(t.cellX, lut), jitter));
+                __m128d vecY = _mm_add_pd(_mm_sub_pd(_mm_cvtepi32_pd(yi), y),
+                                          _mm_mul_pd(gatherSse4(t.cellY, lut), jitter));
+                __m128d newDistance = distanceSse4<D>(vecX, vecY);
+
+                for (int i = cp.distanceIndex1; i > 0; i--) {
+                    distance[i] = _mm_max_pd(_mm_min_pd(distance[i], newDistance),
+                                             distance[i - 1]);
+                }
+                distance[0] = _mm_min_pd(distance[0], newDistance);
+            }
+        }
+
+        __m128d d0 = distance[cp.distanceIndex0];
+        __m128d d1 = distance[cp.distanceIndex1];
+        switch (cp.returnType) {
+            case FastNoise::Distance2:
+                return d1;
+            case FastNoise::Distance2Add:
+                return _mm_add_pd(d1, d0);
+            case FastNoise::Distance2Sub:
+                return _mm_sub_pd(d1, d0);
+            case FastNoise::Distance2Mul:
+                return _mm_mul_pd(d1, d0);
+            case FastNoise::Distance2Div:
+                return _mm_div_pd(d0, d1);
+            default:
+                return _mm_setzero_pd();
+        }
+    }
+};
+
+template<class Kernel>
+NOISEKERNELS_TARGET_SSE4
+void runSse4(const Kernel &kernel, const double *x, const double *y, double *out, int n) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, kernel(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+    }
+    if (i < n) {
+        double px[2] = {x[i], 0.0};
+        double py[2] = {y[i], 0.0};
+        double pout[2];
+        _mm_storeu_pd(pout, kernel(_mm_loadu_pd(px), _mm_loadu_pd(py)));
+        out[i] = pout[0];
+    }
+}
+
+/*
+    AVX2 implementations process four points per vector with the table
+    lookups done by gathers
+*/
+
+NOISEKERNELS_TARGET_AVX2
+inline __m128i floorAvx2(__m256d f) {
+    __m256d negative = _mm256_cmp_pd(f, _mm256_setzero_pd(), _CMP_NGE_UQ);
+    __m256d adjust = _mm256_and_pd(negative, _mm256_set1_pd(-1.0));
+    return _mm_add_epi32(_mm256_cvttpd_epi32(f), _mm256_cvttpd_epi32(adjust));
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m128i roundAvx2(__m256d f) {
+    __m256d negative = _mm256_cmp_pd(f, _mm256_setzero_pd(), _CMP_NGE_UQ);
+    __m256d half = _mm256_blendv_pd(_mm256_set1_pd(0.5), _mm256_set1_pd(-0.5), negative);
+    return _mm256_cvttpd_epi32(_mm256_add_pd(f, half));
+}
+
+// Masked gather from a zeroed source, which unlike _mm256_i32gather_pd
+// does not read an undefined register
+NOISEKERNELS_TARGET_AVX2
+inline __m256d gatherAvx2(const double *table, __m128i idx) {
+    __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), table, idx, all, 8);
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m128i rowAvx2(const int *perm, __m128i offset, __m128i y) {
+    __m128i idx = _mm_add_epi32(_mm_and_si128(y, _mm_set1_epi32(0xff)), offset);
+    return _mm_i32gather_epi32(perm, idx, 4);
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m128i indexAvx2(const int *table, __m128i x, __m128i row) {
+    __m128i idx = _mm_add_epi32(_mm_and_si128(x, _mm_set1_epi32(0xff)), row);
+    return _mm_i32gather_epi32(table, idx, 4);
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m256d lerpAvx2(__m256d a, __m256d b, __m256d t) {
+    return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+}
+
+template<FastNoise::Interp I>
+NOISEKERNELS_TARGET_AVX2
+inline __m256d interpAvx2(__m256d t) {
+    if (I == FastNoise::Hermite) {
+        return _mm256_mul_pd(_mm256_mul_pd(t, t),
+                             _mm256_sub_pd(_mm256_set1_pd(3.0),
+                                           _mm256_mul_pd(_mm256_set1_pd(2.0), t)));
+    }
+    if (I == FastNoise::Quintic) {
+        __m256d poly = _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6.0)),
+                                     _mm256_set1_pd(15.0));
+        poly = _mm256_add_pd(_mm256_mul_pd(t, poly), _mm256_set1_pd(10.0));
+        return _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(t, t), t), poly);
+    }
+    return t;
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m256d gradCoordAvx2(__m128i lut, __m256d xd, __m256d yd) {
+    __m128i one = _mm_set1_epi32(1);
+    __m128i below4 = _mm_cmplt_epi32(lut, _mm_set1_epi32(4));
+    __m128i below8 = _mm_cmplt_epi32(lut, _mm_set1_epi32(8));
+    __m128i sign0 = _mm_sub_epi32(one, _mm_slli_epi32(_mm_and_si128(lut, one), 1));
+    __m128i sign1 = _mm_sub_epi32(one, _mm_and_si128(lut, _mm_set1_epi32(2)));
+    __m128i gx = _mm_and_si128(below8, sign0);
+    __m128i gy = _mm_blendv_epi8(_mm_andnot_si128(below8, sign0), sign1, below4);
+    return _mm256_add_pd(_mm256_mul_pd(xd, _mm256_cvtepi32_pd(gx)),
+                         _mm256_mul_pd(yd, _mm256_cvtepi32_pd(gy)));
+}
+
+NOISEKERNELS_TARGET_AVX2
+inline __m256d valCoordAvx2(int seed, __m128i x, __m128i y) {
+    __m128i h = _mm_xor_si128(_mm_set1_epi32(seed),
+                              _mm_mullo_epi32(_mm_set1_epi32(1619), x));
+    h = _mm_xor_si128(h, _mm_mullo_epi32(_mm_set1_epi32(31337), y));
+    h = _mm_mullo_epi32(_mm_mullo_epi32(_mm_mullo_epi32(h, h), h), _mm_set1_epi32(60493));
+    return _mm256_div_pd(_mm256_cvtepi32_pd(h), _mm256_set1_pd(2147483648.0));
+}
+
+template<FastNoise::CellularDistanceFunction D>
+NOISEKERNELS_TARGET_AVX2
+inline __m256d distanceAvx2(__m256d vx, __m256d vy) {
+    __m256d sq = _mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy));
+    if (D == FastNoise::Euclidean) {
+        return sq;
+    }
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d manhattan = _mm256_add_pd(_mm256_andnot_pd(sign, vx), _mm256_andnot_pd(sign, vy));
+    if (D == FastNoise::Manhattan) {
+        return manhattan;
+    }
+    return _mm256_add_pd(manhattan, sq);
+}
+
+template<FastNoise::Interp I>
+struct ValueAvx2 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d operator()(__m256d x, __m256d y) const {
+        const NoiseTables &t = *p.tables;
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m128i one = _mm_set1_epi32(1);
+        __m128i x0 = floorAvx2(x);
+        __m128i y0 = floorAvx2(y);
+        __m128i x1 = _mm_add_epi32(x0, one);
+        __m128i y1 = _mm_add_epi32(y0, one);
+        __m256d xs = interpAvx2<I>(_mm256_sub_pd(x, _mm256_cvtepi32_pd(x0)));
+        __m256d ys = interpAvx2<I>(_mm256_sub_pd(y, _mm256_cvtepi32_pd(y0)));
+
+        __m128i row0 = rowAvx2(t.perm, offset, y0);
+        __m128i row1 = rowAvx2(t.perm, offset, y1);
+        __m256d v00 = gatherAvx2(t.valueLUT, indexAvx2(t.perm, x0, row0));
+        __m256d v10 = gatherAvx2(t.valueLUT, indexAvx2(t.perm, x1, row0));
+        __m256d v01 = gatherAvx2(t.valueLUT, indexAvx2(t.perm, x0, row1));
+        __m256d v11 = gatherAvx2(t.valueLUT, indexAvx2(t.perm, x1, row1));
+        __m256d xf0 = lerpAvx2(v00, v10, xs);
+        __m256d xf1 = lerpAvx2(v01, v11, xs);
+        return lerpAvx2(xf0, xf1, ys);
+    }
+};
+
+template<FastNoise::Interp I>
+struct PerlinAvx2 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d operator()(__m256d x, __m256d y) const {
+        const NoiseTables &t = *p.tables;
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m128i one = _mm_set1_epi32(1);
+        __m128i x0 = floorAvx2(x);
+        __m128i y0 = floorAvx2(y);
+        __m128i x1 = _mm_add_epi32(x0, one);
+        __m128i y1 = _mm_add_epi32(y0, one);
+        __m256d xd0 = _mm256_sub_pd(x, _mm256_cvtepi32_pd(x0));
+        __m256d yd0 = _mm256_sub_pd(y, _mm256_cvtepi32_pd(y0));
+        __m256d xs = interpAvx2<I>(xd0);
+        __m256d ys = interpAvx2<I>(yd0);
+        __m256d xd1 = _mm256_sub_pd(xd0, _mm256_set1_pd(1.0));
+        __m256d yd1 = _mm256_sub_pd(yd0, _mm256_set1_pd(1.0));
+
+        __m128i row0 = rowAvx2(t.perm, offset, y0);
+        __m128i row1 = rowAvx2(t.perm, offset, y1);
+        __m256d g00 = gradCoordAvx2(indexAvx2(t.perm12, x0, row0), xd0, yd0);
+        __m256d g10 = gradCoordAvx2(indexAvx2(t.perm12, x1, row0), xd1, yd0);
+        __m256d g01 = gradCoordAvx2(indexAvx2(t.perm12, x0, row1), xd0, yd1);
+        __m256d g11 = gradCoordAvx2(indexAvx2(t.perm12, x1, row1), xd1, yd1);
+        __m256d xf0 = lerpAvx2(g00, g10, xs);
+        __m256d xf1 = lerpAvx2(g01, g11, xs);
+        return lerpAvx2(xf0, xf1, ys);
+    }
+};
+
+struct SimplexAvx2 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d corner(__m128i offset, __m128i i, __m128i j, __m256d x, __m256d y) const {
+        __m256d t = _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(x, x)),
+                                  _mm256_mul_pd(y, y));
+        __m256d outside = _mm256_cmp_pd(t, _mm256_setzero_pd(), _CMP_LT_OQ);
+        t = _mm256_mul_pd(t, t);
+        __m128i lut = indexAvx2(p.tables->perm12, i, rowAvx2(p.tables->perm, offset, j));
+        __m256d n = _mm256_mul_pd(_mm256_mul_pd(t, t), gradCoordAvx2(lut, x, y));
+        return _mm256_blendv_pd(n, _mm256_setzero_pd(), outside);
+    }
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d operator()(__m256d x, __m256d y) const {
+        __m128i offset = _mm_set1_epi32(p.offset);
+        __m256d one = _mm256_set1_pd(1.0);
+        __m256d g2 = _mm256_set1_pd(G2);
+
+        __m256d t = _mm256_mul_pd(_mm256_add_pd(x, y), _mm256_set1_pd(F2));
+        __m128i i = floorAvx2(_mm256_add_pd(x, t));
+        __m128i j = floorAvx2(_mm256_add_pd(y, t));
+
+        t = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm_add_epi32(i, j)), g2);
+        __m256d x0 = _mm256_sub_pd(x, _mm256_sub_pd(_mm256_cvtepi32_pd(i), t));
+        __m256d y0 = _mm256_sub_pd(y, _mm256_sub_pd(_mm256_cvtepi32_pd(j), t));
+
+        __m256d upper = _mm256_cmp_pd(x0, y0, _CMP_GT_OQ);
+        __m256d i1 = _mm256_and_pd(upper, one);
+        __m256d j1 = _mm256_andnot_pd(upper, one);
+
+        __m256d x1 = _mm256_add_pd(_mm256_sub_pd(x0, i1), g2);
+        __m256d y1 = _mm256_add_pd(_mm256_sub_pd(y0, j1), g2);
+        __m256d x2 = _mm256_add_pd(_mm256_sub_pd(x0, one), _mm256_set1_pd(2*G2));
+        __m256d y2 = _mm256_add_pd(_mm256_sub_pd(y0, one), _mm256_set1_pd(2*G2));
+
+        __m128i ione = _mm_set1_epi32(1);
+        __m256d n0 = corner(offset, i, j, x0, y0);
+        __m256d n1 = corner(offset, _mm_add_epi32(i, _mm256_cvttpd_epi32(i1)),
+                            _mm_add_epi32(j, _mm256_cvttpd_epi32(j1)), x1, y1);
+        __m256d n2 = corner(offset, _mm_add_epi32(i, ione), _mm_add_epi32(j, ione), x2, y2);
+        return _mm256_mul_pd(_mm256_set1_pd(70.0), _mm256_add_pd(_mm256_add_pd(n0, n1), n2));
+    }
+};
+
+template<FastNoise::CellularDistanceFunction D>
+struct CellularAvx2 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d operator()(__m256d x, __m256d y) const {
+        const NoiseTables &t = *p.tables;
+        const CellularParams &cp = *p.cellular;
+        __m128i zero = _mm_setzero_si128();
+        __m256d jitter = _mm256_set1_pd(cp.jitter);
+        __m128i xr = roundAvx2(x);
+        __m128i yr = roundAvx2(y);
+        __m128i rows[3];
+        for (int dy = -1; dy <= 1; dy++) {
+            rows[dy + 1] = rowAvx2(t.perm, zero, _mm_add_epi32(yr, _mm_set1_epi32(dy)));
+        }
+
+        __m256d distance = _mm256_set1_pd(999999);
+        __m256d xc = _mm256_setzero_pd();
+        __m256d yc = _mm256_setzero_pd();
+        for (int dx = -1; dx <= 1; dx++) {
+            __m128i xi = _mm_add_epi32(xr, _mm_set1_epi32(dx));
+            __m256d xid = _mm256_cvtepi32_pd(xi);
+            for (int dy = -1; dy <= 1; dy++) {
+                __m128i yi = _mm_add_epi32(yr, _mm_set1_epi32(dy));
+                __m256d yid = _mm256_cvtepi32_pd(yi);
+                __m128i lut = indexAvx2(t.perm, xi, rows[dy + 1]);
+                __m256d vecX = _mm256_add_pd(_mm256_sub_pd(xid, x),
+                                             _mm256_mul_pd(gatherAvx2(t.cellX, lut), jitter));
+                __m256d vecY = _mm256_add_pd(_mm256_sub_pd(yid, y),
+                                             _mm256_mul_pd(gatherAvx2(t.cellY, lut), jitter));
+                __m256d newDistance = distanceAvx2<D>(vecX, vecY);
+
+                __m256d closer = _mm256_cmp_pd(newDistance, distance, _CMP_LT_OQ);
+                distance = _mm256_blendv_pd(distance, newDistance, closer);
+                xc = _mm256_blendv_pd(xc, xid, closer);
+                yc = _mm256_blendv_pd(yc, yid, closer);
+            }
+        }
+
+        if (cp.returnType == FastNoise::CellValue) {
+            return valCoordAvx2(cp.seed, _mm256_cvttpd_epi32(xc), _mm256_cvttpd_epi32(yc));
+        }
+        return distance;
+    }
+};
+
+template<FastNoise::CellularDistanceFunction D>
+struct Cellular2EdgeAvx2 {
+    KernelParams p;
+
+    NOISEKERNELS_TARGET_AVX2
+    __m256d operator()(__m256d x, __m256d y) const {
+        const NoiseTables &t = *p.tables;
+        const CellularParams &cp = *p.cellular;
+        __m128i zero = _mm_setzero_si128();
+        __m256d jitter = _mm256_set1_pd(cp.jitter);
+        __m128i xr = roundAvx2(x);
+        __m128i yr = roundAvx2(y);
+        __m128i rows[3];
+        for (int dy = -1; dy <= 1; dy++) {
+            rows[dy + 1] = rowAvx2(t.perm, zero, _mm_add_epi32(yr, _mm_set1_epi32(dy)));
+        }
+
+        __m256d distance[FN_CELLULAR_INDEX_MAX + 1];
+        for (int i = 0; i <= FN_CELLULAR_INDEX_MAX; i++) {
+            distance[i] = _mm256_set1_pd(999999);
+        }
+        for (int dx = -1; dx <= 1; dx++) {
+            __m128i xi = _mm_add_epi32(xr, _mm_set1_epi32(dx));
+            __m256d xid = _mm256_cvtepi32_pd(xi);
+            for (int dy = -1; dy <= 1; dy++) {
+                __m128i yi = _mm_add_epi32(yr, _mm_set1_epi32(dy));
+                __m128i lut = indexAvx2(t.perm, xi, rows[dy + 1]);
+                __m256d vecX = _mm256_add_pd(_mm256_sub_pd(xid, x),
+                                             _mm256_mul_pd(gatherAvx2(t.cellX, lut), jitter));
+                __m256d vecY = _mm256_add_pd(_mm256_sub_pd(_mm256_cvtepi32_pd(yi), y),
+                                             _mm256_mul_pd(gatherAvx2(t.cellY, lut), jitter));
+                __m256d newDistance = distanceAvx2<D>(vecX, vecY);
+
+                for (int i = cp.distanceIndex1; i > 0; i--) {
+                    distance[i] = _mm256_max_pd(_mm256_min_pd(distance[i], newDistance),
+                                                distance[i - 1]);
+                }
+                distance[0] = _mm256_min_pd(distance[0], newDistance);
+            }
+        }
+
+        __m256d d0 = distance[cp.distanceIndex0];
+        __m256d d1 = distance[cp.distanceIndex1];
+        switch (cp.returnType) {
+            case FastNoise::Distance2:
+                return d1;
+            case FastNoise::Distance2Add:
+                return _mm256_add_pd(d1, d0);
+            case FastNoise::Distance2Sub:
+                return _mm256_sub_pd(d1, d0);
+            case FastNoise::Distance2Mul:
+                return _mm256_mul_pd(d1, d0);
+            case FastNoise::Distance2Div:
+                return _mm256_div_pd(d0, d1);
+            default:
+                return _mm256_setzero_pd();
+        }
+    }
+};
+
+template<class Kernel>
+NOISEKERNELS_TARGET_AVX2
+void runAvx2(const Kernel &kernel, const double *x, const double *y, double *out, int n) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, kernel(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    }
+    if (i < n) {
+        double px[4] = {0.0, 0.0, 0.0, 0.0};
+        double py[4] = {0.0, 0.0, 0.0, 0.0};
+        double pout[4];
+        for (int k = 0; k < n - i; k++) {
+            px[k] = x[i + k];
+            py[k] = y[i + k];
+        }
+        _mm256_storeu_pd(pout, kernel(_mm256_loadu_pd(px), _mm256_loadu_pd(py)));
+        for (int k = 0; k < n - i; k++) {
+            out[i + k] = pout[k];
+        }
+    }
+}
+
+#endif
+
+template<template<FastNoise::Interp> class KernelSse4,
+         template<FastNoise::Interp> class KernelAvx2>
+void interpDispatch(const KernelParams &p, FastNoise::Interp interp,
+                    const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    bool isAvx2 = HeightKernels::getInstructionSet() == HeightKernels::InstructionSet::avx2;
+    switch (interp) {
+        case FastNoise::Linear:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Linear>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Linear>{p}, x, y, out, n);
+            }
+            return;
+        case FastNoise::Hermite:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Hermite>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Hermite>{p}, x, y, out, n);
+            }
+            return;
+        case FastNoise::Quintic:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Quintic>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Quintic>{p}, x, y, out, n);
+            }
+            return;
+    }
+#else
+    (void)p; (void)interp; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+template<template<FastNoise::CellularDistanceFunction> class KernelSse4,
+         template<FastNoise::CellularDistanceFunction> class KernelAvx2>
+void distanceDispatch(const KernelParams &p,
+                      const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    bool isAvx2 = HeightKernels::getInstructionSet() == HeightKernels::InstructionSet::avx2;
+    switch (p.cellular->distanceFunction) {
+        case FastNoise::Euclidean:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Euclidean>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Euclidean>{p}, x, y, out, n);
+            }
+            return;
+        case FastNoise::Manhattan:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Manhattan>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Manhattan>{p}, x, y, out, n);
+            }
+            return;
+        case FastNoise::Natural:
+            if (isAvx2) {
+                runAvx2(KernelAvx2<FastNoise::Natural>{p}, x, y, out, n);
+            } else {
+                runSse4(KernelSse4<FastNoise::Natural>{p}, x, y, out, n);
+            }
+            return;
+    }
+#else
+    (void)p; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+KernelParams kernelParams(const NoiseTables &t, int offset, const CellularParams *cellular) {
+    KernelParams p;
+    p.tables = &t;
+    p.offset = offset;
+    p.cellular = cellular;
+    return p;
+}
+
+}
+
+bool isVectorized() {
+#ifdef NOISEKERNELS_X86
+    return HeightKernels::getInstructionSet() != HeightKernels::InstructionSet::scalar;
+#else
+    return false;
+#endif
+}
+
+void value(const NoiseTables &t, gen::FastNoise::Interp interp, unsigned char offset,
+           const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    interpDispatch<ValueSse4, ValueAvx2>(kernelParams(t, offset, nullptr),
+                                         interp, x, y, out, n);
+#else
+    (void)t; (void)interp; (void)offset; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+void perlin(const NoiseTables &t, gen::FastNoise::Interp interp, unsigned char offset,
+            const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    interpDispatch<PerlinSse4, PerlinAvx2>(kernelParams(t, offset, nullptr),
+                                           interp, x, y, out, n);
+#else
+    (void)t; (void)interp; (void)offset; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+void simplex(const NoiseTables &t, unsigned char offset,
+             const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    KernelParams p = kernelParams(t, offset, nullptr);
+    if (HeightKernels::getInstructionSet() == HeightKernels::InstructionSet::avx2) {
+        runAvx2(SimplexAvx2{p}, x, y, out, n);
+    } else {
+        runSse4(SimplexSse4{p}, x, y, out, n);
+    }
+#else
+    (void)t; (void)offset; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+void cellular(const NoiseTables &t, const CellularParams &p,
+              const double *x, const double *y, double *out, int n) {
+#ifdef NOISEKERNELS_X86
+    KernelParams kp = kernelParams(t, 0, &p);
+    if (p.returnType == gen::FastNoise::CellValue || p.returnType == gen::FastNoise::Distance) {
+        distanceDispatch<CellularSse4, CellularAvx2>(kp, x, y, out, n);
+    } else {
+        distanceDispatch<Cellular2EdgeSse4, Cellular2EdgeAvx2>(kp, x, y, out, n);
+    }
+#else
+    (void)t; (void)p; (void)x; (void)y; (void)out; (void)n;
+#endif
+}
+
+}
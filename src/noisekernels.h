@@ -0,0 +1,58 @@
+#ifndef NOISEKERNELS_H
+#define NOISEKERNELS_H
+
+#include "fastnoise.h"
+
+/*
+    Vectorized 2D noise over contiguous x and y arrays for FastNoise::FillNoise.
+
+    Each kernel has SSE4.1 and AVX2 implementations selected by the
+    instruction set of the height kernels (HeightKernels::getInstructionSet).
+    The kernels evaluate the same expressions in the same order as the
+    FastNoise scalar functions, with table lookups done through gathers, so
+    the batched noise is bit-identical to GetNoise. Trailing points that do
+    not fill a vector are evaluated in a padded vector.
+
+    The kernels may only be called while isVectorized() is true, and expect
+    coordinates that have already been scaled by the noise frequency.
+*/
+namespace NoiseKernels {
+
+// Lookup tables of a FastNoise generator with the permutations widened
+// to int for use as gather indices
+struct NoiseTables {
+    int perm[512];
+    int perm12[512];
+    const double *valueLUT;     // 256 entries
+    const double *cellX;        // 256 entries
+    const double *cellY;        // 256 entries
+};
+
+struct CellularParams {
+    int seed;
+    double jitter;
+    gen::FastNoise::CellularDistanceFunction distanceFunction;
+    gen::FastNoise::CellularReturnType returnType;
+    int distanceIndex0;
+    int distanceIndex1;
+};
+
+// True if a vector instruction set is selected
+bool isVectorized();
+
+// SingleValue, SinglePerlin and SingleSimplex with permutation offset
+void value(const NoiseTables &t, gen::FastNoise::Interp interp, unsigned char offset,
+           const double *x, const double *y, double *out, int n);
+void perlin(const NoiseTables &t, gen::FastNoise::Interp interp, unsigned char offset,
+            const double *x, const double *y, double *out, int n);
+void simplex(const NoiseTables &t, unsigned char offset,
+             const double *x, const double *y, double *out, int n);
+
+// SingleCellular for the CellValue and Distance return types, and
+// SingleCellular2Edge for the Distance2 return types
+void cellular(const NoiseTables &t, const CellularParams &p,
+              const double *x, const double *y, double *out, int n);
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "parallel.h"
+
+int Parallel::getMaxThreadCount() {
+    int n = (int)std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+int Parallel::getThreadCount(int numThreads) {
+    return numThreads > 0 ? numThreads : getMaxThreadCount();
+}
+
+void Parallel::forEach(int begin, int end, int numThreads,
+                       std::function<void(int)> fn) {
+    forEachRange(begin, end, numThreads, [&fn](int b, int e, int) {
+        for (int i = b; i < e; i++) {
+            fn(i);
+        }
+    });
+}
+
+void Parallel::forEachRange(int begin, int end, int numThreads,
+                            std::function<void(int, int, int)> fn) {
+    int n = end - begin;
+    if (n <= 0) {
+        return;
+    }
+
+    int nthreads = getThreadCount(numThreads);
+    if (nthreads > n) {
+        nthreads = n;
+    }
+
+    if (nthreads == 1) {
+        fn(begin, end, 0);
+        return;
+    }
+
+    int chunksize = n / nthreads;
+    int remainder = n % nthreads;
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads - 1);
+
+    int chunkbegin = begin;
+    int firstend = begin;
+    for (int t = 0; t < nthreads; t++) {
+        int chunkend = chunkbegin + chunksize + (t < remainder ? 1 : 0);
+        if (t == 0) {
+            firstend = chunkend;
+        } else {
+            threads.push_back(std::thread(fn, chunkbegin, chunkend, t));
+        }
+        chunkbegin = chunkend;
+    }
+
+    // The calling thread processes the first chunk
+    fn(begin, firstend, 0);
+
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
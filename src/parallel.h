@@ -0,0 +1,31 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <functional>
+
+namespace Parallel {
+
+// Number of worker threads to use when numThreads <= 0
+int getMaxThreadCount();
+int getThreadCount(int numThreads);
+
+/*
+    Run fn(idx) for each idx in [begin, end) on up to numThreads worker
+    threads. Indices are split into contiguous, evenly sized chunks so that
+    the assignment of work to threads is deterministic.
+*/
+void forEach(int begin, int end, int numThreads,
+             std::function<void(int)> fn);
+
+/*
+    Run fn(chunkBegin, chunkEnd, threadIdx) on each of up to numThreads
+    contiguous chunks of [begin, end).
+*/
+void forEachRange(int begin, int end, int numThreads,
+                  std::function<void(int, int, int)> fn);
+
+}
+
+#endif
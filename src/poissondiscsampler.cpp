@@ -124,3 +124,306 @@ bool PoissonDiscSampler::_isSampleValid(dcel::Point &p, double r,
 
     return true;
 }
+
+std::vector<dcel::Point> PoissonDiscSampler::generateTiledSamples(
+                                                Extents2d bounds, double r, int k,
+                                                unsigned int seed, int numThreads) {
+    double dx = r / sqrt(2);
+    TiledSampleGrid tgrid(bounds, dx, _tileCellSize);
+    _initializeSampleTiles(tgrid, seed);
+
+    // Tiles are 2-coloured in each direction. Tiles of the same phase are
+    // separated by at least one full tile, which is wider than the sample
+    // validity neighbourhood, so they never read or write the same cells.
+    std::vector<int> phaseTiles;
+    for (int phase = 0; phase < 4; phase++) {
+        phaseTiles.clear();
+        for (int tj = 0; tj < tgrid.tilesHigh; tj++) {
+            for (int ti = 0; ti < tgrid.tilesWide; ti++) {
+                if ((ti % 2) + 2*(tj % 2) == phase) {
+                    phaseTiles.push_back(ti + tj*tgrid.tilesWide);
+                }
+            }
+        }
+
+        Parallel::forEach(0, (int)phaseTiles.size(), numThreads, 
+            [&phaseTiles, &tgrid, r, k](int idx) {
+                _generateTileSamples(phaseTiles[idx], r, k, tgrid);
+            }
+        );
+    }
+
+    std::vector<Point> points;
+    size_t count = 0;
+    for (unsigned int i = 0; i < tgrid.tiles.size(); i++) {
+        count += tgrid.tiles[i].points.size();
+    }
+
+    points.reserve(count);
+    for (unsigned int i = 0; i < tgrid.tiles.size(); i++) {
+        std::vector<Point> &tilePoints = tgrid.tiles[i].points;
+        points.insert(points.end(), tilePoints.begin(), tilePoints.end());
+    }
+
+    return points;
+}
+
+void PoissonDiscSampler::_initializeSampleTiles(TiledSampleGrid &tgrid, 
+                                                unsigned int seed) {
+    for (int tj = 0; tj < tgrid.tilesHigh; tj++) {
+        for (int ti = 0; ti < tgrid.tilesWide; ti++) {
+            int tidx = ti + tj*tgrid.tilesWide;
+            SampleTile &tile = tgrid.tiles[tidx];
+            tile.imin = ti * tgrid.tileSize;
+            tile.jmin = tj * tgrid.tileSize;
+            tile.imax = (int)fmin(tile.imin + tgrid.tileSize, tgrid.grid.width);
+            tile.jmax = (int)fmin(tile.jmin + tgrid.tileSize, tgrid.grid.height);
+
+            std::seed_seq seq{seed, (unsigned int)tidx};
+            tile.rng.seed(seq);
+        }
+    }
+}
+
+void PoissonDiscSampler::_generateTileSamples(int tileidx, double r, int k, 
+                                              TiledSampleGrid &tgrid) {
+    SampleTile &tile = tgrid.tiles[tileidx];
+
+    // Samples of previously processed neighbour tiles that lie near the
+    // tile are used as the initial growth front so that the tile is filled
+    // seamlessly up to its boundary. Candidates are only accepted inside
+    // of the tile.
+    std::vector<Point> activeList;
+    _getTileBoundarySamples(tile, r, tgrid, activeList);
+
+    Extents2d b = tgrid.grid.bounds;
+    double dx = tgrid.grid.dx;
+    double minx = b.minx + tile.imin*dx;
+    double miny = b.miny + tile.jmin*dx;
+    double maxx = fmin(b.minx + tile.imax*dx, b.maxx);
+    double maxy = fmin(b.miny + tile.jmax*dx, b.maxy);
+    for (int n = 0; n < k; n++) {
+        Point seed(_randomDouble(tile.rng, minx, maxx), 
+                   _randomDouble(tile.rng, miny, maxy));
+        if (_addTileSample(tile, seed, r, tgrid)) {
+            activeList.push_back(seed);
+            break;
+        }
+    }
+
+    _growTileSamples(tile, activeList, r, k, tgrid);
+}
+
+void PoissonDiscSampler::_getTileBoundarySamples(SampleTile &tile, double r,
+                                                 TiledSampleGrid &tgrid,
+                                                 std::vector<dcel::Point> &samples) {
+    SampleGrid &grid = tgrid.grid;
+    int pad = (int)ceil(2*r / grid.dx);
+    int mini = (int)fmax(tile.imin - pad, 0);
+    int minj = (int)fmax(tile.jmin - pad, 0);
+    int maxi = (int)fmin(tile.imax + pad, grid.width);
+    int maxj = (int)fmin(tile.jmax + pad, grid.height);
+
+    for (int j = minj; j < maxj; j++) {
+        for (int i = mini; i < maxi; i++) {
+            bool isInsideTile = i >= tile.imin && i < tile.imax && 
+                                j >= tile.jmin && j < tile.jmax;
+            if (isInsideTile) {
+                continue;
+            }
+
+            int sampleid = grid.getSample(i, j);
+            if (sampleid != -1) {
+                samples.push_back(tgrid.getPoint(i, j, sampleid));
+            }
+        }
+    }
+}
+
+void PoissonDiscSampler::_growTileSamples(SampleTile &tile, 
+                                          std::vector<dcel::Point> &activeList,
+                                          double r, int k, 
+                                          TiledSampleGrid &tgrid) {
+    while (!activeList.empty()) {
+        int randidx = (int)(tile.rng() % activeList.size());
+        Point center = activeList[randidx];
+
+        bool isFound = false;
+        for (int n = 0; n < k; n++) {
+            double angle = _randomDouble(tile.rng, 0, 2*3.141592653);
+            double rl = _randomDouble(tile.rng, r, 2*r);
+            Point sample(center.x + sin(angle)*rl, center.y + cos(angle)*rl);
+            if (_addTileSample(tile, sample, r, tgrid)) {
+                activeList.push_back(sample);
+                isFound = true;
+                break;
+            }
+        }
+
+        if (!isFound) {
+            // swap and pop, order of the active list is not significant
+            activeList[randidx] = activeList.back();
+            activeList.pop_back();
+        }
+    }
+}
+
+bool PoissonDiscSampler::_addTileSample(SampleTile &tile, dcel::Point &p, 
+                                        double r, TiledSampleGrid &tgrid) {
+    if (!tgrid.grid.bounds.containsPoint(p.x, p.y)) {
+        return false;
+    }
+
+    GridIndex g = tgrid.grid.getCell(p);
+    if (g.i < tile.imin || g.i >= tile.imax || g.j < tile.jmin || g.j >= tile.jmax) {
+        return false;
+    }
+
+    if (!_isTiledSampleValid(p, r, tgrid)) {
+        return false;
+    }
+
+    tgrid.grid.setSample(g, tile.points.size());
+    tile.points.push_back(p);
+
+    return true;
+}
+
+bool PoissonDiscSampler::_isTiledSampleValid(dcel::Point &p, double r, 
+                                             TiledSampleGrid &tgrid) {
+    SampleGrid &grid = tgrid.grid;
+    GridIndex g = grid.getCell(p);
+    if (grid.getSample(g) != -1) {
+        return false;
+    }
+
+    int mini = (int)fmax(g.i - 2, 0);
+    int minj = (int)fmax(g.j - 2, 0);
+    int maxi = (int)fmin(g.i + 2, grid.width - 1);
+    int maxj = (int)fmin(g.j + 2, grid.height - 1);
+
+    double rsq = r*r;
+    for (int j = minj; j <= maxj; j++) {
+        for (int i = mini; i <= maxi; i++) {
+            int sampleid = grid.getSample(i, j);
+            if (sampleid == -1) {
+                continue;
+            }
+
+            Point o = tgrid.getPoint(i, j, sampleid);
+            double dx = p.x - o.x;
+            double dy = p.y - o.y;
+            double distsq = dx*dx + dy*dy;
+            if (distsq < rsq) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+double PoissonDiscSampler::_randomDouble(std::mt19937 &rng, double min, double max) {
+    return min + (max - min) * ((double)rng() / 4294967296.0);
+}
+
+std::vector<PoissonDiscSampler::BlueNoiseTile> 
+        PoissonDiscSampler::readBlueNoiseTiles(std::string filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open blue noise tile file: " + filename);
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint32_t numTiles = 0;
+    file.read(magic, 4);
+    file.read((char*)&version, sizeof(uint32_t));
+    file.read((char*)&numTiles, sizeof(uint32_t));
+    if (!file || std::string(magic, 4) != "BNTS" || 
+            version != _blueNoiseFileVersion || numTiles == 0) {
+        throw std::runtime_error("Invalid blue noise tile file: " + filename);
+    }
+
+    std::vector<BlueNoiseTile> tiles(numTiles);
+    std::vector<uint16_t> coords;
+    for (unsigned int tidx = 0; tidx < numTiles; tidx++) {
+        uint32_t numPoints = 0;
+        file.read((char*)&tiles[tidx].minDistance, sizeof(double));
+        file.read((char*)&numPoints, sizeof(uint32_t));
+
+        coords.resize(2*numPoints);
+        file.read((char*)coords.data(), coords.size()*sizeof(uint16_t));
+        if (!file || tiles[tidx].minDistance <= 0.0) {
+            throw std::runtime_error("Invalid blue noise tile file: " + filename);
+        }
+
+        double inv = 1.0 / 65536.0;
+        tiles[tidx].points.reserve(numPoints);
+        for (unsigned int i = 0; i < numPoints; i++) {
+            tiles[tidx].points.push_back(Point(inv*coords[2*i], inv*coords[2*i + 1]));
+        }
+    }
+
+    return tiles;
+}
+
+std::vector<dcel::Point> PoissonDiscSampler::generateTileSetSamples(
+                                                Extents2d bounds, double r,
+                                                std::vector<BlueNoiseTile> &tiles,
+                                                unsigned int seed) {
+    std::vector<Point> points;
+    if (tiles.empty()) {
+        return points;
+    }
+
+    std::mt19937 rng(seed);
+    BlueNoiseTile &tile = tiles[rng() % tiles.size()];
+    unsigned int symmetry = rng() % 8;
+    double offx = _randomDouble(rng, 0.0, 1.0);
+    double offy = _randomDouble(rng, 0.0, 1.0);
+
+    // Symmetries of the square and periodic offsets applied to the whole 
+    // tile preserve the spacing between repeated copies
+    std::vector<Point> unitPoints;
+    unitPoints.reserve(tile.points.size());
+    for (unsigned int i = 0; i < tile.points.size(); i++) {
+        double x = tile.points[i].x;
+        double y = tile.points[i].y;
+        if (symmetry & 1) { std::swap(x, y); }
+        if (symmetry & 2) { x = 1.0 - x; }
+        if (symmetry & 4) { y = 1.0 - y; }
+        x += offx;
+        y += offy;
+        unitPoints.push_back(Point(x - floor(x), y - floor(y)));
+    }
+
+    // Each sample may move by at most jitter, so stamped copies are spaced
+    // r + 2*jitter apart to keep a minimum spacing of r
+    double jitter = _tileSetJitterFactor * r;
+    double scale = (r + 2*jitter) / tile.minDistance;
+    double halfwidth = jitter / sqrt(2);
+
+    int mini = (int)floor((bounds.minx - jitter) / scale);
+    int minj = (int)floor((bounds.miny - jitter) / scale);
+    int maxi = (int)floor((bounds.maxx + jitter) / scale);
+    int maxj = (int)floor((bounds.maxy + jitter) / scale);
+
+    double area = (bounds.maxx - bounds.minx) * (bounds.maxy - bounds.miny);
+    points.reserve((size_t)(area / (scale*scale) * unitPoints.size()) + unitPoints.size());
+    for (int j = minj; j <= maxj; j++) {
+        for (int i = mini; i <= maxi; i++) {
+            for (unsigned int pidx = 0; pidx < unitPoints.size(); pidx++) {
+                double jx = _randomDouble(rng, -halfwidth, halfwidth);
+                double jy = _randomDouble(rng, -halfwidth, halfwidth);
+                double px = (i + unitPoints[pidx].x) * scale + jx;
+                double py = (j + unitPoints[pidx].y) * scale + jy;
+                if (bounds.containsPoint(px, py)) {
+                    points.push_back(Point(px, py));
+                }
+            }
+        }
+    }
+
+    return points;
+}
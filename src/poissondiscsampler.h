@@ -4,10 +4,16 @@
 #include <vector>
 #include <cmath>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
+#include <random>
+#include <string>
+#include <fstream>
+#include <stdexcept>
 
 #include "dcel.h"
 #include "extents2d.h"
+#include "parallel.h"
 
 namespace PoissonDiscSampler {
     using namespace dcel;
@@ -74,8 +80,83 @@ namespace PoissonDiscSampler {
         }
     };
 
+    /*
+        A rectangular block of sample grid cells [imin, imax) x [jmin, jmax)
+        that is sampled independently of all other tiles in its phase. Grid
+        cells owned by a tile store indices into the tile's point list.
+    */
+    struct SampleTile {
+        int imin = 0;
+        int jmin = 0;
+        int imax = 0;
+        int jmax = 0;
+        std::mt19937 rng;
+        std::vector<Point> points;
+    };
+
+    struct TiledSampleGrid {
+        SampleGrid grid;
+        int tileSize = 0;     // in grid cells
+        int tilesWide = 0;
+        int tilesHigh = 0;
+        std::vector<SampleTile> tiles;
+
+        TiledSampleGrid(Extents2d extents, double cellsize, int tilesize) :
+                            grid(extents, cellsize), tileSize(tilesize) {
+            tilesWide = (grid.width + tileSize - 1) / tileSize;
+            tilesHigh = (grid.height + tileSize - 1) / tileSize;
+            tiles = std::vector<SampleTile>(tilesWide*tilesHigh);
+        }
+
+        int getTileIndex(int i, int j) {
+            return (i / tileSize) + (j / tileSize)*tilesWide;
+        }
+
+        Point getPoint(int i, int j, int sampleid) {
+            return tiles[getTileIndex(i, j)].points[sampleid];
+        }
+    };
+
+    /*
+        A point set on the unit square that is Poisson disc distributed when
+        repeated periodically. minDistance is the smallest (toroidal) distance
+        between any two points of the tile.
+    */
+    struct BlueNoiseTile {
+        double minDistance = 0.0;
+        std::vector<Point> points;
+    };
+
     std::vector<Point> generateSamples(Extents2d bounds, double r, int k);
 
+    /*
+        Tiled variant of generateSamples. The sample extents are split into
+        tiles of _tileCellSize x _tileCellSize grid cells. Tiles are processed
+        in four phases so that no two tiles in the same phase are adjacent and
+        tiles within a phase may be sampled concurrently on numThreads worker
+        threads. Each tile uses its own random generator seeded from seed
+        and the tile index, so the result is deterministic for a given seed
+        and does not depend on the number of threads.
+    */
+    std::vector<Point> generateTiledSamples(Extents2d bounds, double r, int k,
+                                            unsigned int seed, int numThreads);
+
+    /*
+        Read a set of precomputed blue noise tiles written by 
+        bluenoise/updatetiles.py
+    */
+    std::vector<BlueNoiseTile> readBlueNoiseTiles(std::string filename);
+
+    /*
+        Cover bounds with copies of one precomputed blue noise tile, scaled 
+        and jittered so that no two samples are closer than r. The tile, one 
+        of the eight symmetries of the square and a periodic offset are 
+        chosen from seed. Runs in O(n) without any rejection testing.
+    */
+    std::vector<Point> generateTileSetSamples(Extents2d bounds, double r,
+                                              std::vector<BlueNoiseTile> &tiles,
+                                              unsigned int seed);
+
     double _randomDouble(double min, double max);
     int _randomRange(int min, int max);
     Point _randomPoint(Extents2d &extents);
@@ -85,6 +166,22 @@ namespace PoissonDiscSampler {
     bool _isSampleValid(Point &p, double r, 
                         std::vector<Point> &points, SampleGrid &grid);
 
+    const int _tileCellSize = 32;
+    const double _tileSetJitterFactor = 0.05;
+    const uint32_t _blueNoiseFileVersion = 1;
+    void _initializeSampleTiles(TiledSampleGrid &tgrid, unsigned int seed);
+    void _generateTileSamples(int tileidx, double r, int k, 
+                              TiledSampleGrid &tgrid);
+    void _getTileBoundarySamples(SampleTile &tile, double r, 
+                                 TiledSampleGrid &tgrid, 
+                                 std::vector<Point> &samples);
+    void _growTileSamples(SampleTile &tile, std::vector<Point> &activeList,
+                          double r, int k, TiledSampleGrid &tgrid);
+    bool _addTileSample(SampleTile &tile, Point &p, double r, 
+                        TiledSampleGrid &tgrid);
+    bool _isTiledSampleValid(Point &p, double r, TiledSampleGrid &tgrid);
+    double _randomDouble(std::mt19937 &rng, double min, double max);
+
 }
 
 #endif
\ No newline at end of file
@@ -21,5 +21,13 @@ namespace resources {
     std::string getCityDataResource() {
         return std::string(RESOURCES_CITY_DATA_RESOURCE);
     }
+
+    std::string getBlueNoiseDataDirectory() {
+        return std::string(RESOURCES_BLUE_NOISE_DATA_DIRECTORY);
+    }
+
+    std::string getBlueNoiseDataResource() {
+        return std::string(RESOURCES_BLUE_NOISE_DATA_RESOURCE);
+    }
 }
 }
\ No newline at end of file
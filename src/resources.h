@@ -1,11 +1,13 @@
 #ifndef RESOURCES_H
 #define RESOURCES_H
 
-#define RESOURCES_EXECUTABLE_DIRECTORY 	"D:/Encounter/MapGen/src/lib/FantasyMapGenerator/build/x64-Test"
-#define RESOURCES_FONT_DATA_DIRECTORY 	"D:/Encounter/MapGen/src/lib/FantasyMapGenerator/build/x64-Test/fontdata"
-#define RESOURCES_CITY_DATA_DIRECTORY 	"D:/Encounter/MapGen/src/lib/FantasyMapGenerator/build/x64-Test/citydata"
-#define RESOURCES_FONT_DATA_RESOURCE 	"D:/Encounter/MapGen/src/lib/FantasyMapGenerator/build/x64-Test/fontdata/fontdata.json"
-#define RESOURCES_CITY_DATA_RESOURCE 	"D:/Encounter/MapGen/src/lib/FantasyMapGenerator/build/x64-Test/citydata/countrycities.json"
+#define RESOURCES_EXECUTABLE_DIRECTORY 	"/root/repo/_gate_build"
+#define RESOURCES_FONT_DATA_DIRECTORY 	"/root/repo/_gate_build/fontdata"
+#define RESOURCES_CITY_DATA_DIRECTORY 	"/root/repo/_gate_build/citydata"
+#define RESOURCES_FONT_DATA_RESOURCE 	"/root/repo/_gate_build/fontdata/fontdata.json"
+#define RESOURCES_CITY_DATA_RESOURCE 	"/root/repo/_gate_build/citydata/countrycities.json"
+#define RESOURCES_BLUE_NOISE_DATA_DIRECTORY 	"/root/repo/_gate_build/bluenoise"
+#define RESOURCES_BLUE_NOISE_DATA_RESOURCE 	"/root/repo/_gate_build/bluenoise/bluenoisetiles.bin"
 
 #include <string>
 
@@ -17,6 +19,8 @@ extern std::string getFontDataDirectory();
 extern std::string getCityDataDirectory();
 extern std::string getFontDataResource();
 extern std::string getCityDataResource();
+extern std::string getBlueNoiseDataDirectory();
+extern std::string getBlueNoiseDataResource();
     
 }
 }
@@ -0,0 +1,450 @@
+#include "sweephull.h"
+
+SweepHull::Triangulation SweepHull::triangulateFlat(std::vector<dcel::Point> &points) {
+    Triangulation t;
+    int32_t n = (int32_t)points.size();
+    if (n < 3) {
+        return t;
+    }
+
+    int32_t i0, i1, i2;
+    if (!_findSeedTriangle(points, &i0, &i1, &i2)) {
+        // All points are collinear
+        return t;
+    }
+
+    _SweepState s;
+    s.points = &points;
+    s.triangulation = &t;
+    s.center = _circumcenter(points[i0], points[i1], points[i2]);
+
+    // Sort points by distance from the seed circumcenter
+    std::vector<double> dists(n);
+    std::vector<int32_t> ids(n);
+    for (int32_t i = 0; i < n; i++) {
+        double dx = points[i].x - s.center.x;
+        double dy = points[i].y - s.center.y;
+        dists[i] = dx*dx + dy*dy;
+        ids[i] = i;
+    }
+    std::sort(ids.begin(), ids.end(), [&dists](int32_t a, int32_t b) {
+        return dists[a] < dists[b];
+    });
+
+    int32_t hashSize = (int32_t)ceil(sqrt((double)n));
+    s.hullHash = std::vector<int32_t>(hashSize, -1);
+    s.hullPrev = std::vector<int32_t>(n, -1);
+    s.hullNext = std::vector<int32_t>(n, -1);
+    s.hullTri = std::vector<int32_t>(n, -1);
+
+    s.hullStart = i0;
+    int32_t hullSize = 3;
+    s.hullNext[i0] = s.hullPrev[i2] = i1;
+    s.hullNext[i1] = s.hullPrev[i0] = i2;
+    s.hullNext[i2] = s.hullPrev[i1] = i0;
+    s.hullTri[i0] = 0;
+    s.hullTri[i1] = 1;
+    s.hullTri[i2] = 2;
+    s.hullHash[_hashKey(s, points[i0])] = i0;
+    s.hullHash[_hashKey(s, points[i1])] = i1;
+    s.hullHash[_hashKey(s, points[i2])] = i2;
+
+    size_t maxTriangles = 2 * (size_t)n - 5;
+    t.triangles.reserve(3 * maxTriangles);
+    t.halfedges.reserve(3 * maxTriangles);
+    _addTriangle(s, i0, i1, i2, -1, -1, -1);
+
+    double eps = std::numeric_limits<double>::epsilon();
+    Point pprev(std::numeric_limits<double>::quiet_NaN(),
+                std::numeric_limits<double>::quiet_NaN());
+    for (int32_t k = 0; k < n; k++) {
+        int32_t i = ids[k];
+        Point p = points[i];
+
+        // Skip near-duplicate points
+        if (k > 0 && fabs(p.x - pprev.x) <= eps && fabs(p.y - pprev.y) <= eps) {
+            continue;
+        }
+        pprev = p;
+
+        if (i == i0 || i == i1 || i == i2) {
+            continue;
+        }
+
+        // Find a visible edge on the convex hull using the edge hash
+        int32_t start = 0;
+        int32_t key = _hashKey(s, p);
+        for (int32_t j = 0; j < hashSize; j++) {
+            start = s.hullHash[(key + j) % hashSize];
+            if (start != -1 && start != s.hullNext[start]) {
+                break;
+            }
+        }
+
+        start = s.hullPrev[start];
+        int32_t e = start;
+        int32_t q = s.hullNext[e];
+        while (!_isCounterClockwise(p, points[e], points[q])) {
+            e = q;
+            if (e == start) {
+                e = -1;
+                break;
+            }
+            q = s.hullNext[e];
+        }
+
+        if (e == -1) {
+            // Point lies on the hull or duplicates a hull vertex
+            continue;
+        }
+
+        // Add the first triangle from the point
+        int32_t tidx = _addTriangle(s, e, i, s.hullNext[e], -1, -1, s.hullTri[e]);
+        s.hullTri[i] = _legalize(s, tidx + 2);
+        s.hullTri[e] = tidx;
+        hullSize++;
+
+        // Walk forward through the hull, adding triangles and flipping
+        int32_t next = s.hullNext[e];
+        q = s.hullNext[next];
+        while (_isCounterClockwise(p, points[next], points[q])) {
+            tidx = _addTriangle(s, next, i, q, s.hullTri[i], -1, s.hullTri[next]);
+            s.hullTri[i] = _legalize(s, tidx + 2);
+            s.hullNext[next] = next;    // mark as removed
+            hullSize--;
+            next = q;
+            q = s.hullNext[next];
+        }
+
+        // Walk backward from the other side
+        if (e == start) {
+            q = s.hullPrev[e];
+            while (_isCounterClockwise(p, points[q], points[e])) {
+                tidx = _addTriangle(s, q, i, e, -1, s.hullTri[e], s.hullTri[q]);
+                _legalize(s, tidx + 2);
+                s.hullTri[q] = tidx;
+                s.hullNext[e] = e;      // mark as removed
+                hullSize--;
+                e = q;
+                q = s.hullPrev[e];
+            }
+        }
+
+        // Update the hull
+        s.hullStart = s.hullPrev[i] = e;
+        s.hullNext[e] = s.hullPrev[next] = i;
+        s.hullNext[i] = next;
+
+        s.hullHash[_hashKey(s, p)] = i;
+        s.hullHash[_hashKey(s, points[e])] = e;
+    }
+
+    t.hull.reserve(hullSize);
+    int32_t e = s.hullStart;
+    for (int32_t i = 0; i < hullSize; i++) {
+        t.hull.push_back(e);
+        e = s.hullNext[e];
+    }
+
+    return t;
+}
+
+dcel::DCEL SweepHull::triangulate(std::vector<dcel::Point> &points) {
+    Triangulation t = triangulateFlat(points);
+    return toDCEL(points, t);
+}
+
+/*
+    Half-edge e of the flat triangulation becomes DCEL half-edge e and
+    triangle t becomes face t. Each convex hull half-edge is given an
+    exterior twin with no incident face and no next/prev, matching the
+    boundary left behind by Delaunay::_cleanup.
+*/
+dcel::DCEL SweepHull::toDCEL(std::vector<dcel::Point> &points, Triangulation &t) {
+    DCEL T;
+    if (t.triangles.empty()) {
+        return T;
+    }
+
+    int32_t numEdges = (int32_t)t.triangles.size();
+    int32_t numFaces = numEdges / 3;
+    int32_t numHullEdges = 0;
+    for (int32_t e = 0; e < numEdges; e++) {
+        if (t.halfedges[e] == -1) {
+            numHullEdges++;
+        }
+    }
+
+    T.vertices.resize(points.size());
+    for (unsigned int i = 0; i < points.size(); i++) {
+        T.vertices[i].position = points[i];
+        T.vertices[i].id = Ref(i);
+    }
+
+    T.faces.resize(numFaces);
+    for (int32_t f = 0; f < numFaces; f++) {
+        T.faces[f].outerComponent = Ref(3*f);
+        T.faces[f].id = Ref(f);
+    }
+
+    T.edges.resize(numEdges + numHullEdges);
+    int32_t hullidx = numEdges;
+    for (int32_t e = 0; e < numEdges; e++) {
+        int32_t f = e / 3;
+        int32_t next = 3*f + (e + 1) % 3;
+        int32_t prev = 3*f + (e + 2) % 3;
+
+        HalfEdge &h = T.edges[e];
+        h.id = Ref(e);
+        h.origin = Ref(t.triangles[e]);
+        h.incidentFace = Ref(f);
+        h.next = Ref(next);
+        h.prev = Ref(prev);
+        T.vertices[t.triangles[e]].incidentEdge = Ref(e);
+
+        if (t.halfedges[e] != -1) {
+            h.twin = Ref(t.halfedges[e]);
+            continue;
+        }
+
+        HalfEdge &twin = T.edges[hullidx];
+        twin.id = Ref(hullidx);
+        twin.origin = Ref(t.triangles[next]);
+        twin.twin = Ref(e);
+        h.twin = Ref(hullidx);
+        hullidx++;
+    }
+
+    return T;
+}
+
+bool SweepHull::_findSeedTriangle(std::vector<dcel::Point> &points,
+                                  int32_t *i0, int32_t *i1, int32_t *i2) {
+    double minx = std::numeric_limits<double>::infinity();
+    double miny = std::numeric_limits<double>::infinity();
+    double maxx = -std::numeric_limits<double>::infinity();
+    double maxy = -std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < points.size(); i++) {
+        Point p = points[i];
+        if (p.x < minx) { minx = p.x; }
+        if (p.y < miny) { miny = p.y; }
+        if (p.x > maxx) { maxx = p.x; }
+        if (p.y > maxy) { maxy = p.y; }
+    }
+    Point c(0.5*(minx + maxx), 0.5*(miny + maxy));
+
+    // Seed point closest to the center
+    *i0 = 0;
+    double mindist = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < points.size(); i++) {
+        double dx = points[i].x - c.x;
+        double dy = points[i].y - c.y;
+        double d = dx*dx + dy*dy;
+        if (d < mindist) {
+            *i0 = i;
+            mindist = d;
+        }
+    }
+
+    // Point closest to the seed
+    Point p0 = points[*i0];
+    *i1 = -1;
+    mindist = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < points.size(); i++) {
+        if ((int32_t)i == *i0) {
+            continue;
+        }
+        double dx = points[i].x - p0.x;
+        double dy = points[i].y - p0.y;
+        double d = dx*dx + dy*dy;
+        if (d < mindist && d > 0.0) {
+            *i1 = i;
+            mindist = d;
+        }
+    }
+
+    if (*i1 == -1) {
+        return false;
+    }
+
+    // Third point forming the smallest circumcircle with the first two
+    Point p1 = points[*i1];
+    *i2 = -1;
+    double minradius = std::numeric_limits<double>::infinity();
+    for (unsigned int i = 0; i < points.size(); i++) {
+        if ((int32_t)i == *i0 || (int32_t)i == *i1) {
+            continue;
+        }
+        double r = _circumradiusSquared(p0, p1, points[i]);
+        if (r < minradius) {
+            *i2 = i;
+            minradius = r;
+        }
+    }
+
+    if (*i2 == -1) {
+        return false;
+    }
+
+    // Triangles are wound clockwise, matching Delaunay::triangulate
+    if (_isCounterClockwise(p0, p1, points[*i2])) {
+        std::swap(*i1, *i2);
+    }
+
+    return true;
+}
+
+int32_t SweepHull::_hashKey(_SweepState &s, dcel::Point &p) {
+    // Monotonic pseudo-angle of p around the center in [0, 1)
+    double dx = p.x - s.center.x;
+    double dy = p.y - s.center.y;
+    double a = dx / (fabs(dx) + fabs(dy));
+    a = (dy > 0.0 ? 3.0 - a : 1.0 + a) / 4.0;
+
+    int32_t size = (int32_t)s.hullHash.size();
+    int32_t key = (int32_t)floor(a * size);
+    return ((key % size) + size) % size;
+}
+
+int32_t SweepHull::_addTriangle(_SweepState &s, int32_t i0, int32_t i1, int32_t i2,
+                                int32_t a, int32_t b, int32_t c) {
+    std::vector<int32_t> &triangles = s.triangulation->triangles;
+    int32_t t = (int32_t)triangles.size();
+    triangles.push_back(i0);
+    triangles.push_back(i1);
+    triangles.push_back(i2);
+    _link(s, t, a);
+    _link(s, t + 1, b);
+    _link(s, t + 2, c);
+
+    return t;
+}
+
+void SweepHull::_link(_SweepState &s, int32_t a, int32_t b) {
+    std::vector<int32_t> &halfedges = s.triangulation->halfedges;
+    if (a == (int32_t)halfedges.size()) {
+        halfedges.push_back(b);
+    } else {
+        halfedges[a] = b;
+    }
+
+    if (b != -1) {
+        halfedges[b] = a;
+    }
+}
+
+/*
+    Flip edges until all triangles around the new point are locally
+    Delaunay. Returns the half-edge that ends up opposite the point in the
+    last triangle visited.
+*/
+int32_t SweepHull::_legalize(_SweepState &s, int32_t a) {
+    std::vector<int32_t> &triangles = s.triangulation->triangles;
+    std::vector<int32_t> &halfedges = s.triangulation->halfedges;
+    std::vector<Point> &points = *(s.points);
+    s.edgeStack.clear();
+
+    int32_t ar = 0;
+    for (;;) {
+        int32_t b = halfedges[a];
+        int32_t a0 = a - a % 3;
+        ar = a0 + (a + 2) % 3;
+
+        if (b == -1) {
+            if (s.edgeStack.empty()) {
+                break;
+            }
+            a = s.edgeStack.back();
+            s.edgeStack.pop_back();
+            continue;
+        }
+
+        int32_t b0 = b - b % 3;
+        int32_t al = a0 + (a + 1) % 3;
+        int32_t bl = b0 + (b + 2) % 3;
+
+        int32_t p0 = triangles[ar];
+        int32_t pr = triangles[a];
+        int32_t pl = triangles[al];
+        int32_t p1 = triangles[bl];
+
+        if (!_isInCircle(points[p0], points[pr], points[pl], points[p1])) {
+            if (s.edgeStack.empty()) {
+                break;
+            }
+            a = s.edgeStack.back();
+            s.edgeStack.pop_back();
+            continue;
+        }
+
+        triangles[a] = p1;
+        triangles[b] = p0;
+
+        // Edge swapped on the other side of the hull (rare), fix the
+        // halfedge reference
+        int32_t hbl = halfedges[bl];
+        if (hbl == -1) {
+            int32_t e = s.hullStart;
+            do {
+                if (s.hullTri[e] == bl) {
+                    s.hullTri[e] = a;
+                    break;
+                }
+                e = s.hullPrev[e];
+            } while (e != s.hullStart);
+        }
+
+        _link(s, a, hbl);
+        _link(s, b, halfedges[ar]);
+        _link(s, ar, bl);
+
+        int32_t br = b0 + (b + 1) % 3;
+        s.edgeStack.push_back(br);
+    }
+
+    return ar;
+}
+
+bool SweepHull::_isCounterClockwise(dcel::Point &p, dcel::Point &q, dcel::Point &r) {
+    return Geometry::orient2d(p, q, r) > 0.0;
+}
+
+// True if p lies inside the circumcircle of the clockwise triangle abc
+bool SweepHull::_isInCircle(dcel::Point &a, dcel::Point &b, dcel::Point &c, dcel::Point &p) {
+    return Geometry::incircle(a, b, c, p) < 0.0;
+}
+
+double SweepHull::_circumradiusSquared(dcel::Point &a, dcel::Point &b, dcel::Point &c) {
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double ex = c.x - a.x;
+    double ey = c.y - a.y;
+
+    double bl = dx*dx + dy*dy;
+    double cl = ex*ex + ey*ey;
+    double d = dx*ey - dy*ex;
+    if (bl == 0.0 || cl == 0.0 || d == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double x = (ey*bl - dy*cl) * 0.5 / d;
+    double y = (dx*cl - ex*bl) * 0.5 / d;
+
+    return x*x + y*y;
+}
+
+dcel::Point SweepHull::_circumcenter(dcel::Point &a, dcel::Point &b, dcel::Point &c) {
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double ex = c.x - a.x;
+    double ey = c.y - a.y;
+
+    double bl = dx*dx + dy*dy;
+    double cl = ex*ex + ey*ey;
+    double d = dx*ey - dy*ex;
+
+    double x = (ey*bl - dy*cl) * 0.5 / d;
+    double y = (dx*cl - ex*bl) * 0.5 / d;
+
+    return Point(a.x + x, a.y + y);
+}
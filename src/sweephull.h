@@ -0,0 +1,69 @@
+#ifndef SWEEPHULL_H
+#define SWEEPHULL_H
+
+#include <stdio.h>
+#include <iostream>
+#include <math.h>
+#include <vector>
+#include <stdint.h>
+#include <limits>
+#include <algorithm>
+
+#include "dcel.h"
+#include "geometry.h"
+
+/*
+    Sweep-hull Delaunay triangulation in the style of Delaunator
+    (https://github.com/mapbox/delaunator).
+
+    Points are inserted in order of distance from the circumcenter of a seed
+    triangle so that each new point lies outside of the current convex hull.
+    The hull is tracked as a doubly linked list with an angular hash for
+    locating a visible hull edge, and the triangulation is stored in flat
+    int32 arrays:
+
+        triangles[e]    origin vertex of half-edge e. Half-edges 3t, 3t+1,
+                        3t+2 form triangle t.
+        halfedges[e]    opposite half-edge of e, or -1 on the convex hull.
+*/
+namespace SweepHull {
+
+using namespace dcel;
+
+struct Triangulation {
+    std::vector<int32_t> triangles;
+    std::vector<int32_t> halfedges;
+    std::vector<int32_t> hull;
+};
+
+Triangulation triangulateFlat(std::vector<Point> &points);
+DCEL triangulate(std::vector<Point> &points);
+DCEL toDCEL(std::vector<Point> &points, Triangulation &t);
+
+struct _SweepState {
+    std::vector<Point> *points;
+    Triangulation *triangulation;
+    std::vector<int32_t> hullPrev;
+    std::vector<int32_t> hullNext;
+    std::vector<int32_t> hullTri;
+    std::vector<int32_t> hullHash;
+    std::vector<int32_t> edgeStack;
+    int32_t hullStart = -1;
+    Point center;
+};
+
+bool _findSeedTriangle(std::vector<Point> &points,
+                       int32_t *i0, int32_t *i1, int32_t *i2);
+int32_t _hashKey(_SweepState &s, Point &p);
+int32_t _addTriangle(_SweepState &s, int32_t i0, int32_t i1, int32_t i2,
+                     int32_t a, int32_t b, int32_t c);
+void _link(_SweepState &s, int32_t a, int32_t b);
+int32_t _legalize(_SweepState &s, int32_t a);
+bool _isCounterClockwise(Point &p, Point &q, Point &r);
+bool _isInCircle(Point &a, Point &b, Point &c, Point &p);
+double _circumradiusSquared(Point &a, Point &b, Point &c);
+Point _circumcenter(Point &a, Point &b, Point &c);
+
+}
+
+#endif
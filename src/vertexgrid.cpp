@@ -0,0 +1,194 @@
+#include "vertexgrid.h"
+
+#include <math.h>
+#include <algorithm>
+
+gen::VertexGrid::VertexGrid(std::vector<dcel::Vertex> &vertices, int verticesPerCell) {
+    _initializeGrid(vertices, verticesPerCell);
+}
+
+int gen::VertexGrid::getVertexCount() {
+    return (int)_x.size();
+}
+
+int gen::VertexGrid::getCellCount() {
+    return _cells.size();
+}
+
+gen::IndexRange gen::VertexGrid::getCell(int c) {
+    return _cells[c];
+}
+
+int gen::VertexGrid::getCellOffset(int c) {
+    return _cells.offsets[c];
+}
+
+Extents2d gen::VertexGrid::getCellExtents(int c) {
+    return _cellExtents[c];
+}
+
+const double* gen::VertexGrid::getX() {
+    return _x.data();
+}
+
+const double* gen::VertexGrid::getY() {
+    return _y.data();
+}
+
+bool gen::VertexGrid::isCellInDisc(int c, double px, double py, double rsq) {
+    Extents2d &e = _cellExtents[c];
+    double dx = 0.0;
+    if (px < e.minx) {
+        dx = e.minx - px;
+    } else if (px > e.maxx) {
+        dx = px - e.maxx;
+    }
+
+    double dy = 0.0;
+    if (py < e.miny) {
+        dy = e.miny - py;
+    } else if (py > e.maxy) {
+        dy = py - e.maxy;
+    }
+
+    return dx*dx + dy*dy < rsq;
+}
+
+void gen::VertexGrid::getVerticesInDisc(double px, double py, double r,
+                                        std::vector<int> &indices) {
+    if (_isize == 0) {
+        return;
+    }
+
+    int mini = std::max(0, (int)floor((px - r - _extents.minx) / _dx));
+    int minj = std::max(0, (int)floor((py - r - _extents.miny) / _dx));
+    int maxi = std::min(_isize - 1, (int)floor((px + r - _extents.minx) / _dx));
+    int maxj = std::min(_jsize - 1, (int)floor((py + r - _extents.miny) / _dx));
+    double rsq = r*r;
+    for (int j = minj; j <= maxj; j++) {
+        for (int i = mini; i <= maxi; i++) {
+            int c = i + j*_isize;
+            if (!isCellInDisc(c, px, py, rsq)) {
+                continue;
+            }
+
+            int offset = _cells.offsets[c];
+            IndexRange cell = _cells[c];
+            for (int k = 0; k < cell.size(); k++) {
+                double dx = _x[offset + k] - px;
+                double dy = _y[offset + k] - py;
+                if (dx*dx + dy*dy < rsq) {
+                    indices.push_back(cell[k]);
+                }
+            }
+        }
+    }
+}
+
+void gen::VertexGrid::getVerticesInExtents(Extents2d extents, std::vector<int> &indices) {
+    if (_isize == 0) {
+        return;
+    }
+
+    int mini = std::max(0, (int)floor((extents.minx - _extents.minx) / _dx));
+    int minj = std::max(0, (int)floor((extents.miny - _extents.miny) / _dx));
+    int maxi = std::min(_isize - 1, (int)floor((extents.maxx - _extents.minx) / _dx));
+    int maxj = std::min(_jsize - 1, (int)floor((extents.maxy - _extents.miny) / _dx));
+    for (int j = minj; j <= maxj; j++) {
+        for (int i = mini; i <= maxi; i++) {
+            int c = i + j*_isize;
+            int offset = _cells.offsets[c];
+            IndexRange cell = _cells[c];
+            for (int k = 0; k < cell.size(); k++) {
+                if (extents.containsPoint(_x[offset + k], _y[offset + k])) {
+                    indices.push_back(cell[k]);
+                }
+            }
+        }
+    }
+}
+
+size_t gen::VertexGrid::getMemoryUsage() {
+    return _cells.getMemoryUsage() +
+           _x.capacity() * sizeof(double) + _y.capacity() * sizeof(double) +
+           _cellExtents.capacity() * sizeof(Extents2d);
+}
+
+/*
+    The cell size is chosen so that cells hold about verticesPerCell
+    vertices when the vertices are evenly distributed over their bounds.
+*/
+void gen::VertexGrid::_initializeGrid(std::vector<dcel::Vertex> &vertices,
+                                      int verticesPerCell) {
+    if (vertices.empty()) {
+        return;
+    }
+
+    _extents = Extents2d(vertices[0].position.x, vertices[0].position.y,
+                         vertices[0].position.x, vertices[0].position.y);
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        dcel::Point p = vertices[i].position;
+        _extents.minx = std::min(_extents.minx, p.x);
+        _extents.miny = std::min(_extents.miny, p.y);
+        _extents.maxx = std::max(_extents.maxx, p.x);
+        _extents.maxy = std::max(_extents.maxy, p.y);
+    }
+
+    double width = _extents.maxx - _extents.minx;
+    double height = _extents.maxy - _extents.miny;
+    double area = std::max(width * height, 1e-12);
+    _dx = sqrt(area * (double)verticesPerCell / (double)vertices.size());
+    _dx = std::max(_dx, 1e-6);
+    _isize = std::max(1, (int)ceil(width / _dx));
+    _jsize = std::max(1, (int)ceil(height / _dx));
+
+    int ncells = _isize * _jsize;
+    std::vector<int> cellIndex(vertices.size());
+    std::vector<int> counts(ncells, 0);
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        cellIndex[i] = _getCellIndex(vertices[i].position.x, vertices[i].position.y);
+        counts[cellIndex[i]]++;
+    }
+
+    _cells.offsets.assign(ncells + 1, 0);
+    for (int c = 0; c < ncells; c++) {
+        _cells.offsets[c + 1] = _cells.offsets[c] + counts[c];
+    }
+
+    _cells.indices.resize(vertices.size());
+    _x.resize(vertices.size());
+    _y.resize(vertices.size());
+    std::vector<int> next(_cells.offsets.begin(), _cells.offsets.end() - 1);
+    for (unsigned int i = 0; i < vertices.size(); i++) {
+        int k = next[cellIndex[i]]++;
+        _cells.indices[k] = i;
+        _x[k] = vertices[i].position.x;
+        _y[k] = vertices[i].position.y;
+    }
+
+    _cellExtents.resize(ncells);
+    for (int c = 0; c < ncells; c++) {
+        int begin = _cells.offsets[c];
+        int end = _cells.offsets[c + 1];
+        if (begin == end) {
+            continue;
+        }
+
+        Extents2d e(_x[begin], _y[begin], _x[begin], _y[begin]);
+        for (int k = begin + 1; k < end; k++) {
+            e.minx = std::min(e.minx, _x[k]);
+            e.miny = std::min(e.miny, _y[k]);
+            e.maxx = std::max(e.maxx, _x[k]);
+            e.maxy = std::max(e.maxy, _y[k]);
+        }
+        _cellExtents[c] = e;
+    }
+}
+
+int gen::VertexGrid::_getCellIndex(double x, double y) {
+    int i = (int)floor((x - _extents.minx) / _dx);
+    int j = (int)floor((y - _extents.miny) / _dx);
+    i = std::min(std::max(i, 0), _isize - 1);
+    j = std::min(std::max(j, 0), _jsize - 1);
+    return i + j*_isize;
+}
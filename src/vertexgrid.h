@@ -0,0 +1,68 @@
+#ifndef VERTEXGRID_H
+#define VERTEXGRID_H
+
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+
+#include "dcel.h"
+#include "extents2d.h"
+#include "adjacencylist.h"
+
+namespace gen {
+
+/*
+    Uniform grid over vertex positions for radius queries. Each cell holds
+    the indices of the vertices it contains in ascending order, with their
+    positions stored alongside in cell order so that a cell can be swept
+    without touching the vertex array.
+
+    Cell extents are the bounds of the positions in the cell rather than
+    the grid lines, so a cell whose extents do not reach a disc cannot
+    contain a point inside the disc.
+*/
+class VertexGrid {
+
+public:
+    VertexGrid() {}
+    VertexGrid(std::vector<dcel::Vertex> &vertices, int verticesPerCell);
+
+    int getVertexCount();
+    int getCellCount();
+    IndexRange getCell(int c);
+    int getCellOffset(int c);
+    Extents2d getCellExtents(int c);
+    const double* getX();
+    const double* getY();
+
+    // true if cell c may contain a point with squared distance less
+    // than rsq from (px, py)
+    bool isCellInDisc(int c, double px, double py, double rsq);
+
+    // Indices of the vertices with squared distance less than r*r from
+    // (px, py), in cell order
+    void getVerticesInDisc(double px, double py, double r, std::vector<int> &indices);
+
+    // Indices of the vertices inside extents, in cell order
+    void getVerticesInExtents(Extents2d extents, std::vector<int> &indices);
+
+    size_t getMemoryUsage();
+
+private:
+    void _initializeGrid(std::vector<dcel::Vertex> &vertices, int verticesPerCell);
+    int _getCellIndex(double x, double y);
+
+    Extents2d _extents;
+    double _dx = 1.0;
+    int _isize = 0;
+    int _jsize = 0;
+
+    AdjacencyList _cells;               // cell -> vertex indices
+    std::vector<double> _x;             // position of each cell entry
+    std::vector<double> _y;
+    std::vector<Extents2d> _cellExtents;
+};
+
+}
+
+#endif
@@ -2,24 +2,25 @@
 
 gen::VertexMap::VertexMap() {}
 
-gen::VertexMap::VertexMap(dcel::DCEL *V, Extents2d extents) :
-                        _dcel(V), _extents(extents) {
-    vertices.reserve(_dcel->vertices.size());
-    interior.reserve(_dcel->vertices.size());
-    _vertexTypes.reserve(_dcel->vertices.size());
-    _vertexIdToMapIndex = std::vector<int>(_dcel->vertices.size(), -1);
+gen::VertexMap::VertexMap(const dcel::FlatDCEL *mesh, Extents2d extents) :
+                        _mesh(mesh), _extents(extents) {
+    int nv = _mesh->vertexCount();
+    vertices.reserve(nv);
+    interior.reserve(nv);
+    _vertexTypes.reserve(nv);
+    _vertexIdToMapIndex = std::vector<int>(nv, -1);
 
     dcel::Vertex v;
-    for (unsigned int i = 0; i < _dcel->vertices.size(); i++) {
-        v = _dcel->vertices[i];
-        if (!extents.containsPoint(v.position) || _isBoundaryVertex(v)) {
+    for (int i = 0; i < nv; i++) {
+        v = _getVertex(i);
+        if (!extents.containsPoint(v.position) || _isBoundaryVertex(i)) {
             continue;
         }
 
         vertices.push_back(v);
-        _vertexIdToMapIndex[v.id.ref] = vertices.size() - 1;
+        _vertexIdToMapIndex[i] = vertices.size() - 1;
 
-        if (_getVertexType(v) == VertexType::interior) {
+        if (_getVertexType(i) == VertexType::interior) {
             interior.push_back(v);
             _vertexTypes.push_back(VertexType::interior);
         } else {
@@ -35,35 +36,31 @@ unsigned int gen::VertexMap::size() {
 
 void gen::VertexMap::getNeighbours(dcel::Vertex v, 
                                    std::vector<dcel::Vertex> &nbs) {
-    dcel::HalfEdge h = _dcel->incidentEdge(v);
-    dcel::Ref startRef = h.id;
+    int h = _mesh->incidentEdge(v.id.ref);
+    int startRef = h;
 
-    dcel::HalfEdge twin;
-    dcel::Vertex n;
     do {
-        twin = _dcel->twin(h);
-        n = _dcel->origin(twin);
+        int twin = _mesh->twin(h);
+        int n = _mesh->origin(twin);
         if (isVertex(n)) {
-            nbs.push_back(n);
+            nbs.push_back(_getVertex(n));
         }
-        h = _dcel->next(twin);
-    } while (h.id != startRef);
+        h = _mesh->next(twin);
+    } while (h != startRef);
 }
 
 void gen::VertexMap::getNeighbourIndices(dcel::Vertex v, std::vector<int> &nbs) {
-    dcel::HalfEdge h = _dcel->incidentEdge(v);
-    dcel::Ref startRef = h.id;
+    int h = _mesh->incidentEdge(v.id.ref);
+    int startRef = h;
 
-    dcel::HalfEdge twin;
-    dcel::Vertex n;
     do {
-        twin = _dcel->twin(h);
-        n = _dcel->origin(twin);
+        int twin = _mesh->twin(h);
+        int n = _mesh->origin(twin);
         if (isVertex(n)) {
             nbs.push_back(getVertexIndex(n));
         }
-        h = _dcel->next(twin);
-    } while (h.id != startRef);
+        h = _mesh->next(twin);
+    } while (h != startRef);
 }
 
 int gen::VertexMap::getVertexIndex(dcel::Vertex &v) {
@@ -80,6 +77,18 @@ bool gen::VertexMap::isVertex(dcel::Vertex &v) {
     return getVertexIndex(v) != -1;
 }
 
+// Map index of the DCEL vertex with the given id, or -1
+int gen::VertexMap::getVertexIndex(int vertexId) {
+    if (!_isInRange(vertexId)) {
+        return -1;
+    }
+    return _vertexIdToMapIndex[vertexId];
+}
+
+bool gen::VertexMap::isVertex(int vertexId) {
+    return getVertexIndex(vertexId) != -1;
+}
+
 bool gen::VertexMap::isEdge(dcel::Vertex &v) {
     if (!_isInRange(v.id.ref)) {
         return false;
@@ -94,45 +103,49 @@ bool gen::VertexMap::isInterior(dcel::Vertex &v) {
     return _vertexTypes[getVertexIndex(v)] == VertexType::interior;
 }
 
-bool gen::VertexMap::_isBoundaryVertex(dcel::Vertex &v) {
-    if (v.incidentEdge.ref == -1) {
+dcel::Vertex gen::VertexMap::_getVertex(int id) {
+    dcel::Vertex v(_mesh->vertexX[id], _mesh->vertexY[id]);
+    v.incidentEdge = dcel::Ref(_mesh->incidentEdge(id));
+    v.id = dcel::Ref(id);
+    return v;
+}
+
+bool gen::VertexMap::_isBoundaryVertex(int id) {
+    int h = _mesh->incidentEdge(id);
+    if (h == -1) {
         return true;
     }
 
-    dcel::HalfEdge h = _dcel->incidentEdge(v);
-    dcel::Ref startid = h.id;
-
+    int startid = h;
     do {
-        if (h.incidentFace.ref == -1) {
+        if (_mesh->incidentFace(h) == -1) {
             return true;
         }
 
-        h = _dcel->twin(h);
-        if (h.next.ref == -1) {
+        h = _mesh->twin(h);
+        if (_mesh->next(h) == -1) {
             return true;
         }
 
-        h = _dcel->next(h);
-    } while (h.id != startid);
+        h = _mesh->next(h);
+    } while (h != startid);
 
     return false;
 }
 
-gen::VertexType gen::VertexMap::_getVertexType(dcel::Vertex &v) {
-    dcel::HalfEdge h = _dcel->incidentEdge(v);
-    dcel::Ref startRef = h.id;
+gen::VertexType gen::VertexMap::_getVertexType(int id) {
+    int h = _mesh->incidentEdge(id);
+    int startRef = h;
 
-    dcel::HalfEdge twin;
-    dcel::Vertex n;
     int ncount = 0;
     do {
-        twin = _dcel->twin(h);
-        n = _dcel->origin(twin);
-        if (_extents.containsPoint(n.position) && !_isBoundaryVertex(n)) {
+        int twin = _mesh->twin(h);
+        int n = _mesh->origin(twin);
+        if (_extents.containsPoint(_mesh->position(n)) && !_isBoundaryVertex(n)) {
             ncount++;
         }
-        h = _dcel->next(twin);
-    } while (h.id != startRef);
+        h = _mesh->next(twin);
+    } while (h != startRef);
 
     if (ncount < 3) {
         return VertexType::edge;
@@ -7,6 +7,7 @@
 
 #include "extents2d.h"
 #include "dcel.h"
+#include "flatdcel.h"
 
 #include "cereal/cereal.hpp"
 #include "cereal/types/common.hpp"
@@ -22,13 +23,15 @@ class VertexMap {
 
 public:
     VertexMap();
-    VertexMap(dcel::DCEL *V, Extents2d extents);
+    VertexMap(const dcel::FlatDCEL *mesh, Extents2d extents);
 
     unsigned int size();
     void getNeighbours(dcel::Vertex v, std::vector<dcel::Vertex> &nbs);
     void getNeighbourIndices(dcel::Vertex v, std::vector<int> &nbs);
     int getVertexIndex(dcel::Vertex &v);
+    int getVertexIndex(int vertexId);
     bool isVertex(dcel::Vertex &v);
+    bool isVertex(int vertexId);
     bool isEdge(dcel::Vertex &v);
     bool isInterior(dcel::Vertex &v);
 
@@ -42,11 +45,12 @@ public:
 	}
 
 private:
-	bool _isBoundaryVertex(dcel::Vertex &v);
+	dcel::Vertex _getVertex(int id);
+	bool _isBoundaryVertex(int id);
 	bool _isInRange(int id);
-    VertexType _getVertexType(dcel::Vertex &v);
+    VertexType _getVertexType(int id);
 
-	dcel::DCEL *_dcel;
+	const dcel::FlatDCEL *_mesh;
 	Extents2d _extents;
 	std::vector<int> _vertexIdToMapIndex;
 	std::vector<VertexType> _vertexTypes;
@@ -64,19 +64,27 @@ dcel::Point Voronoi::_computeVoronoiVertex(dcel::DCEL &T, dcel::Face &f) {
     Point pi = T.origin(T.next(h)).position;
     Point pj = T.origin(T.prev(h)).position;
 
-    Point p(0.5*(pi.x + pj.x), 0.5*(pi.y + pj.y));
-    Point r(-(pj.y - pi.y), pj.x - pi.x);
-
-    Point q(0.5*(pi.x + p0.x), 0.5*(pi.y + p0.y));
-    Point s(-(p0.y - pi.y), p0.x - pi.x);
+    // Circumcenter relative to p0, divided by the exact orientation so that
+    // the denominator is zero only for collinear points
+    double det = Geometry::orient2d(p0, pi, pj);
+    if (det == 0.0) {
+        // Degenerate triangle
+        return p0;
+    }
 
-    Point center;
-    bool isIntersection = Geometry::lineIntersection(p, r, q, s, &center);
-    if (!isIntersection) {
+    double dx = pi.x - p0.x;
+    double dy = pi.y - p0.y;
+    double ex = pj.x - p0.x;
+    double ey = pj.y - p0.y;
+    double dd = dx*dx + dy*dy;
+    double ee = ex*ex + ey*ey;
+    double ux = (ey*dd - dy*ee) / (2.0*det);
+    double uy = (dx*ee - ex*dd) / (2.0*det);
+    if (!std::isfinite(ux) || !std::isfinite(uy)) {
         return p0;
     }
 
-    return center;
+    return Point(p0.x + ux, p0.y + uy);
 }
 
 bool Voronoi::_isBoundaryVertex(dcel::DCEL &T, dcel::Vertex &v) {
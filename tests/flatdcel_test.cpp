@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "dcel.h"
+#include "flatdcel.h"
+#include "sweephull.h"
+#include "voronoi.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    }
+
+dcel::DCEL getVoronoi(int numPoints) {
+    srand(1);
+    std::vector<dcel::Point> points;
+    for (int i = 0; i < numPoints; i++) {
+        double x = 20.0 * (double)rand() / (double)RAND_MAX;
+        double y = 10.0 * (double)rand() / (double)RAND_MAX;
+        points.push_back(dcel::Point(x, y));
+    }
+
+    dcel::DCEL triangulation = SweepHull::triangulate(points);
+    return Voronoi::delaunayToVoronoi(triangulation);
+}
+
+// Faces walk the same vertices in both layouts
+void testFaceVertices(dcel::FlatDCEL &full, dcel::FlatDCEL &compact) {
+    CHECK(full.faceCount() == compact.faceCount());
+    for (int i = 0; i < full.faceCount() && i < compact.faceCount(); i++) {
+        CHECK((full.outerComponent(i) == -1) == (compact.outerComponent(i) == -1));
+        if (full.outerComponent(i) == -1 || compact.outerComponent(i) == -1) {
+            continue;
+        }
+
+        std::vector<int> fullEdges, compactEdges;
+        full.getOuterComponents(i, fullEdges);
+        compact.getOuterComponents(i, compactEdges);
+        CHECK(fullEdges.size() == compactEdges.size());
+        for (unsigned int j = 0; j < fullEdges.size() && j < compactEdges.size(); j++) {
+            CHECK(full.origin(fullEdges[j]) == compact.origin(compactEdges[j]));
+            CHECK(compact.incidentFace(compactEdges[j]) == i);
+        }
+    }
+}
+
+// Twins are implicit, prev is derived and toFullLayout() stores both
+void testCompactEdges(dcel::FlatDCEL &compact) {
+    CHECK(compact.getLayout() == dcel::MeshLayout::compact);
+    CHECK(compact.edgeTwin == nullptr && compact.edgePrev == nullptr);
+
+    dcel::FlatDCEL expanded = compact.toFullLayout();
+    CHECK(expanded.getLayout() == dcel::MeshLayout::full);
+    CHECK(expanded.edgeCount() == compact.edgeCount());
+    for (int h = 0; h < compact.edgeCount(); h++) {
+        CHECK(compact.twin(h) == (h ^ 1));
+        CHECK(expanded.twin(h) == compact.twin(h));
+        CHECK(expanded.prev(h) == compact.prev(h));
+        if (compact.next(h) != -1) {
+            CHECK(compact.prev(compact.next(h)) == h);
+            CHECK(compact.origin(compact.next(h)) == compact.origin(compact.twin(h)));
+        }
+    }
+
+    for (int v = 0; v < compact.vertexCount(); v++) {
+        int h = compact.incidentEdge(v);
+        CHECK(h == -1 || compact.origin(h) == v);
+    }
+}
+
+void testMemoryUsage(dcel::FlatDCEL &full, dcel::FlatDCEL &compact) {
+    CHECK(full.getMemoryUsage() == full.getMemoryUsage(dcel::MeshLayout::full));
+    CHECK(compact.getMemoryUsage() == compact.getMemoryUsage(dcel::MeshLayout::compact));
+    CHECK(full.getMemoryUsage(dcel::MeshLayout::compact) == compact.getMemoryUsage());
+    CHECK(compact.getMemoryUsage() < full.getMemoryUsage());
+}
+
+int main() {
+    dcel::DCEL voronoi = getVoronoi(500);
+    dcel::FlatDCEL full(voronoi);
+    dcel::FlatDCEL compact(voronoi, dcel::MeshLayout::compact);
+
+    testFaceVertices(full, compact);
+    testCompactEdges(compact);
+    testMemoryUsage(full, compact);
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <vector>
+
+#include "nodemapkernels.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    }
+
+// Reductions of an empty array return T() without reading the array
+void testEmpty() {
+    const double *nodes = nullptr;
+    CHECK(NodeMapKernels::getMin(nodes, 0) == 0.0);
+    CHECK(NodeMapKernels::getMax(nodes, 0) == 0.0);
+
+    double minval = 1.0, maxval = 1.0;
+    NodeMapKernels::getMinMax(nodes, 0, &minval, &maxval);
+    CHECK(minval == 0.0 && maxval == 0.0);
+
+    const float *fnodes = nullptr;
+    CHECK(NodeMapKernels::getMin(fnodes, 0) == 0.0f);
+    CHECK(NodeMapKernels::getMax(fnodes, 0) == 0.0f);
+
+    float fmin = 1.0f, fmax = 1.0f;
+    NodeMapKernels::getMinMax(fnodes, 0, &fmin, &fmax);
+    CHECK(fmin == 0.0f && fmax == 0.0f);
+
+    std::vector<double> empty;
+    NodeMapKernels::normalize(empty.data(), 0, minval, maxval);
+}
+
+// Sizes below, at and above the vectorized block sizes
+void testReductions() {
+    for (int n = 1; n <= 37; n++) {
+        std::vector<double> x(n);
+        for (int i = 0; i < n; i++) {
+            x[i] = (double)((i * 7919) % 37) - 18.0;
+        }
+
+        double expectedMin = x[0], expectedMax = x[0];
+        for (int i = 1; i < n; i++) {
+            expectedMin = x[i] < expectedMin ? x[i] : expectedMin;
+            expectedMax = x[i] > expectedMax ? x[i] : expectedMax;
+        }
+
+        double minval, maxval;
+        NodeMapKernels::getMinMax(x.data(), n, &minval, &maxval);
+        CHECK(NodeMapKernels::getMin(x.data(), n) == expectedMin);
+        CHECK(NodeMapKernels::getMax(x.data(), n) == expectedMax);
+        CHECK(minval == expectedMin && maxval == expectedMax);
+    }
+}
+
+int main() {
+    testEmpty();
+    testReductions();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
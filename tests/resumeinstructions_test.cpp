@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "mapgenerator.h"
+#include "mapinstruction.h"
+#include "extents2d.h"
+#include "cereal/archives/json.hpp"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        failures++; \
+    }
+
+static const unsigned int seed = 12345;
+
+void writeInstructionFile(std::string filename, std::vector<gen::MapInstruction> instructions) {
+    std::ofstream file(filename);
+    {
+        cereal::JSONOutputArchive oarchive(file);
+        oarchive(CEREAL_NVP(instructions));
+    }
+}
+
+std::vector<char> readFile(std::string filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+}
+
+gen::MapInstruction noise(double frequency) {
+    return gen::MapInstruction("addNoise", {frequency, 0.5, 0.0});
+}
+
+std::vector<gen::MapInstruction> getProgram() {
+    std::vector<gen::MapInstruction> program;
+    program.push_back(noise(2.0));
+    program.push_back(gen::MapInstruction("addCone", {10.0, 5.0, 4.0, 1.0, 0.0}));
+    program.push_back(gen::MapInstruction("makeContinent", {}));
+    program.push_back(noise(4.0));
+    return program;
+}
+
+// The edited program draws one more random value than the original program
+std::vector<gen::MapInstruction> getEditedProgram() {
+    std::vector<gen::MapInstruction> program = getProgram();
+    program.insert(program.begin() + 1, noise(8.0));
+    return program;
+}
+
+gen::MapGenerator *createMap() {
+    srand(seed);
+    gen::MapGenerator *map = new gen::MapGenerator(Extents2d(0, 0, 20, 10), 0.4);
+    map->initialize();
+    map->setCheckpointInterval(1, 0.0);
+    return map;
+}
+
+// A resumed program matches the edited program performed from the same
+// seed, also after rand() is used and reseeded between the two programs
+void testResumeAddedNoise() {
+    writeInstructionFile("resume_program.json", getProgram());
+    writeInstructionFile("resume_edited.json", getEditedProgram());
+
+    gen::MapGenerator *resumed = createMap();
+    resumed->readInstructionFile("resume_program.json");
+    resumed->performInstructions();
+    for (int i = 0; i < 100; i++) {
+        rand();
+    }
+    srand(seed);
+    resumed->readInstructionFile("resume_edited.json");
+    int startIndex = resumed->resumeInstructions();
+    CHECK(startIndex == 1);
+    resumed->outputHeightMap("resume_resumed.bin");
+    delete resumed;
+
+    gen::MapGenerator *fresh = createMap();
+    fresh->readInstructionFile("resume_edited.json");
+    fresh->performInstructions();
+    fresh->outputHeightMap("resume_fresh.bin");
+    delete fresh;
+
+    std::vector<char> resumedHeights = readFile("resume_resumed.bin");
+    std::vector<char> freshHeights = readFile("resume_fresh.bin");
+    CHECK(!freshHeights.empty());
+    CHECK(resumedHeights == freshHeights);
+
+    remove("resume_program.json");
+    remove("resume_edited.json");
+    remove("resume_resumed.bin");
+    remove("resume_fresh.bin");
+}
+
+int main() {
+    testResumeAddedNoise();
+
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}